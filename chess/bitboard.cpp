@@ -0,0 +1,82 @@
+#include "bitboard.h"
+
+// The tables are computed by the compiler, i.e. they are constant
+// initialized and can be used during the dynamic initialization
+// of other translation units, too
+
+// file and rank steps of the ray directions, same order as RAY_NORTH ...
+static constexpr int RAY_STEPS[8][2] = {
+    { 0, 1 }, { 1, 1 }, { 1, 0 }, { -1, 1 }, { 0, -1 }, { -1, -1 }, { -1, 0 }, { 1, -1 }
+};
+
+static constexpr chess::Bitboard squareAt(int file, int rank) {
+    return (file < 0 || file > 7 || rank < 0 || rank > 7) ? 0 : chess::Bitboard(1) << (rank * 8 + file);
+}
+
+static constexpr int8_t square64(int idx) {
+    return (idx % 10 < 1 || idx % 10 > 8 || idx / 10 < 2 || idx / 10 > 9) ? -1 : (idx / 10 - 2) * 8 + idx % 10 - 1;
+}
+
+static constexpr uint8_t square120(int sq) {
+    return (sq / 8 + 2) * 10 + sq % 8 + 1;
+}
+
+static constexpr chess::Bitboard knightAttacks(int sq) {
+    return squareAt(sq % 8 + 1, sq / 8 + 2) | squareAt(sq % 8 + 2, sq / 8 + 1)
+            | squareAt(sq % 8 + 2, sq / 8 - 1) | squareAt(sq % 8 + 1, sq / 8 - 2)
+            | squareAt(sq % 8 - 1, sq / 8 - 2) | squareAt(sq % 8 - 2, sq / 8 - 1)
+            | squareAt(sq % 8 - 2, sq / 8 + 1) | squareAt(sq % 8 - 1, sq / 8 + 2);
+}
+
+static constexpr chess::Bitboard kingAttacks(int sq) {
+    return squareAt(sq % 8, sq / 8 + 1) | squareAt(sq % 8 + 1, sq / 8 + 1)
+            | squareAt(sq % 8 + 1, sq / 8) | squareAt(sq % 8 + 1, sq / 8 - 1)
+            | squareAt(sq % 8, sq / 8 - 1) | squareAt(sq % 8 - 1, sq / 8 - 1)
+            | squareAt(sq % 8 - 1, sq / 8) | squareAt(sq % 8 - 1, sq / 8 + 1);
+}
+
+// color 0 is WHITE, 1 is BLACK
+static constexpr chess::Bitboard pawnAttacks(int color, int sq) {
+    return squareAt(sq % 8 - 1, sq / 8 + (color == 0 ? 1 : -1))
+            | squareAt(sq % 8 + 1, sq / 8 + (color == 0 ? 1 : -1));
+}
+
+// all squares from (file, rank) on to the edge of the board
+static constexpr chess::Bitboard rayFrom(int file, int rank, int fileStep, int rankStep) {
+    return squareAt(file, rank) == 0 ? 0
+            : squareAt(file, rank) | rayFrom(file + fileStep, rank + rankStep, fileStep, rankStep);
+}
+
+static constexpr chess::Bitboard ray(int direction, int sq) {
+    return rayFrom(sq % 8 + RAY_STEPS[direction][0], sq / 8 + RAY_STEPS[direction][1],
+                   RAY_STEPS[direction][0], RAY_STEPS[direction][1]);
+}
+
+// table initializers: f(i), f(i + 1), ..., resp. f(a, i), f(a, i + 1), ...
+#define TABLE_8(f, i) f(i), f(i + 1), f(i + 2), f(i + 3), f(i + 4), f(i + 5), f(i + 6), f(i + 7)
+#define TABLE_64(f) TABLE_8(f, 0), TABLE_8(f, 8), TABLE_8(f, 16), TABLE_8(f, 24), \
+    TABLE_8(f, 32), TABLE_8(f, 40), TABLE_8(f, 48), TABLE_8(f, 56)
+#define TABLE_120(f) TABLE_64(f), TABLE_8(f, 64), TABLE_8(f, 72), TABLE_8(f, 80), \
+    TABLE_8(f, 88), TABLE_8(f, 96), TABLE_8(f, 104), TABLE_8(f, 112)
+#define TABLE_8_OF(f, a, i) f(a, i), f(a, i + 1), f(a, i + 2), f(a, i + 3), \
+    f(a, i + 4), f(a, i + 5), f(a, i + 6), f(a, i + 7)
+#define TABLE_64_OF(f, a) { TABLE_8_OF(f, a, 0), TABLE_8_OF(f, a, 8), TABLE_8_OF(f, a, 16), \
+    TABLE_8_OF(f, a, 24), TABLE_8_OF(f, a, 32), TABLE_8_OF(f, a, 40), TABLE_8_OF(f, a, 48), \
+    TABLE_8_OF(f, a, 56) }
+
+namespace chess {
+
+constexpr int8_t SQUARE_64[120] = { TABLE_120(square64) };
+constexpr uint8_t SQUARE_120[64] = { TABLE_64(square120) };
+constexpr Bitboard KNIGHT_ATTACKS[64] = { TABLE_64(knightAttacks) };
+constexpr Bitboard KING_ATTACKS[64] = { TABLE_64(kingAttacks) };
+constexpr Bitboard PAWN_ATTACKS[2][64] = {
+    TABLE_64_OF(pawnAttacks, 0), TABLE_64_OF(pawnAttacks, 1)
+};
+constexpr Bitboard RAYS[8][64] = {
+    TABLE_64_OF(ray, RAY_NORTH), TABLE_64_OF(ray, RAY_NORTH_EAST), TABLE_64_OF(ray, RAY_EAST),
+    TABLE_64_OF(ray, RAY_NORTH_WEST), TABLE_64_OF(ray, RAY_SOUTH), TABLE_64_OF(ray, RAY_SOUTH_WEST),
+    TABLE_64_OF(ray, RAY_WEST), TABLE_64_OF(ray, RAY_SOUTH_EAST)
+};
+
+}
@@ -0,0 +1,94 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <cstdint>
+
+namespace chess {
+
+/**
+ * @brief Bitboard a set of squares, one bit per square.
+ *        Bit 0 is A1, bit 1 is B1, ..., bit 63 is H8
+ */
+typedef quint64 Bitboard;
+
+// ray directions of the sliding pieces. For the first four
+// the square number increases along the ray
+const int RAY_NORTH = 0;
+const int RAY_NORTH_EAST = 1;
+const int RAY_EAST = 2;
+const int RAY_NORTH_WEST = 3;
+const int RAY_SOUTH = 4;
+const int RAY_SOUTH_WEST = 5;
+const int RAY_WEST = 6;
+const int RAY_SOUTH_EAST = 7;
+
+/**
+ * @brief SQUARE_64 maps the internal (10x12) board index to the
+ *                  bitboard square (0 ... 63), and the fringe to -1
+ */
+extern const int8_t SQUARE_64[120];
+
+/**
+ * @brief SQUARE_120 maps the bitboard square to the internal board index
+ */
+extern const uint8_t SQUARE_120[64];
+
+extern const Bitboard KNIGHT_ATTACKS[64];
+extern const Bitboard KING_ATTACKS[64];
+
+/**
+ * @brief PAWN_ATTACKS squares attacked by a pawn, indexed
+ *                     by color (WHITE, BLACK) and square
+ */
+extern const Bitboard PAWN_ATTACKS[2][64];
+
+/**
+ * @brief RAYS all squares from a square (exclusive) to the edge
+ *             of the board, indexed by direction and square
+ */
+extern const Bitboard RAYS[8][64];
+
+inline Bitboard square_bb(int square) {
+    return Q_UINT64_C(1) << square;
+}
+
+/**
+ * @brief pop_square removes the lowest square from the set
+ * @return the removed square. The set must not be empty
+ */
+inline int pop_square(Bitboard &b) {
+    int square = qCountTrailingZeroBits(b);
+    b &= b - 1;
+    return square;
+}
+
+/**
+ * @brief ray_attacks squares attacked along one ray, up to and including
+ *                    the first occupied square
+ */
+inline Bitboard ray_attacks(int square, int direction, Bitboard occupied) {
+    Bitboard attacks = RAYS[direction][square];
+    Bitboard blockers = attacks & occupied;
+    if(blockers != 0) {
+        int blocker = direction < RAY_SOUTH ? qCountTrailingZeroBits(blockers)
+                                            : 63 - qCountLeadingZeroBits(blockers);
+        attacks ^= RAYS[direction][blocker];
+    }
+    return attacks;
+}
+
+inline Bitboard bishop_attacks(int square, Bitboard occupied) {
+    return ray_attacks(square, RAY_NORTH_EAST, occupied) | ray_attacks(square, RAY_NORTH_WEST, occupied)
+            | ray_attacks(square, RAY_SOUTH_EAST, occupied) | ray_attacks(square, RAY_SOUTH_WEST, occupied);
+}
+
+inline Bitboard rook_attacks(int square, Bitboard occupied) {
+    return ray_attacks(square, RAY_NORTH, occupied) | ray_attacks(square, RAY_SOUTH, occupied)
+            | ray_attacks(square, RAY_EAST, occupied) | ray_attacks(square, RAY_WEST, occupied);
+}
+
+}
+
+#endif // BITBOARD_H
@@ -310,22 +310,22 @@ Board::Board() {
     this->turn = WHITE;
     for(int i=0;i<120;i++) {
         this->board[i] = EMPTY_POS[i];
-        this->old_board[i] = 0xFF;
     }
     this->castling_rights = 0;
     this->en_passent_target = 0;
     this->halfmove_clock = 0;
     this->fullmove_number = 1;
-    this->undo_available = false;
     this->last_was_null = false;
-    this->prev_halfmove_clock = 0;
-    this->transpositionTable = new QMap<quint64, int>();
-    this->update_transposition_table();
+    this->sync_bitboards();
+    this->history = 0;
+    this->history_ply = 0;
+    this->history_start = 0;
 }
 
 Board::~Board() {
-    this->transpositionTable->clear();
-    delete this->transpositionTable;
+    if(this->history != 0 && !this->history->refs.deref()) {
+        delete this->history;
+    }
 }
 
 Board::Board(Board *b) {
@@ -334,14 +334,14 @@ Board::Board(Board *b) {
     this->en_passent_target = 0;
     this->halfmove_clock = 0;
     this->fullmove_number = 1;
-    this->undo_available = false;
     for(int i=0;i<120;i++) {
         this->board[i] = b->board[i];
     }
     this->last_was_null = false;
-    this->prev_halfmove_clock = 0;
-    this->transpositionTable = new QMap<quint64, int>();
-    this->update_transposition_table();
+    this->sync_bitboards();
+    this->history = 0;
+    this->history_ply = 0;
+    this->history_start = 0;
 }
 
 Board::Board(bool initial_position) {
@@ -349,8 +349,7 @@ Board::Board(bool initial_position) {
     if(initial_position) {
         for(int i=0;i<120;i++) {
             this->board[i] = chess::INIT_POS[i];
-            this->old_board[i] = 0xFF;
-        }
+            }
         this->castling_rights = 0x0F;
     } else {
         for(int i=0;i<120;i++) {
@@ -361,11 +360,11 @@ Board::Board(bool initial_position) {
     this->en_passent_target = 0;
     this->halfmove_clock = 0;
     this->fullmove_number = 1;
-    this->undo_available = false;
     this->last_was_null = false;
-    this->prev_halfmove_clock = 0;
-    this->transpositionTable = new QMap<quint64, int>();
-    this->update_transposition_table();
+    this->sync_bitboards();
+    this->history = 0;
+    this->history_ply = 0;
+    this->history_start = 0;
 }
 
 bool Board::is_initial_position() {
@@ -389,7 +388,7 @@ bool Board::is_initial_position() {
     if(this->fullmove_number != 1) {
         return false;
     }
-    if(this->undo_available) {
+    if(!this->undo_stack.isEmpty()) {
         return false;
     }
     return true;
@@ -448,7 +447,7 @@ void Board::set_piece_at(int x, int y, uint8_t piece) {
             ((piece >= 0x01 && piece <= 0x06) ||
              (piece >= 0x81 && piece <= 0x86) || (piece == 0x00))) {
         int idx = ((y+2)*10) + (x+1);
-        this->board[idx] = piece;
+        this->set_square(idx, piece);
     } else {
         throw std::invalid_argument("called set_piece_at with invalid paramters");
     }
@@ -531,165 +530,240 @@ QChar Board::piece_to_symbol(uint8_t piece) {
 }
 
 Board::Board(const QString &fen_string) {
+    QByteArray fen = fen_string.toLatin1();
+    this->parse_fen(fen.constData(), fen.size());
+}
 
-    for(int i=0;i<120;i++) {
-        this->board[i] = EMPTY_POS[i];
-        this->old_board[i] = 0xFF;
+Board::Board(const char *fen, int length) {
+    this->parse_fen(fen, length);
+}
+
+static uint8_t fen_piece(char c) {
+    switch(c) {
+    case 'P': return WHITE_PAWN;
+    case 'N': return WHITE_KNIGHT;
+    case 'B': return WHITE_BISHOP;
+    case 'R': return WHITE_ROOK;
+    case 'Q': return WHITE_QUEEN;
+    case 'K': return WHITE_KING;
+    case 'p': return BLACK_PAWN;
+    case 'n': return BLACK_KNIGHT;
+    case 'b': return BLACK_BISHOP;
+    case 'r': return BLACK_ROOK;
+    case 'q': return BLACK_QUEEN;
+    case 'k': return BLACK_KING;
+    default: return EMPTY;
     }
+}
 
-    // check that we have six parts in fen, each separated by space
-    QStringList fen_parts = fen_string.split(QChar(' '));
-    if(fen_parts.size() != 6) {
-        throw std::invalid_argument("fen: not 6 fen parts");
+// reads a non-negative decimal number that spans the
+// whole part, returns -1 if it isn't one (or too large)
+static int fen_number(const char *part, int length) {
+    if(length < 1 || length > 9) {
+        return -1;
+    }
+    int number = 0;
+    for(int i=0;i<length;i++) {
+        if(part[i] < '0' || part[i] > '9') {
+            return -1;
+        }
+        number = number * 10 + (part[i] - '0');
+    }
+    return number;
+}
+
+// castling right for a file of a Shredder-FEN or X-FEN: 1 for the king
+// side and -1 for the queen side, if the file holds the outermost rook
+// on that side of the king. 0 if there is no such rook
+static int fen_castling_side(const uint8_t *board, int back_rank, uint8_t king, uint8_t rook, int file) {
+    int king_file = -1;
+    for(int i=0;i<8;i++) {
+        if(board[back_rank + i] == king) {
+            king_file = i;
+        }
     }
-    // check that the first part consists of 8 rows, each sep. by /
-    QStringList rows = fen_parts.at(0).split(QChar('/'));
-    if(rows.size() != 8) {
-        throw std::invalid_argument("fen: not 8 rows in 0th part");
+    if(king_file < 0 || file == king_file || board[back_rank + file] != rook) {
+        return 0;
     }
-    // check that in each row, there are no two consecutive digits
-    for(int i=0;i<rows.size();i++) {
-        QString row = rows.at(i);
+    int side = file > king_file ? 1 : -1;
+    for(int i=file+side;i>=0 && i<8;i+=side) {
+        if(board[back_rank + i] == rook) {
+            return 0;
+        }
+    }
+    return side;
+}
+
+// parses and validates the fen byte by byte, without
+// splitting it into strings or matching regular expressions
+void Board::parse_fen(const char *fen, int length) {
+
+    this->castling_rights = 0;
+    this->zobrist_key = 0;
+    this->history = 0;
+    this->history_ply = 0;
+    this->history_start = 0;
+
+    for(int i=0;i<120;i++) {
+        this->board[i] = EMPTY_POS[i];
+    }
+
+    // the first part consists of 8 rows, each sep. by /
+    const char *c = fen;
+    const char *end = fen + length;
+    for(int i=0;i<8;i++) {
+        if(i > 0) {
+            if(c == end || *c != '/') {
+                throw std::invalid_argument("fen: not 8 rows in 0th part");
+            }
+            c++;
+        }
+        int square_index = 91 - (i*10);
         int field_sum = 0;
         bool previous_was_digit = false;
-        for(int j=0;j<row.size();j++) {
-            QChar rj = row.at(j);
-            QChar rjl = rj.toLower();
-            if(rj == QChar('1') || rj == QChar('2') || rj == QChar('3') || rj == QChar('4')
-                    || rj == QChar('5') || rj == QChar('6') || rj == QChar('7') || rj == QChar('8')) {
+        for(;c != end && *c != '/' && *c != ' ';c++) {
+            if(*c >= '1' && *c <= '8') {
+                // there must be no two consecutive digits
                 if(previous_was_digit) {
                     throw std::invalid_argument("fen: two consecutive digits in rows");
-                } else {
-                    field_sum += rj.digitValue();
-                    previous_was_digit = true;
                 }
-            } else if(rjl == QChar('p') || rjl == QChar('n') || rjl == QChar('b')
-                      || rjl == QChar('r') || rjl == QChar('q') || rjl == QChar('k')) {
+                field_sum += *c - '0';
+                previous_was_digit = true;
+            } else {
+                uint8_t piece = fen_piece(*c);
+                if(piece == EMPTY) {
+                    throw std::invalid_argument("fen: invalid character in rows");
+                }
+                if(field_sum < 8) {
+                    this->board[square_index + field_sum] = piece;
+                }
                 field_sum += 1;
                 previous_was_digit = false;
-            } else {
-                throw std::invalid_argument("fen: two consecutive chars in rows");
+            }
+            if(field_sum > 8) {
+                throw std::invalid_argument("fen: field sum is not 8");
             }
         }
-        // validate that there are 8 alphanums in each row
+        // validate that there are 8 squares in each row
         if(field_sum != 8) {
             throw std::invalid_argument("fen: field sum is not 8");
         }
     }
-    // check that turn part is valid
-    if(!(fen_parts.at(1) == QString("w") || fen_parts.at(1) == QString("b"))) {
-        throw std::invalid_argument("turn part is invalid");
-    }
-    // check that castles part in correctly encoded using regex
-    QRegularExpressionMatch match = FEN_CASTLES_REGEX.match(fen_parts[2]);
-    if(!match.hasMatch()) {
-        throw std::invalid_argument("castles encoding is invalid");
-    }
-    // check correct encoding of en passent squares
-    if(fen_parts.at(3) != QChar('-')) {
-        if(fen_parts.at(1) == QChar('w')) {
-            // should be something like "e6" etc. if white is to move
-            // check that int value part is sixth rank
-            if(fen_parts.at(3).size() != 2 || fen_parts.at(3).at(1) != QChar('6')) {
-                throw std::invalid_argument("invalid e.p. encoding (white to move)");
-            }
-        } else {
-            if(fen_parts.at(3).size() != 2 || fen_parts.at(3).at(1) != QChar('3')) {
-                throw std::invalid_argument("invalid e.p. encoding (black to move)");
-            }
+
+    // the remaining five parts, each separated by a single space
+    const char *parts[5];
+    int part_lengths[5];
+    for(int i=0;i<5;i++) {
+        if(c == end || *c != ' ') {
+            throw std::invalid_argument("fen: not 6 fen parts");
         }
-    }
-    // half-move counter validity
-    if(fen_parts.at(4).toInt() < 0) {
-        throw std::invalid_argument("negative half move clock or not a number");
-    }
-    // full move number validity
-    if(fen_parts.at(5).toInt() < 0) {
-        throw std::invalid_argument("fullmove number not positive");
-    }
-    // set pieces
-    for(int i=0;i<rows.size();i++) {
-        int square_index = 91 - (i*10);
-        QString row = rows.at(i);
-        for(int j=0;j<row.size();j++) {
-            QChar rj = row.at(j);
-            QChar rjl = rj.toLower();
-            if(rj == QChar('1') || rj == QChar('2') || rj == QChar('3') || rj == QChar('4')
-                    || rj == QChar('5') || rj == QChar('6') || rj == QChar('7') || rj == QChar('8')) {
-                square_index += rj.digitValue();
-            } else if(rjl == QChar('p') || rjl == QChar('n') || rjl == QChar('b')
-                      || rjl == QChar('r') || rjl == QChar('q') || rjl == QChar('k')) {
-                uint8_t piece = this->piece_from_symbol(rj);
-                this->board[square_index] = piece;
-                square_index += 1;
-            }
+        c++;
+        parts[i] = c;
+        while(c != end && *c != ' ') {
+            c++;
+        }
+        part_lengths[i] = int(c - parts[i]);
+        if(part_lengths[i] == 0) {
+            throw std::invalid_argument("fen: not 6 fen parts");
         }
     }
-    // set turn
-    if(fen_parts.at(1) == QString("w")) {
-        this->turn = WHITE;
+    if(c != end) {
+        throw std::invalid_argument("fen: not 6 fen parts");
     }
-    if(fen_parts.at(1) == QString("b")) {
-        this->turn = BLACK;
+
+    // turn
+    if(part_lengths[0] != 1 || (parts[0][0] != 'w' && parts[0][0] != 'b')) {
+        throw std::invalid_argument("turn part is invalid");
     }
-    this->castling_rights = 0x00;
-    for(int i=0;i<fen_parts.at(2).size();i++) {
-        QChar ci = fen_parts.at(2).at(i);
-        if(ci == QChar('K')) {
-            this->set_castle_wking(true);
-        }
-        if(ci == QChar('Q')) {
-            this->set_castle_wqueen(true);
-        }
-        if(ci == QChar('k')) {
-            this->set_castle_bking(true);
-        }
-        if(ci == QChar('q')) {
-            this->set_castle_bqueen(true);
+    this->turn = parts[0][0] == 'w' ? WHITE : BLACK;
+
+    // castling rights: either "-", or up to two white then up
+    // to two black rights, as KQkq or as files (Shredder-FEN). A file
+    // must hold the outermost rook on its side of the king
+    if(!(part_lengths[1] == 1 && parts[1][0] == '-')) {
+        int j = 0;
+        while(j < part_lengths[1] && j < 2 && (parts[1][j] == 'K' || parts[1][j] == 'Q'
+                                                || (parts[1][j] >= 'A' && parts[1][j] <= 'H'))) {
+            j++;
+        }
+        int white_end = j;
+        while(j < part_lengths[1] && j < white_end + 2 && (parts[1][j] == 'k' || parts[1][j] == 'q'
+                                                            || (parts[1][j] >= 'a' && parts[1][j] <= 'h'))) {
+            j++;
+        }
+        if(j != part_lengths[1]) {
+            throw std::invalid_argument("castles encoding is invalid");
+        }
+        for(int i=0;i<part_lengths[1];i++) {
+            char ci = parts[1][i];
+            if(ci == 'K') {
+                this->set_castle_wking(true);
+            }
+            if(ci == 'Q') {
+                this->set_castle_wqueen(true);
+            }
+            if(ci == 'k') {
+                this->set_castle_bking(true);
+            }
+            if(ci == 'q') {
+                this->set_castle_bqueen(true);
+            }
+            if(ci >= 'A' && ci <= 'H') {
+                int side = fen_castling_side(this->board, A1, WHITE_KING, WHITE_ROOK, ci - 'A');
+                if(side == 0) {
+                    throw std::invalid_argument("castles encoding is invalid");
+                }
+                if(side > 0) {
+                    this->set_castle_wking(true);
+                } else {
+                    this->set_castle_wqueen(true);
+                }
+            }
+            if(ci >= 'a' && ci <= 'h') {
+                int side = fen_castling_side(this->board, A8, BLACK_KING, BLACK_ROOK, ci - 'a');
+                if(side == 0) {
+                    throw std::invalid_argument("castles encoding is invalid");
+                }
+                if(side > 0) {
+                    this->set_castle_bking(true);
+                } else {
+                    this->set_castle_bqueen(true);
+                }
+            }
         }
     }
-    // set en passent square
-    if(fen_parts.at(3) == QString('-')) {
+
+    // en passent square, on the sixth rank if white
+    // is to move, and on the third if black is
+    if(part_lengths[2] == 1 && parts[2][0] == '-') {
         this->en_passent_target = 0;
     } else {
-        int row = 10 + (fen_parts.at(3).at(1).digitValue() * 10);
-        int col = 0;
-        QChar c = fen_parts.at(3).at(0).toLower();
-        if(c == 'a') {
-            col = 1;
-        }
-        if(c == 'b') {
-            col = 2;
-        }
-        if(c == 'c') {
-            col = 3;
-        }
-        if(c == 'd') {
-            col = 4;
-        }
-        if(c == 'e') {
-            col = 5;
-        }
-        if(c == 'f') {
-            col = 6;
-        }
-        if(c == 'g') {
-            col = 7;
-        }
-        if(c == 'h') {
-            col = 8;
+        char rank = this->turn == WHITE ? '6' : '3';
+        if(part_lengths[2] != 2 || parts[2][0] < 'a' || parts[2][0] > 'h' || parts[2][1] != rank) {
+            if(this->turn == WHITE) {
+                throw std::invalid_argument("invalid e.p. encoding (white to move)");
+            } else {
+                throw std::invalid_argument("invalid e.p. encoding (black to move)");
+            }
         }
-        this->en_passent_target = row + col;
+        this->en_passent_target = 10 + ((parts[2][1] - '0') * 10) + (parts[2][0] - 'a' + 1);
+    }
+
+    // half-move counter and full move number validity
+    this->halfmove_clock = fen_number(parts[3], part_lengths[3]);
+    if(this->halfmove_clock < 0) {
+        throw std::invalid_argument("negative half move clock or not a number");
+    }
+    this->fullmove_number = fen_number(parts[4], part_lengths[4]);
+    if(this->fullmove_number < 0) {
+        throw std::invalid_argument("fullmove number not positive or not a number");
     }
-    this->halfmove_clock = fen_parts.at(4).toInt();
-    this->fullmove_number = fen_parts.at(5).toInt();
-    this->undo_available = false;
+
     this->last_was_null = false;
+    this->sync_bitboards();
     if(!this->is_consistent()) {
         throw std::invalid_argument("board position from supplied fen is inconsistent");
     }
-    this->transpositionTable = new QMap<quint64, int>();
-    this->update_transposition_table();
 }
 
 QString Board::idx_to_str(int idx) {
@@ -706,64 +780,94 @@ QString Board::idx_to_str(int idx) {
 }
 
 QString Board::fen() {
+    char fen[FEN_BUFFER_SIZE];
+    int length = this->write_fen(fen);
+    return QString::fromLatin1(fen, length);
+}
+
+// fen letters of white and black pieces, indexed by piece type
+static const char FEN_WHITE_PIECES[] = " PNBRQK";
+static const char FEN_BLACK_PIECES[] = " pnbrqk";
+
+// writes the decimal digits of the number, returns their count
+static int write_fen_number(char *fen, int number) {
+    char digits[12];
+    int count = 0;
+    unsigned int value = number < 0 ? 0u - unsigned(number) : unsigned(number);
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+    int n = 0;
+    if(number < 0) {
+        fen[n++] = '-';
+    }
+    while(count > 0) {
+        fen[n++] = digits[--count];
+    }
+    return n;
+}
+
+int Board::write_fen(char *fen) {
+    int n = 0;
     // first build board
-    QString fen_string = QString("");
     for(int i=90;i>=20;i-=10) {
         int square_counter = 0;
         for(int j=1;j<9;j++) {
-            if(this->board[i+j] != 0x00) {
-                uint8_t piece = this->board[i+j];
-                fen_string.append(this->piece_to_symbol(piece));
-                square_counter = 0;
-            } else {
+            uint8_t piece = this->board[i+j];
+            if(piece == EMPTY) {
                 square_counter += 1;
-                if(j==8) {
-                    fen_string.append(QChar((char) (48+square_counter)));
-                } else {
-                    if(this->board[i+j+1] != 0x00) {
-                        fen_string.append(QChar((char) (48+square_counter)));
-                    }
-                }
+                continue;
+            }
+            if(square_counter > 0) {
+                fen[n++] = char('0' + square_counter);
+                square_counter = 0;
             }
+            fen[n++] = (piece & 0x80) ? FEN_BLACK_PIECES[piece & 0x07] : FEN_WHITE_PIECES[piece & 0x07];
+        }
+        if(square_counter > 0) {
+            fen[n++] = char('0' + square_counter);
         }
         if(i!=20) {
-            fen_string.append(QChar('/'));
+            fen[n++] = '/';
         }
     }
     // write turn
-    if(this->turn == WHITE) {
-        fen_string.append(" w");
-    } else {
-        fen_string.append(" b");
-    }
+    fen[n++] = ' ';
+    fen[n++] = this->turn == WHITE ? 'w' : 'b';
     // write castling rights
+    fen[n++] = ' ';
     if(this->castling_rights == 0x00) {
-        fen_string.append(" -");
+        fen[n++] = '-';
     } else {
-        fen_string.append(' ');
         if(this->can_castle_wking()) {
-            fen_string.append(('K'));
+            fen[n++] = 'K';
         }
         if(this->can_castle_wqueen()) {
-            fen_string.append(('Q'));
+            fen[n++] = 'Q';
         }
         if(this->can_castle_bking()) {
-            fen_string.append(('k'));
+            fen[n++] = 'k';
         }
         if(this->can_castle_bqueen()) {
-            fen_string.append(('q'));
+            fen[n++] = 'q';
         }
     }
     // write ep target if exists
+    fen[n++] = ' ';
     if(this->en_passent_target != 0x00) {
-        fen_string.append(" "+this->idx_to_str(this->en_passent_target));
+        fen[n++] = char((this->en_passent_target % 10) + 96);
+        fen[n++] = char((this->en_passent_target / 10) + 47);
     } else {
-        fen_string.append(" -");
+        fen[n++] = '-';
     }
     // add halfmove clock and fullmove counter
-    fen_string.append(" ").append(QString::number(this->halfmove_clock));
-    fen_string.append(" ").append(QString::number(this->fullmove_number));
-    return fen_string;
+    fen[n++] = ' ';
+    n += write_fen_number(fen + n, this->halfmove_clock);
+    fen[n++] = ' ';
+    n += write_fen_number(fen + n, this->fullmove_number);
+    fen[n] = '\0';
+    return n;
 }
 
 
@@ -803,6 +907,17 @@ bool Board::can_castle_bqueen() {
     }
 }
 
+// sets the castling rights and updates the hash key
+void Board::set_castling_rights(uint8_t rights) {
+    uint8_t changed = this->castling_rights ^ rights;
+    for(int i=0;i<4;i++) {
+        if(changed & (1 << i)) {
+            this->zobrist_key ^= POLYGLOT_RANDOM_64[RANDOM_CASTLE+i];
+        }
+    }
+    this->castling_rights = rights;
+}
+
 void Board::set_castle_wking(bool can_do) {
     IntBits cstle = IntBits(this->castling_rights);
     if(can_do) {
@@ -810,7 +925,7 @@ void Board::set_castle_wking(bool can_do) {
     } else {
         cstle.reset(CASTLE_WKING_POS);
     }
-    this->castling_rights = static_cast<uint8_t>(cstle.to_ulong());
+    this->set_castling_rights(static_cast<uint8_t>(cstle.to_ulong()));
 }
 
 void Board::set_castle_bking(bool can_do) {
@@ -820,7 +935,7 @@ void Board::set_castle_bking(bool can_do) {
     } else {
         cstle.reset(CASTLE_BKING_POS);
     }
-    this->castling_rights = static_cast<uint8_t>(cstle.to_ulong());
+    this->set_castling_rights(static_cast<uint8_t>(cstle.to_ulong()));
 }
 
 void Board::set_castle_wqueen(bool can_do) {
@@ -830,7 +945,7 @@ void Board::set_castle_wqueen(bool can_do) {
     } else {
         cstle.reset(CASTLE_WQUEEN_POS);
     }
-    this->castling_rights = static_cast<uint8_t>(cstle.to_ulong());
+    this->set_castling_rights(static_cast<uint8_t>(cstle.to_ulong()));
 }
 
 void Board::set_castle_bqueen(bool can_do) {
@@ -840,16 +955,18 @@ void Board::set_castle_bqueen(bool can_do) {
     } else {
         cstle.reset(CASTLE_BQUEEN_POS);
     }
-    this->castling_rights = static_cast<uint8_t>(cstle.to_ulong());
+    this->set_castling_rights(static_cast<uint8_t>(cstle.to_ulong()));
 }
 
-Moves* Board::pseudo_legal_moves() {
-    return this->pseudo_legal_moves_from(0,true,this->turn);
+MoveList Board::pseudo_legal_moves() {
+    MoveList moves;
+    this->pseudo_legal_moves_from(0,true,this->turn,&moves);
+    return moves;
 }
 
 bool Board::castles_wking(const Move &m) {
-    if(this->piece_type(m.from) == KING && this->piece_color(m.from) == WHITE &&
-            m.from == E1 && m.to == G1) {
+    if(this->piece_type(m.from()) == KING && this->piece_color(m.from()) == WHITE &&
+            m.from() == E1 && m.to() == G1) {
         return true;
     } else {
         return false;
@@ -858,8 +975,8 @@ bool Board::castles_wking(const Move &m) {
 
 
 bool Board::castles_wqueen(const Move &m) {
-    if(this->piece_type(m.from) == KING && this->piece_color(m.from) == WHITE &&
-            m.from == E1 && m.to == C1) {
+    if(this->piece_type(m.from()) == KING && this->piece_color(m.from()) == WHITE &&
+            m.from() == E1 && m.to() == C1) {
         return true;
     } else {
         return false;
@@ -868,8 +985,8 @@ bool Board::castles_wqueen(const Move &m) {
 
 
 bool Board::castles_bking(const Move &m) {
-    if(this->piece_type(m.from) == KING && this->piece_color(m.from) == BLACK &&
-            m.from == E8 && m.to == G8) {
+    if(this->piece_type(m.from()) == KING && this->piece_color(m.from()) == BLACK &&
+            m.from() == E8 && m.to() == G8) {
         return true;
     } else {
         return false;
@@ -877,8 +994,8 @@ bool Board::castles_bking(const Move &m) {
 }
 
 bool Board::castles_bqueen(const Move &m) {
-    if(this->piece_type(m.from) == KING && this->piece_color(m.from) == BLACK &&
-            m.from == E8 && m.to == C8) {
+    if(this->piece_type(m.from()) == KING && this->piece_color(m.from()) == BLACK &&
+            m.from() == E8 && m.to() == C8) {
         return true;
     } else {
         return false;
@@ -888,61 +1005,140 @@ bool Board::castles_bqueen(const Move &m) {
 // to get legal moves, just get list of pseudo
 // legals and then filter by checking each move's
 // legality
-Moves* Board::legal_moves() {
-    Moves* pseudo_legals = this->pseudo_legal_moves();
-    Moves* legals = new Moves();
-    for(int i=0;i<pseudo_legals->size();i++) {
-        Move m = pseudo_legals->at(i);
-        if(this->pseudo_is_legal_move(m)) {
-            legals->append(m);
+MoveList Board::legal_moves() {
+    MoveList legals;
+    this->legal_moves(&legals);
+    return legals;
+}
+
+void Board::legal_moves(MoveList *moves) {
+    MoveList pseudo_legals;
+    this->pseudo_legal_moves_from(0,true,this->turn,&pseudo_legals);
+    LegalityMasks masks;
+    this->compute_legality_masks(&masks);
+    for(const Move &m : pseudo_legals) {
+        if(this->pseudo_is_legal_move(m, masks)) {
+            moves->append(m);
         }
     }
-    pseudo_legals->clear();
-    delete(pseudo_legals);
-    return legals;
 }
 
-Moves* Board::legal_moves_from(int from_square) {
-    Moves* pseudo_legals = this->pseudo_legal_moves_from(from_square, true,this->turn);
-    Moves* legals = new Moves();
-    for(int i=0;i<pseudo_legals->size();i++) {
-        Move m = pseudo_legals->at(i);
-        if(this->pseudo_is_legal_move(m)) {
-            legals->append(m);
+MoveList Board::legal_moves_from(int from_square) {
+    MoveList pseudo_legals;
+    this->pseudo_legal_moves_from(from_square,true,this->turn,&pseudo_legals);
+    LegalityMasks masks;
+    this->compute_legality_masks(&masks);
+    MoveList legals;
+    for(const Move &m : pseudo_legals) {
+        if(this->pseudo_is_legal_move(m, masks)) {
+            legals.append(m);
         }
     }
-    pseudo_legals->clear();
-    delete(pseudo_legals);
     return legals;
 }
 
+// stops at the first legal move, instead of
+// generating all of them
+bool Board::has_legal_move() {
+    MoveList pseudo_legals;
+    this->pseudo_legal_moves_from(0,true,this->turn,&pseudo_legals);
+    LegalityMasks masks;
+    this->compute_legality_masks(&masks);
+    for(const Move &m : pseudo_legals) {
+        if(this->pseudo_is_legal_move(m, masks)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// finds the pieces of the side to move that are pinned to their
+// king, and the squares a piece can move to in order to resolve
+// a check (all squares if not in check, none in double check)
+void Board::compute_legality_masks(LegalityMasks *masks) {
+    bool color = this->turn;
+    int king = this->king_square(color);
+    masks->king = king;
+    masks->pinned = 0;
+    masks->evasions = ~Bitboard(0);
+    if(king < 0) {
+        return;
+    }
+    Bitboard own = this->color_bb[color];
+    Bitboard enemy = this->color_bb[!color];
+    Bitboard occupied = own | enemy;
+    Bitboard diagonal = (this->piece_bb[BISHOP] | this->piece_bb[QUEEN]) & enemy;
+    Bitboard straight = (this->piece_bb[ROOK] | this->piece_bb[QUEEN]) & enemy;
+    int checkers = 0;
+    Bitboard contact = (PAWN_ATTACKS[color][king] & this->piece_bb[PAWN] & enemy)
+            | (KNIGHT_ATTACKS[king] & this->piece_bb[KNIGHT] & enemy);
+    if(contact != 0) {
+        checkers += (contact & (contact - 1)) != 0 ? 2 : 1;
+        masks->evasions = contact;
+    }
+    for(int d=0;d<8;d++) {
+        Bitboard sliders = (d == RAY_NORTH_EAST || d == RAY_NORTH_WEST
+                            || d == RAY_SOUTH_EAST || d == RAY_SOUTH_WEST) ? diagonal : straight;
+        if((RAYS[d][king] & sliders) == 0) {
+            continue;
+        }
+        // the first piece along the ray either gives check, or
+        // if it is our own, may be pinned by the piece behind it
+        Bitboard ray = ray_attacks(king, d, occupied);
+        Bitboard first = ray & occupied;
+        if(first & sliders) {
+            checkers++;
+            // squares between king and checker, and the checker itself
+            masks->evasions = ray;
+        } else if(first & own) {
+            Bitboard behind = ray_attacks(king, d, occupied & ~first) & ~ray;
+            if(behind & sliders) {
+                masks->pinned |= first;
+            }
+        }
+    }
+    if(checkers > 1) {
+        // only the king can move
+        masks->evasions = 0;
+    }
+}
+
+// same as pseudo_is_legal_move(m), but most moves are
+// decided by the supplied masks alone
+bool Board::pseudo_is_legal_move(const Move &m, const LegalityMasks &masks) {
+    if(masks.king < 0 || m.from_square() == masks.king) {
+        return this->pseudo_is_legal_move(m);
+    }
+    if(m.to() == this->en_passent_target && this->piece_type(m.from()) == PAWN) {
+        return this->pseudo_is_legal_move(m);
+    }
+    if((masks.evasions & square_bb(m.to_square())) == 0) {
+        return false;
+    }
+    if(masks.pinned & square_bb(m.from_square())) {
+        return this->pseudo_is_legal_move(m);
+    }
+    return true;
+}
+
 bool Board::is_legal_and_promotes(const Move &m) {
-    Moves* legals = this->legal_moves_from(m.from);
-    for(int i=0;i<legals->size();i++) {
-        Move mi = legals->at(i);
-        if(mi.from == m.from && mi.to == m.to && mi.promotion_piece != 0) {
-            legals->clear();
-            delete legals;
+    MoveList legals = this->legal_moves_from(m.from());
+    for(const Move &mi : legals) {
+        if(mi.from() == m.from() && mi.to() == m.to() && mi.promotion_piece() != 0) {
             return true;
         }
     }
-    legals->clear();
-    delete(legals);
     return false;
 }
 
 bool Board::is_legal_move(const Move &m) {
-    Moves* pseudo_legals = this->pseudo_legal_moves_from(m.from, true,this->turn);
-    for(int i=0;i<pseudo_legals->size();i++) {
-        Move mi = pseudo_legals->at(i);
+    MoveList pseudo_legals;
+    this->pseudo_legal_moves_from(m.from(),true,this->turn,&pseudo_legals);
+    for(const Move &mi : pseudo_legals) {
         if(mi == m && this->pseudo_is_legal_move(m)) {
-            pseudo_legals->clear();
-            delete pseudo_legals;
             return true;
         }
     }
-    pseudo_legals->clear();
-    delete(pseudo_legals);
     return false;
 }
 
@@ -952,330 +1148,215 @@ bool Board::pseudo_is_legal_move(const Move &m) {
     // b) if castle, must ensure that 1) king is not currently in check
     //                                2) castle over squares are not in check
     //                                3) doesn't castle into check
+    // instead of applying the move, the occupancy after the
+    // move is computed, and the king square tested against it
     // first find color of mover
-    bool color = this->piece_color(m.from);
-    // find king with that color
-    for(int i= 21;i<99;i++) {
-        if(this->piece_type(i) == KING && this->piece_color(i) == color) {
-            // if the move is not by the king
-            if(i!=m.from) {
-                // apply the move, check if king is attacked, and decide
-                bool legal = false;
-                this->apply(m);
-                legal = !this->is_attacked(i,!color);
-                this->undo();
-                return legal;
-            } else {
-                // means we move the king
-                // first check castle cases
-                if(this->castles_wking(m)) {
-                    if(!this->is_attacked(E1,BLACK) && !this->is_attacked(F1,BLACK)
-                            && !this->is_attacked(G1,BLACK)) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(G1,BLACK);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                if(this->castles_bking(m)) {
-                    if(!this->is_attacked(E8,WHITE) && !this->is_attacked(F8,WHITE)
-                            && !this->is_attacked(G8,WHITE)) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(G8,WHITE);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                if(this->castles_wqueen(m)) {
-                    if(!this->is_attacked(E1,BLACK) && !this->is_attacked(D1,BLACK)
-                            && !this->is_attacked(C1,BLACK) ) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(C1,BLACK);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                if(this->castles_bqueen(m)) {
-                    if(!this->is_attacked(E8,WHITE) && !this->is_attacked(D8,WHITE)
-                            && !this->is_attacked(C8,WHITE) ) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(C8,WHITE);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                // if none of the castles cases triggered, we have a standard king move
-                // just check if king isn't attacked after applying the move
-                bool legal = false;
-                this->apply(m);
-                legal = !this->is_attacked(m.to,!color);
-                this->undo();
-                return legal;
-            }
+    bool color = this->piece_color(m.from());
+    int king = this->king_square(color);
+    if(king < 0) {
+        return false;
+    }
+    Bitboard from = square_bb(m.from_square());
+    Bitboard to = square_bb(m.to_square());
+    Bitboard occupied = ((this->color_bb[WHITE] | this->color_bb[BLACK]) & ~from) | to;
+    // a piece on the target square is captured and doesn't attack anymore
+    Bitboard attackers = this->color_bb[!color] & ~to;
+    // if the move is not by the king
+    if(SQUARE_120[king] != m.from()) {
+        // en passent removes the pawn next to the target
+        if(m.to() == this->en_passent_target && this->piece_type(m.from()) == PAWN) {
+            Bitboard captured = square_bb(SQUARE_64[color == WHITE ? m.to() - 10 : m.to() + 10]);
+            occupied &= ~captured;
+            attackers &= ~captured;
+        }
+        return !this->is_attacked(king, !color, occupied, attackers);
+    }
+    // means we move the king
+    // first check castle cases
+    if(this->castles_wking(m)) {
+        if(this->is_attacked(E1,BLACK) || this->is_attacked(F1,BLACK)) {
+            return false;
         }
+        occupied = (occupied & ~square_bb(SQUARE_64[H1])) | square_bb(SQUARE_64[F1]);
     }
-    return false;
+    if(this->castles_bking(m)) {
+        if(this->is_attacked(E8,WHITE) || this->is_attacked(F8,WHITE)) {
+            return false;
+        }
+        occupied = (occupied & ~square_bb(SQUARE_64[H8])) | square_bb(SQUARE_64[F8]);
+    }
+    if(this->castles_wqueen(m)) {
+        if(this->is_attacked(E1,BLACK) || this->is_attacked(D1,BLACK)) {
+            return false;
+        }
+        occupied = (occupied & ~square_bb(SQUARE_64[A1])) | square_bb(SQUARE_64[D1]);
+    }
+    if(this->castles_bqueen(m)) {
+        if(this->is_attacked(E8,WHITE) || this->is_attacked(D8,WHITE)) {
+            return false;
+        }
+        occupied = (occupied & ~square_bb(SQUARE_64[A8])) | square_bb(SQUARE_64[D8]);
+    }
+    // the king must not be attacked on the target square
+    return !this->is_attacked(m.to_square(), !color, occupied, attackers);
 }
 
 // doesn't account for attacks via en-passent
 bool Board::is_attacked(int idx, bool attacker_color) {
-    // first check for potential pawn attackers
-    // attacker color white, pawn must be white.
-    // lower left
-    if(attacker_color == WHITE && (this->board[idx-9]!=0xFF)
-            && (this->piece_color(idx-9)==WHITE) && (this->piece_type(idx-9)==PAWN)) {
+    Bitboard occupied = this->color_bb[WHITE] | this->color_bb[BLACK];
+    return this->is_attacked(SQUARE_64[idx], attacker_color, occupied, this->color_bb[attacker_color]);
+}
+
+// checks whether square (0 ... 63) is attacked by one of the
+// attackers (a subset of the pieces of attacker_color), if the
+// board were occupied by occupied. This allows to test a position
+// after a move without applying it
+bool Board::is_attacked(int square, bool attacker_color, Bitboard occupied, Bitboard attackers) {
+    // a pawn of the attacker attacks the square, if a pawn
+    // of the other color on the square would attack the pawn
+    if(PAWN_ATTACKS[!attacker_color][square] & this->piece_bb[PAWN] & attackers) {
         return true;
     }
-    // lower right
-    if(attacker_color == WHITE && (this->board[idx-11]!=0xFF)
-            && (this->piece_color(idx-11)==WHITE) && (this->piece_type(idx-11)==PAWN)) {
+    if(KNIGHT_ATTACKS[square] & this->piece_bb[KNIGHT] & attackers) {
         return true;
     }
-    // check black, upper right
-    if(attacker_color == BLACK && (this->board[idx+11]!=0xFF)
-            && (this->piece_color(idx+11)==BLACK) && (this->piece_type(idx+11)==PAWN)) {
+    if(KING_ATTACKS[square] & this->piece_bb[KING] & attackers) {
         return true;
     }
-    // check black, upper left
-    if(attacker_color == BLACK && (this->board[idx+9]!=0xFF)
-            && (this->piece_color(idx+9)==BLACK) && (this->piece_type(idx+9)==PAWN)) {
+    Bitboard queens = this->piece_bb[QUEEN] & attackers;
+    Bitboard diagonal = (this->piece_bb[BISHOP] & attackers) | queens;
+    if(diagonal != 0 && (bishop_attacks(square, occupied) & diagonal)) {
         return true;
     }
-    // check all squares (except idx itself)
-    // for potential attackers
-    for(int i=21;i<99;i++) {
-        // skip empty squares
-        if(i!=idx && this->board[i] != 0x00) {
-            // can't attack yourself
-            if(this->piece_color(i) == attacker_color) {
-                uint8_t piece = this->piece_type(i);
-                int distance = idx - i;
-                if(distance < 0) {
-                    distance = -distance;
-                }
-                IntBits pot_attackers = IntBits(ATTACK_TABLE[distance]);
-                if((piece == KNIGHT && pot_attackers.test(0)) ||
-                        (piece == BISHOP && pot_attackers.test(1)) ||
-                        (piece == ROOK && pot_attackers.test(2)) ||
-                        (piece == QUEEN && pot_attackers.test(3)) ||
-                        (piece == KING && pot_attackers.test(4))) {
-                    // the target could be a potential attacker
-                    // now just get all pseudo legal moves from i,
-                    // excluding castling. If a move contains
-                    // target idx, then we have an attacker
-                    Moves* targets = this->pseudo_legal_moves_from(i,false,attacker_color);
-                    for(int j=0;j<targets->size();j++) {
-                        if(targets->at(j).to == idx) {
-                            targets->clear();
-                            delete(targets);
-                            return true;
-                        }
-                    }
-                    targets->clear();
-                    delete(targets);
-                }
-            }
-        }
+    Bitboard straight = (this->piece_bb[ROOK] & attackers) | queens;
+    if(straight != 0 && (rook_attacks(square, occupied) & straight)) {
+        return true;
     }
     return false;
 }
 
+// returns the square (0 ... 63) of the king, or -1
+// if there is no king of that color
+int Board::king_square(bool color) {
+    Bitboard king = this->piece_bb[KING] & this->color_bb[color];
+    if(king == 0) {
+        return -1;
+    }
+    return qCountTrailingZeroBits(king);
+}
+
+// adds a move to each of the targets, and the
+// four promotions if the target is on the last rank
+static void append_moves(MoveList *moves, int from, Bitboard targets, bool promotes) {
+    while(targets != 0) {
+        int to = pop_square(targets);
+        if(promotes) {
+            moves->append(Move::from_squares(from,to,QUEEN));
+            moves->append(Move::from_squares(from,to,ROOK));
+            moves->append(Move::from_squares(from,to,BISHOP));
+            moves->append(Move::from_squares(from,to,KNIGHT));
+        } else {
+            moves->append(Move::from_squares(from,to));
+        }
+    }
+}
+
+MoveList Board::pseudo_legal_moves_from(int from_square, bool with_castles, bool turn) {
+    MoveList moves;
+    this->pseudo_legal_moves_from(from_square,with_castles,turn,&moves);
+    return moves;
+}
+
 // calling with from_square = 0 means all possible moves
 // will find all pseudo legal move for supplied player (turn must be
 // either WHITE or BLACK)
-Moves* Board::pseudo_legal_moves_from(int from_square, bool with_castles, bool turn) {
-
-    Moves* moves = new Moves();
-
-    for(int i=21;i<99;i++) {
-        if(from_square == 0 || from_square == i) {
-            // skip offboard's left and right
-            if(!(this->board[i] == 0xFF)) {
-                // get piece type & color
-                bool color = this->piece_color(i);
-                if(color == turn) {
-                    uint8_t piece = this->piece_type(i);
-                    // handle case of PAWN
-                    if(piece == PAWN) {
-                        uint8_t piece_idx = IDX_WPAWN;
-                        if(color == BLACK) {
-                            piece_idx = IDX_BPAWN;
-                        }
-                        // take up right, or up left
-                        for(int j=3;j<=4;j++) {
-                            uint8_t idx = i + DIR_TABLE[piece_idx][j];
-                            if(!this->is_offside(idx)) {
-                                if((!this->is_empty(idx) && color==BLACK && this->is_white_at(idx)) ||
-                                        (!this->is_empty(idx) && color==WHITE && !this->is_white_at(idx))) {
-                                    // if it's a promotion square, add four moves
-                                    if((color==WHITE && (idx / 10 == 9)) || (color==BLACK && (idx / 10 == 2))) {
-                                        moves->append(Move(i,idx,QUEEN));
-                                        moves->append(Move(i,idx,ROOK));
-                                        moves->append(Move(i,idx,BISHOP));
-                                        moves->append(Move(i,idx,KNIGHT));
-                                    } else {
-                                        moves->append(Move(i,idx));
-                                    }
-                                }
-                            }
-                        }
-                        // move one (j=1) or two (j=2) up (or down in the case of black)
-                        for(int j=1;j<=2;j++) {
-                            uint8_t idx = i + DIR_TABLE[piece_idx][j];
-                            if(!this->is_offside(idx)) {
-                                if(j==2 && ((color == WHITE && (i/10==3)) || (color==BLACK && (i/10==8)))) {
-                                    // means we have a white/black pawn in inital position, direct square
-                                    // in front is empty => allow to move two forward
-                                    if(this->is_empty(idx)) {
-                                        moves->append(Move(i,idx));
-                                    }
-                                }
-                                else if(j==1) {
-                                    // case of one-step move forward
-                                    if(!this->is_empty(idx)) {
-                                        break;
-                                    } else {
-                                        // if it's a promotion square, add four moves
-                                        if((color==WHITE && (idx / 10 == 9)) || (color==BLACK && (idx / 10 == 2))) {
-                                            moves->append(Move(i,idx,QUEEN));
-                                            moves->append(Move(i,idx,ROOK));
-                                            moves->append(Move(i,idx,BISHOP));
-                                            moves->append(Move(i,idx,KNIGHT));
-                                        } else {
-                                            moves->append(Move(i,idx));
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        // finally, potential en-passent capture is handled
-                        // left up
-                        if(color == WHITE && (this->en_passent_target - i)==9) {
-                            Move m = (Move(i,this->en_passent_target));
-                            moves->append(m);
-                        }
-                        // right up
-                        if(color == WHITE && (this->en_passent_target - i)==11) {
-                            Move m = (Move(i,this->en_passent_target));
-                            moves->append(m);
-                        }
-                        // left down
-                        if(color == BLACK && (this->en_passent_target - i)==-9) {
-                            Move m = (Move(i,this->en_passent_target));
-                            moves->append(m);
-                        }
-                        if(color == BLACK && (this->en_passent_target - i)==-11) {
-                            Move m = (Move(i,this->en_passent_target));
-                            moves->append(m);
-                        }
-                    }
-                    // handle case of knight
-                    if(piece == KNIGHT || piece == KING) {
-                        int lookup_idx;
-                        if(piece == KNIGHT) {
-                            lookup_idx = IDX_KNIGHT;
-                        } else {
-                            lookup_idx = IDX_KING;
-                        }
-                        for(int j=1;j<=DIR_TABLE[lookup_idx][0];j++) {
-                            uint8_t idx = i + DIR_TABLE[lookup_idx][j];
-                            if(!this->is_offside(idx)) {
-                                if(this->is_empty(idx) ||
-                                        (this->piece_color(idx) != color)) {
-                                    moves->append(Move(i,idx));
-                                }
-                            }
-                        }
-                    }
-                    // handle case of bishop, rook, queen
-                    if(piece == ROOK || piece == BISHOP || piece == QUEEN) {
-                        int lookup_idx = IDX_ROOK;
-                        if(piece == QUEEN) {
-                            lookup_idx = IDX_QUEEN;
-                        }
-                        if(piece == BISHOP) {
-                            lookup_idx = IDX_BISHOP;
-                        }
-                        for(int j=1;j<=DIR_TABLE[lookup_idx][0] ;j++) {
-                            uint8_t idx = i + DIR_TABLE[lookup_idx][j];
-                            bool stop = false;
-                            while(!stop) {
-                                if(!this->is_offside(idx)) {
-                                    if(this->is_empty(idx)) {
-                                        moves->append(Move(i,idx));
-                                    } else {
-                                        stop = true;
-                                        if(this->piece_color(idx) != color) {
-                                            moves->append(Move(i,idx));
-                                        }
-                                    }
-                                    idx = idx + DIR_TABLE[lookup_idx][j];
-                                } else {
-                                    stop = true;
-                                }
-                            }
-                        }
-                    }
+void Board::pseudo_legal_moves_from(int from_square, bool with_castles, bool turn, MoveList *moves) {
+
+    Bitboard own = this->color_bb[turn];
+    Bitboard enemy = this->color_bb[!turn];
+    Bitboard occupied = own | enemy;
+    Bitboard from = own;
+    if(from_square != 0) {
+        if(from_square < 21 || from_square > 98 || SQUARE_64[from_square] < 0) {
+            return;
+        }
+        from &= square_bb(SQUARE_64[from_square]);
+    }
+    while(from != 0) {
+        int sq = pop_square(from);
+        uint8_t i = SQUARE_120[sq];
+        uint8_t piece = this->piece_type(i);
+        if(piece == PAWN) {
+            // promotes, if the pawn is on the 7th (2nd) rank
+            bool promotes = (turn == WHITE && sq >= 48) || (turn == BLACK && sq < 16);
+            append_moves(moves, sq, PAWN_ATTACKS[turn][sq] & enemy, promotes);
+            // one step up (or down in the case of black), and two
+            // steps from the initial position if both squares are empty
+            int one = turn == WHITE ? sq + 8 : sq - 8;
+            if(!(occupied & square_bb(one))) {
+                append_moves(moves, sq, square_bb(one), promotes);
+                int two = turn == WHITE ? sq + 16 : sq - 16;
+                if(((turn == WHITE && sq < 16) || (turn == BLACK && sq >= 48))
+                        && !(occupied & square_bb(two))) {
+                    moves->append(Move::from_squares(sq,two));
                 }
             }
-            if(with_castles) {
-                if(this->turn == WHITE) {
-                    // check for castling
-                    // white kingside
-                    if(i==E1 && !this->is_empty(E1) && this->can_castle_wking() &&
-                            this->piece_color(E1) == WHITE && this->piece_color(H1) == WHITE
-                            && this->piece_type(E1) == KING && this->piece_type(H1) == ROOK
-                            && this->is_empty(F1) && this->is_empty(G1)) {
-                        moves->append(Move(E1,G1));
-                    }
-                    // white queenside
-                    if(i==E1 && !this->is_empty(E1) && this->can_castle_wqueen() &&
-                            this->piece_color(E1) == WHITE && this->piece_color(A1) == WHITE
-                            && this->piece_type(E1) == KING && this->piece_type(A1) == ROOK
-                            && this->is_empty(D1) && this->is_empty(C1) && this->is_empty(B1)) {
-                        moves->append(Move(E1,C1));
-                    }
-                }
-                if(this->turn == BLACK) {
-                    // black kingside
-                    if(i==E8 && !this->is_empty(E8) && this->can_castle_bking() &&
-                            this->piece_color(E8) == BLACK && this->piece_color(H8) == BLACK
-                            && this->piece_type(E8) == KING && this->piece_type(H8) == ROOK
-                            && this->is_empty(F8) && this->is_empty(G8)) {
-                        moves->append(Move(E8,G8));
-                    }
-                    // black queenside
-                    if(i==E8 && !this->is_empty(E8) && this->can_castle_bqueen() &&
-                            this->piece_color(E8) == BLACK && this->piece_color(A8) == BLACK
-                            && this->piece_type(E8) == KING && this->piece_type(A8) == ROOK
-                            && this->is_empty(D8) && this->is_empty(C8) && this->is_empty(B8)) {
-                        moves->append(Move(E8,C8));
-                    }
-                }
+            // finally, potential en-passent capture is handled
+            if(this->en_passent_target != 0 &&
+                    (PAWN_ATTACKS[turn][sq] & square_bb(SQUARE_64[this->en_passent_target]))) {
+                moves->append(Move::from_squares(sq,SQUARE_64[this->en_passent_target]));
+            }
+        } else {
+            Bitboard targets = 0;
+            if(piece == KNIGHT) {
+                targets = KNIGHT_ATTACKS[sq];
+            } else if(piece == KING) {
+                targets = KING_ATTACKS[sq];
+            } else if(piece == BISHOP) {
+                targets = bishop_attacks(sq, occupied);
+            } else if(piece == ROOK) {
+                targets = rook_attacks(sq, occupied);
+            } else if(piece == QUEEN) {
+                targets = bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+            }
+            append_moves(moves, sq, targets & ~own, false);
+        }
+    }
+    if(with_castles) {
+        if(this->turn == WHITE && (from_square == 0 || from_square == E1)) {
+            // check for castling
+            // white kingside
+            if(this->board[E1] == WHITE_KING && this->can_castle_wking() && this->board[H1] == WHITE_ROOK
+                    && this->is_empty(F1) && this->is_empty(G1)) {
+                moves->append(Move(E1,G1));
+            }
+            // white queenside
+            if(this->board[E1] == WHITE_KING && this->can_castle_wqueen() && this->board[A1] == WHITE_ROOK
+                    && this->is_empty(D1) && this->is_empty(C1) && this->is_empty(B1)) {
+                moves->append(Move(E1,C1));
+            }
+        }
+        if(this->turn == BLACK && (from_square == 0 || from_square == E8)) {
+            // black kingside
+            if(this->board[E8] == BLACK_KING && this->can_castle_bking() && this->board[H8] == BLACK_ROOK
+                    && this->is_empty(F8) && this->is_empty(G8)) {
+                moves->append(Move(E8,G8));
+            }
+            // black queenside
+            if(this->board[E8] == BLACK_KING && this->can_castle_bqueen() && this->board[A8] == BLACK_ROOK
+                    && this->is_empty(D8) && this->is_empty(C8) && this->is_empty(B8)) {
+                moves->append(Move(E8,C8));
             }
         }
     }
-    return moves;
 }
 
 bool Board::movePromotes(const Move&m) {
-    if(this->piece_type(m.from) == chess::PAWN) {
-        if(this->piece_color(m.from) == chess::WHITE && ((m.to / 10)==9)) {
+    if(this->piece_type(m.from()) == chess::PAWN) {
+        if(this->piece_color(m.from()) == chess::WHITE && ((m.to() / 10)==9)) {
             return true;
         }
-        if(this->piece_color(m.from) == chess::BLACK && ((m.to / 10)==2)) {
+        if(this->piece_color(m.from()) == chess::BLACK && ((m.to() / 10)==2)) {
             return true;
         }
     }
@@ -1284,18 +1365,11 @@ bool Board::movePromotes(const Move&m) {
 
 
 bool Board::piece_color(uint8_t idx) {
-    IntBits piece = IntBits(this->board[idx]);
-    if(piece.test(COLOR_FLAG) == WHITE) {
-        return WHITE;
-    } else {
-        return BLACK;
-    }
+    return (this->board[idx] >> COLOR_FLAG) != 0;
 }
 
 uint8_t Board::piece_type(uint8_t idx) {
-    IntBits piece = IntBits(this->board[idx]);
-    piece.set(7,0);
-    return static_cast<uint8_t>(piece.to_ulong());
+    return this->board[idx] & 0x7F;
 }
 
 uint8_t Board::piece_at(uint8_t idx) {
@@ -1306,6 +1380,56 @@ uint8_t Board::piece_at(uint8_t idx) {
     }
 }
 
+// random number of a piece (not EMPTY) on a square (0 ... 63), same as
+// 64 * zobrist_piece_type(piece) + square, i.e. black pawn = 0, white pawn = 1 ...
+static inline quint64 piece_key(uint8_t piece, int square) {
+    int kind = 2 * ((piece & 0x7F) - 1) + ((piece >> COLOR_FLAG) == 0 ? 1 : 0);
+    return POLYGLOT_RANDOM_64[RANDOM_PIECE + 64 * kind + square];
+}
+
+// sets the square (internal board index) to piece (or EMPTY)
+// and updates the bitboards and the hash key accordingly
+void Board::set_square(uint8_t idx, uint8_t piece) {
+    int sq = SQUARE_64[idx];
+    Bitboard square = square_bb(sq);
+    uint8_t old_piece = this->board[idx];
+    if(old_piece != EMPTY) {
+        this->piece_bb[old_piece & 0x7F] &= ~square;
+        this->color_bb[old_piece >> COLOR_FLAG] &= ~square;
+        this->zobrist_key ^= piece_key(old_piece, sq);
+    }
+    if(piece != EMPTY) {
+        this->piece_bb[piece & 0x7F] |= square;
+        this->color_bb[piece >> COLOR_FLAG] |= square;
+        this->zobrist_key ^= piece_key(piece, sq);
+    }
+    this->board[idx] = piece;
+}
+
+// recomputes all bitboards and the hash key from board
+// and castling_rights
+void Board::sync_bitboards() {
+    for(int i=0;i<7;i++) {
+        this->piece_bb[i] = 0;
+    }
+    this->color_bb[WHITE] = 0;
+    this->color_bb[BLACK] = 0;
+    this->zobrist_key = 0;
+    for(int sq=0;sq<64;sq++) {
+        uint8_t piece = this->board[SQUARE_120[sq]];
+        if(piece != EMPTY) {
+            this->piece_bb[piece & 0x7F] |= square_bb(sq);
+            this->color_bb[piece >> COLOR_FLAG] |= square_bb(sq);
+            this->zobrist_key ^= piece_key(piece, sq);
+        }
+    }
+    for(int i=0;i<4;i++) {
+        if(this->castling_rights & (1 << i)) {
+            this->zobrist_key ^= POLYGLOT_RANDOM_64[RANDOM_CASTLE+i];
+        }
+    }
+}
+
 // returns true if square is not empty
 bool Board::is_empty(uint8_t idx) {
     if(this->board[idx] == 0x00) {
@@ -1345,33 +1469,35 @@ bool Board::is_white_at(uint8_t idx) {
 
 // doesn't check legality
 void Board::apply(const Move &m) {
-    assert(m.promotion_piece <= 5);
-    if(m.is_null) {
-        //std::cout << "applying null move: " << m.uci_string.toStdString() << std::endl;
+    assert(m.promotion_piece() <= 5);
+    // remember what is needed to take back the move
+    UndoInfo info;
+    info.zobrist_key = this->zobrist_key;
+    info.halfmove_clock = this->halfmove_clock;
+    info.move = m;
+    info.captured = m.is_null() ? EMPTY : this->board[m.to()];
+    info.castling_rights = this->castling_rights;
+    info.en_passent_target = this->en_passent_target;
+    info.last_was_null = this->last_was_null;
+    this->undo_stack.append(info);
+    if(m.is_null()) {
+        //std::cout << "applying null move: " << m.uci().toStdString() << std::endl;
         //std::cout << (*this) << std::endl;
         this->turn = !this->turn;
-        this->prev_en_passent_target = this->en_passent_target;
         this->en_passent_target = 0;
         this->last_was_null = true;
-        this->undo_available = true;
     } else {
         this->last_was_null = false;
     this->turn = !this->turn;
-    this->prev_en_passent_target = this->en_passent_target;
-    this->prev_castling_rights = this->castling_rights;
     this->en_passent_target = 0;
     if(this->turn == WHITE) {
         this->fullmove_number++;
     }
-    for(int i=0;i<120;i++) {
-        this->old_board[i] = this->board[i];
-    }
-    uint8_t old_piece_type = this->piece_type(m.from);
-    bool color = this->piece_color(m.from);
+    uint8_t old_piece_type = this->piece_type(m.from());
+    bool color = this->piece_color(m.from());
     // increase halfmove clock only if no capture or pawn advance
     // happended
-    this->prev_halfmove_clock = this->halfmove_clock;
-    if(old_piece_type == PAWN || this->board[m.to] != EMPTY) {
+    if(old_piece_type == PAWN || this->board[m.to()] != EMPTY) {
         this->halfmove_clock = 0;
     } else {
         this->halfmove_clock++;
@@ -1379,12 +1505,12 @@ void Board::apply(const Move &m) {
     // if we move a pawn two steps up, set the en_passent field
     if(old_piece_type == PAWN) {
         // white pawn moved two steps up
-        if((m.to - m.from) == 20) {
-            this->en_passent_target = m.from + 10;
+        if((m.to() - m.from()) == 20) {
+            this->en_passent_target = m.from() + 10;
         }
         // black pawn moved two steps up (down)
-        if((m.to - m.from == -20)) {
-            this->en_passent_target = m.from - 10;
+        if((m.to() - m.from() == -20)) {
+            this->en_passent_target = m.from() - 10;
         }
     }
     // if the move is an en-passent capture,
@@ -1396,60 +1522,60 @@ void Board::apply(const Move &m) {
     // is down right or down left and empty
     // also set last_move_was_ep to true
     if(old_piece_type == PAWN) {
-        if(this->board[m.to] == EMPTY) {
-            if(color == WHITE && ((m.to-m.from == 9) || (m.to-m.from)==11)) {
+        if(this->board[m.to()] == EMPTY) {
+            if(color == WHITE && ((m.to()-m.from() == 9) || (m.to()-m.from())==11)) {
                 // remove captured pawn
-                this->board[m.to-10] = 0x00;
+                this->set_square(m.to()-10, 0x00);
             }
-            if(color == BLACK && ((m.from -m.to == 9) || (m.from - m.to)==11)) {
+            if(color == BLACK && ((m.from() -m.to() == 9) || (m.from() - m.to())==11)) {
                 // remove captured pawn
-                this->board[m.to+10] = 0x00;
+                this->set_square(m.to()+10, 0x00);
             }
         }
     }
     // if the move is a promotion, the target
     // field becomes the promotion choice
-    if(m.promotion_piece != EMPTY) {
+    if(m.promotion_piece() != EMPTY) {
         // true means black
         if(color == BLACK) {
             // +128 sets 7th bit to true (means black)
-            this->board[m.to] = m.promotion_piece +128;
+            this->set_square(m.to(), m.promotion_piece() +128);
         }
         else {
-            this->board[m.to] = m.promotion_piece;
+            this->set_square(m.to(), m.promotion_piece());
         }
     } else {
         // otherwise the target is the piece on the from field
-        this->board[m.to] = this->board[m.from];
+        this->set_square(m.to(), this->board[m.from()]);
     }
-    this->board[m.from] = EMPTY;
+    this->set_square(m.from(), EMPTY);
     // check if the move is castles, i.e. 0-0 or 0-0-0
     // then we also need to move the rook
     // white kingside
     if(old_piece_type == KING) {
         if(color==WHITE) {
-            if(m.from == E1 && m.to == G1) {
-                this->board[F1] = this->board[H1];
-                this->board[H1] = EMPTY;
+            if(m.from() == E1 && m.to() == G1) {
+                this->set_square(F1, this->board[H1]);
+                this->set_square(H1, EMPTY);
                 this->set_castle_wking(false);
             }
             // white queenside
-            if(m.from == E1 && m.to == C1) {
-                this->board[D1] = this->board[A1];
-                this->board[A1] = EMPTY;
+            if(m.from() == E1 && m.to() == C1) {
+                this->set_square(D1, this->board[A1]);
+                this->set_square(A1, EMPTY);
                 this->set_castle_wqueen(false);
             } }
         else if(color==BLACK) {
             // black kingside
-            if(m.from == E8 && m.to == G8) {
-                this->board[F8] = this->board[H8];
-                this->board[H8] = EMPTY;
+            if(m.from() == E8 && m.to() == G8) {
+                this->set_square(F8, this->board[H8]);
+                this->set_square(H8, EMPTY);
                 this->set_castle_bking(false);
             }
             // black queenside
-            if(m.from == E8 && m.to == C8) {
-                this->board[D8] = this->board[A8];
-                this->board[A8] = EMPTY;
+            if(m.from() == E8 && m.to() == C8) {
+                this->set_square(D8, this->board[A8]);
+                this->set_square(A8, EMPTY);
                 this->set_castle_bqueen(false);
             }
         }
@@ -1460,18 +1586,18 @@ void Board::apply(const Move &m) {
     // opposite side
     if(color == WHITE) {
         if(old_piece_type == KING) {
-            if(m.from == E1 && m.to !=G1) {
+            if(m.from() == E1 && m.to() !=G1) {
                 this->set_castle_wking(false);
             }
-            if(m.from == E1 && m.to != C1) {
+            if(m.from() == E1 && m.to() != C1) {
                 this->set_castle_wqueen(false);
             }
         }
         if(old_piece_type == ROOK) {
-            if(m.from == A1) {
+            if(m.from() == A1) {
                 this->set_castle_wqueen(false);
             }
-            if(m.from == H1) {
+            if(m.from() == H1) {
                 this->set_castle_wking(false);
             }
         }
@@ -1480,71 +1606,97 @@ void Board::apply(const Move &m) {
         // or black has moved rook prev.
         // [even though: in the latter case, should be already
         // done by check above in prev. moves]
-        if(m.to == H8) {
+        if(m.to() == H8) {
             this->set_castle_bking(false);
         }
-        if(m.to == A8) {
+        if(m.to() == A8) {
             this->set_castle_bqueen(false);
         }
     }
     // same for black
     if(color == BLACK) {
         if(old_piece_type == KING) {
-            if(m.from == E8 && m.to !=G8) {
+            if(m.from() == E8 && m.to() !=G8) {
                 this->set_castle_bking(false);
             }
-            if(m.from == E8 && m.to != C8) {
+            if(m.from() == E8 && m.to() != C8) {
                 this->set_castle_bqueen(false);
             }
         }
         if(old_piece_type == ROOK) {
-            if(m.from == A8) {
+            if(m.from() == A8) {
                 this->set_castle_bqueen(false);
             }
-            if(m.from == H8) {
+            if(m.from() == H8) {
                 this->set_castle_bking(false);
             }
         }
         // black moves piece to A1 or H1
-        if(m.to == H1) {
+        if(m.to() == H1) {
             this->set_castle_wking(false);
         }
-        if(m.to == A1) {
+        if(m.to() == A1) {
             this->set_castle_wqueen(false);
         }
     }
-    // after move is applied, can revert to the previous position
-    this->undo_available = true;
     }
 }
 
 void Board::undo() {
-    if(!this->undo_available) {
+    if(this->undo_stack.isEmpty()) {
         throw std::logic_error("must call board.apply(move) each time before calling undo() ");
-
-    } else {
-        if(this->last_was_null) {
-            this->turn = !this->turn;
-            this->en_passent_target = this->prev_en_passent_target;
-            this->prev_en_passent_target = 0;
-            this->last_was_null = false;
-            this->undo_available = true;
-        } else {
-            for(int i=0;i<120;i++) {
-                this->board[i] = this->old_board[i];
+    }
+    const UndoInfo info = this->undo_stack.last();
+    this->undo_stack.removeLast();
+    const Move &m = info.move;
+    this->turn = !this->turn;
+    if(!m.is_null()) {
+        // the mover is on the target square, or
+        // was a pawn if the move is a promotion
+        uint8_t piece = this->board[m.to()];
+        if(m.promotion_piece() != EMPTY) {
+            piece = this->turn == WHITE ? PAWN : PAWN + 128;
+        }
+        this->set_square(m.from(), piece);
+        this->set_square(m.to(), info.captured);
+        uint8_t type = this->piece_type(m.from());
+        // put back the pawn captured en passent
+        if(type == PAWN && m.to() == info.en_passent_target) {
+            if(this->turn == WHITE) {
+                this->set_square(m.to() - 10, PAWN + 128);
+            } else {
+                this->set_square(m.to() + 10, PAWN);
             }
-            this->undo_available = false;
-            this->en_passent_target = this->prev_en_passent_target;
-            this->prev_en_passent_target = 0;
-            this->castling_rights = this->prev_castling_rights;
-            this->turn = !this->turn;
-            this->halfmove_clock = this->prev_halfmove_clock;
-            this->prev_halfmove_clock = 0;
-            if(this->turn == BLACK) {
-                this->fullmove_number--;
+        }
+        // move back the rook after castling
+        if(type == KING) {
+            if(m.from() == E1 && m.to() == G1) {
+                this->set_square(H1, this->board[F1]);
+                this->set_square(F1, EMPTY);
+            } else if(m.from() == E1 && m.to() == C1) {
+                this->set_square(A1, this->board[D1]);
+                this->set_square(D1, EMPTY);
+            } else if(m.from() == E8 && m.to() == G8) {
+                this->set_square(H8, this->board[F8]);
+                this->set_square(F8, EMPTY);
+            } else if(m.from() == E8 && m.to() == C8) {
+                this->set_square(A8, this->board[D8]);
+                this->set_square(D8, EMPTY);
             }
         }
+        if(this->turn == BLACK) {
+            this->fullmove_number--;
+        }
     }
+    this->castling_rights = info.castling_rights;
+    this->en_passent_target = info.en_passent_target;
+    this->halfmove_clock = info.halfmove_clock;
+    this->last_was_null = info.last_was_null;
+    this->zobrist_key = info.zobrist_key;
+}
+
+bool Board::is_undo_available() {
+    return !this->undo_stack.isEmpty();
 }
 
 // doesn't check legality
@@ -1556,87 +1708,102 @@ Board* Board::copy_and_apply(const Move &m) {
     b->en_passent_target = this->en_passent_target;
     b->halfmove_clock = this->halfmove_clock;
     b->fullmove_number = this->fullmove_number;
-    b->undo_available = this->undo_available;
     b->last_was_null = this->last_was_null;
-    b->prev_halfmove_clock = this->prev_halfmove_clock;
-    delete b->transpositionTable;
-    b->transpositionTable = new QMap<quint64, int>(*this->transpositionTable);
     for(int i=0;i<120;i++) {
         b->board[i] = this->board[i];
-        b->old_board[i] = this->old_board[i];
     }
+    for(int i=0;i<7;i++) {
+        b->piece_bb[i] = this->piece_bb[i];
+    }
+    for(int i=0;i<2;i++) {
+        b->color_bb[i] = this->color_bb[i];
+    }
+    b->zobrist_key = this->zobrist_key;
     b->apply(m);
-    b->update_transposition_table();
+    b->extend_history(this);
     return b;
 }
 
+// appends the key of this board to the history of the previous
+// board. If another board already continued that history (i.e.
+// this is a variation), the line forks into a new history
+void Board::extend_history(Board *previous) {
+    PositionHistory *h = previous->history;
+    if(h == 0 || h->keys.size() != previous->history_ply + 1) {
+        PositionHistory *fork = new PositionHistory();
+        if(h == 0) {
+            fork->keys.append(previous->zobrist());
+            // the previous board joins the new history, so that
+            // its other successors fork as well
+            fork->refs.ref();
+            previous->history = fork;
+            previous->history_ply = 0;
+            previous->history_start = 0;
+        } else {
+            // only positions since the last capture or pawn move are needed
+            fork->keys = h->keys.mid(previous->history_start, previous->history_ply - previous->history_start + 1);
+        }
+        h = fork;
+    }
+    h->refs.ref();
+    this->history = h;
+    this->history_ply = h->keys.size();
+    if(h == previous->history) {
+        this->history_start = previous->history_start;
+    } else {
+        this->history_start = 0;
+    }
+    if(this->halfmove_clock == 0 && !this->last_was_null) {
+        this->history_start = this->history_ply;
+    }
+    h->keys.append(this->zobrist());
+}
+
 bool Board::is_stalemate() {
     // search for king of player with current turn
     // check whether king is attacked
-    for(int i=21;i<99;i++) {
-        if((this->piece_type(i)==KING) && (this->piece_color(i)==this->turn)){
-            if(!this->is_attacked(i,!this->turn)) {
-                Moves* legals = this->legal_moves();
-                int c = legals->count();
-                legals->clear();
-                delete legals;
-                if(c==0) {
-                    return true;
-                } else {
-                    return false;
-                }
-            } else {
-                return false;
-            }
+    int king = this->king_square(this->turn);
+    if(king >= 0 && !this->is_attacked(SQUARE_120[king],!this->turn)) {
+        if(!this->has_legal_move()) {
+            return true;
         }
     }
     return false;
 }
 
 bool Board::is_threefold_repetition() {
-    quint64 current_zobrist = this->zobrist();
-    if(this->transpositionTable->contains(current_zobrist)) {
-        int cnt = this->transpositionTable->value(current_zobrist);
-        return cnt >= 3;
-    } else {
+    if(this->history == 0) {
         return false;
     }
+    // scan back to the last capture or pawn move
+    quint64 current_zobrist = this->zobrist();
+    int cnt = 0;
+    for(int i=this->history_ply;i>=this->history_start;i--) {
+        if(this->history->keys.at(i) == current_zobrist) {
+            cnt++;
+        }
+    }
+    return cnt >= 3;
 }
 
 bool Board::is_checkmate() {
     // search for king of player with current turn
     // check whether king is attacked
-    for(int i=21;i<99;i++) {
-        if((this->piece_type(i)==KING) && (this->piece_color(i)==this->turn)){
-            if(this->is_attacked(i,!this->turn)) {
-                Moves* legals = this->legal_moves();
-                int c = legals->count();
-                legals->clear();
-                delete legals;
-                if(c==0) {
-                    return true;
-                } else {
-                    return false;
-                }
-            } else {
-                return false;
-            }
+    int king = this->king_square(this->turn);
+    if(king >= 0 && this->is_attacked(SQUARE_120[king],!this->turn)) {
+        if(!this->has_legal_move()) {
+            return true;
         }
     }
     return false;
 }
 
 bool Board::is_check() {
-    for(int i=21;i<99;i++) {
-        if((this->piece_type(i)==KING) && (this->piece_color(i)==this->turn)){
-            if(this->is_attacked(i,!this->turn)) {
-                return true;
-            } else {
-                return false;
-            }
-        }
+    int king = this->king_square(this->turn);
+    if(king < 0) {
+        return false;
     }
-    return false;
+    return this->is_attacked(SQUARE_120[king],!this->turn);
 }
 
 
@@ -1665,285 +1832,271 @@ uint8_t Board::alpha_to_pos(QChar alpha) {
 // otherwise might mess up the whole
 // current board
 QString Board::san(const Move &m) {
+    char san[SAN_BUFFER_SIZE];
+    int length = this->write_san(m, san);
+    return QString::fromLatin1(san, length);
+}
+
+// san letter of each piece type, pawns have none
+static const char SAN_PIECE_LETTERS[] = { 0, 0, 'N', 'B', 'R', 'Q', 'K' };
+
+// instead of generating all legal moves, only the other pieces of the same
+// type that attack the target square are checked for ambiguity
+int Board::write_san(const Move &m, char *san) {
 
-    QString san = QString("");
+    int n = 0;
     // first check for null move
-    if(m.is_null) {
-        san = QString("--");
-        return san;
+    if(m.is_null()) {
+        san[n++] = '-';
+        san[n++] = '-';
+        san[n] = '\0';
+        return n;
     }
 
-    // first test for checkmate and check (to be appended later)
-    // create temp board, since appyling move and
-    // testing for checkmate (which again needs
-    // application of a move) makes it impossible
-    // to undo (undo can only be done once, not twice in a row)
-    Board *b_temp = this->copy_and_apply(m);
-    bool is_check = b_temp->is_check();
-    bool is_checkmate = b_temp->is_checkmate();
-    delete b_temp;
-
     if(this->castles_wking(m) || this->castles_bking(m)) {
-        san.append("O-O");
-        if(is_checkmate) {
-            san.append("#");
-        }
-        if(is_check) {
-            san.append("+");
-        }
-        return san;
+        san[n++] = 'O';
+        san[n++] = '-';
+        san[n++] = 'O';
     } else if(this->castles_wqueen(m) || this->castles_bqueen(m)) {
-        san.append("O-O-O");
-        if(is_checkmate) {
-            san.append("#");
-        } else if(is_check) {
-            san.append("+");
-        }
-        return san;
+        san[n++] = 'O';
+        san[n++] = '-';
+        san[n++] = 'O';
+        san[n++] = '-';
+        san[n++] = 'O';
     } else {
-        uint8_t piece_type = this->piece_type(m.from);
-        Moves* legals = this->legal_moves();
-        if(piece_type == KNIGHT) {
-            san.append("N");
-        }
-        if(piece_type == BISHOP) {
-            san.append("B");
-        }
-        if(piece_type == ROOK) {
-            san.append("R");
-        }
-        if(piece_type == QUEEN) {
-            san.append("Q");
-        }
-        if(piece_type == KING) {
-            san.append("K");
-        }
-        Moves* col_disambig = new Moves();
-        Moves* row_disambig = new Moves();
-        int this_row = (m.from / 10) - 1;
-        int this_col = m.from % 10;
-
-        // find amibguous moves (except for pawns)
+        uint8_t piece_type = this->piece_type(m.from());
+        int from = m.from_square();
+        int to = m.to_square();
         if(piece_type != PAWN) {
-            for(int i=0;i<legals->count();i++) {
-                Move mi = legals->at(i);
-                if(this->piece_type(mi.from) == piece_type && mi.to == m.to && mi.from != m.from) {
-                    // found pontential amibg. move
-                    if((mi.from % 10) != this_col) {
-                        // can be resolved via row
-                        col_disambig->append(mi);
-                    } else { // otherwise resolve by col
-                        row_disambig->append(mi);
-                    }
+            san[n++] = SAN_PIECE_LETTERS[piece_type];
+
+            // find amibguous moves, i.e. other pieces of the same
+            // type that can legally move to the target square
+            Bitboard occupied = this->color_bb[WHITE] | this->color_bb[BLACK];
+            Bitboard others = 0;
+            if(piece_type == KNIGHT) {
+                others = KNIGHT_ATTACKS[to];
+            } else if(piece_type == BISHOP) {
+                others = bishop_attacks(to, occupied);
+            } else if(piece_type == ROOK) {
+                others = rook_attacks(to, occupied);
+            } else if(piece_type == QUEEN) {
+                others = bishop_attacks(to, occupied) | rook_attacks(to, occupied);
+            } else {
+                others = KING_ATTACKS[to];
+            }
+            others &= this->piece_bb[piece_type] & this->color_bb[this->turn] & ~square_bb(from);
+            int cnt_col_disambig = 0;
+            int cnt_row_disambig = 0;
+            while(others != 0) {
+                int other = pop_square(others);
+                if(!this->pseudo_is_legal_move(Move::from_squares(other, to))) {
+                    continue;
+                }
+                if((other % 8) != (from % 8)) {
+                    // can be resolved via col
+                    cnt_col_disambig++;
+                } else { // otherwise resolve by row
+                    cnt_row_disambig++;
                 }
             }
-            int cnt_col_disambig = col_disambig->count();
-            //cout << "ambig cols: " << +cnt_col_disambig << endl;
-            int cnt_row_disambig = row_disambig->count();
-            //cout << "ambig rows: " << +cnt_row_disambig << endl;
-            row_disambig->clear();
-            col_disambig->clear();
-            delete row_disambig;
-            delete col_disambig;
-            // if there is an ambiguity
-            if(cnt_col_disambig != 0 || cnt_row_disambig != 0) {
-                // preferred way: resolve via column
-                if(cnt_col_disambig>0 && cnt_row_disambig==0) {
-                    san.append(QChar(this_col + 96));
-                    // if not try to resolve via row
-                } else if(cnt_row_disambig>0 && cnt_col_disambig==0) {
-                    san.append(QChar(this_row + 48));
+            // preferred way: resolve via column, if not try to resolve
+            // via row, and if that also fails (think three queens)
+            // resolve via full coordinate
+            if(cnt_col_disambig > 0 || cnt_row_disambig > 0) {
+                if(cnt_row_disambig == 0) {
+                    san[n++] = char('a' + from % 8);
+                } else if(cnt_col_disambig == 0) {
+                    san[n++] = char('1' + from / 8);
                 } else {
-                    // if that also fails (think three queens)
-                    // resolve via full coordinate
-                    san.append(QChar(this_col + 96));
-                    san.append(QChar(this_row + 48));
+                    san[n++] = char('a' + from % 8);
+                    san[n++] = char('1' + from / 8);
                 }
             }
-        } else {
-            delete col_disambig;
-            delete row_disambig;
         }
-        legals->clear();
-        delete legals;
 
         // handle a capture, i.e. if destination field
         // is not empty
-        if(this->piece_type(m.to) != EMPTY) {
+        if(this->piece_type(m.to()) != EMPTY) {
             if(piece_type == PAWN) {
-                san.append(QChar(this_col + 96));
+                san[n++] = char('a' + from % 8);
             }
-            san.append(QString("x"));
-        }
-        //qDebug() << "calling idx to str: ";
-        //qDebug() << "san append: " << m.to;
-        //qDebug() << m.uci_string;
-        //qDebug() << "--";
-        san.append(this->idx_to_str(m.to));
-        if(m.promotion_piece == KNIGHT) {
-            san.append(("=N"));
-        }
-        if(m.promotion_piece == BISHOP) {
-            san.append(("=B"));
-        }
-        if(m.promotion_piece == ROOK) {
-            san.append(("=R"));
+            san[n++] = 'x';
         }
-        if(m.promotion_piece == QUEEN) {
-            san.append(("=Q"));
+        san[n++] = char('a' + to % 8);
+        san[n++] = char('1' + to / 8);
+        if(m.promotion_piece() != 0) {
+            san[n++] = '=';
+            san[n++] = SAN_PIECE_LETTERS[m.promotion_piece()];
         }
     }
+
+    // test for checkmate and check by applying the move and
+    // taking it back again. mate is only tested if in check
+    this->apply(m);
+    bool is_check = this->is_check();
+    bool is_checkmate = is_check && !this->has_legal_move();
+    this->undo();
     if(is_checkmate) {
-        san.append("#");
+        san[n++] = '#';
     } else if(is_check) {
-        san.append("+");
+        san[n++] = '+';
     }
-    return san;
+    san[n] = '\0';
+    return n;
 }
 
 Move Board::parse_san(QString san) {
+    return this->parse_san(san.constData(), san.length());
+}
+
+static uint8_t san_piece_type(ushort c) {
+    switch(c) {
+    case 'N': return KNIGHT;
+    case 'B': return BISHOP;
+    case 'R': return ROOK;
+    case 'Q': return QUEEN;
+    case 'K': return KING;
+    default: return EMPTY;
+    }
+}
+
+// reads the characters directly instead of matching a regular expression,
+// and instead of generating all legal moves, only the pieces of the given
+// type that can reach the target square are considered
+Move Board::parse_san(const QChar *san, int length) {
 
     // first check if null move
-    if(san==QString("--")) {
-        Move m = Move();
-        return m;
-    }
-
-    Move m = Move(0,0);
-    Moves* legals = this->legal_moves();
-
-    // check for castling moves
-    if(san==QString("O-O") || san == QString("O-O+") || san==QString("O-O#")) {
-        for(int i=0;i<legals->count();i++) {
-            Move m = legals->at(i);
-            if(this->castles_wking(m)) {
-                legals->clear();
-                delete legals;
-                return Move(E1,G1);
-            } else if(this->castles_bking(m)) {
-                delete legals;
-                return Move(E8,G8);
-            }
-        }
-    } else if(san==QString("O-O-O") || san == QString("O-O-O+") || san==QString("O-O-O#")) {
-        //qDebug() << "castles long";
-        for(int i=0;i<legals->count();i++) {
-            Move m = legals->at(i);
-            if(this->castles_wqueen(m)) {
-                legals->clear();
-                delete legals;
-                return Move(E1,C1);
-            } else if(this->castles_bqueen(m)) {
-                delete legals;
-                return Move(E8,C8);
-            }
+    if(length == 2 && san[0].unicode() == '-' && san[1].unicode() == '-') {
+        return Move();
+    }
+
+    // a check or mate marker is optional and ignored
+    int end = length;
+    if(end > 0 && (san[end-1].unicode() == '+' || san[end-1].unicode() == '#')) {
+        end--;
+    }
+
+    // check for castling moves, also accept zeros instead of O
+    ushort o = length > 0 ? san[0].unicode() : 0;
+    if((o == 'O' || o == '0') && (end == 3 || end == 5) && san[1].unicode() == '-' && san[2].unicode() == o
+            && (end == 3 || (san[3].unicode() == '-' && san[4].unicode() == o))) {
+        bool white = this->turn == WHITE;
+        Move m = end == 3 ? (white ? Move(E1,G1) : Move(E8,G8)) : (white ? Move(E1,C1) : Move(E8,C8));
+        bool castles = end == 3 ? (this->castles_wking(m) || this->castles_bking(m))
+                                : (this->castles_wqueen(m) || this->castles_bqueen(m));
+        if(castles && this->is_legal_move(m)) {
+            return m;
         }
-    } else { // we don't have a castles move
-        QRegularExpressionMatch match = SAN_REGEX.match(san);
-        if(!match.hasMatch()) {
-            throw std::invalid_argument("invalid san: "+san.toStdString());
-        }
-        // get target square
-        QString str_target = match.captured(4).toUpper();
-        uint8_t target_col = this->alpha_to_pos(str_target.at(0));
-        // -49 for ascii(1) -> int 0
-        uint8_t target_row = (uint8_t) ((str_target.at(1).toLatin1()-49)+1);
-        uint8_t target = ((target_row+1) * 10)+target_col;
-
-        // get promotion piece
-        QString str_prom = match.captured(5);
-        if(!str_prom.isNull()) {
-            //std::cout << match.captured(5).toStdString() << std::endl;
-            if(match.captured(5)==QString("=N")) {
-                m.promotion_piece = KNIGHT;
-            } else if(match.captured(5)==QString("=B")) {
-                m.promotion_piece = BISHOP;
-            } else if(match.captured(5)==QString("=R")) {
-                m.promotion_piece = ROOK;
-            } else if(match.captured(5)==QString("=Q")) {
-                m.promotion_piece = QUEEN;
-            } else {
-                throw std::invalid_argument("invalid san / promotion: "+match.captured(5).toStdString());
+        // castling was given, but isn't possible
+        throw std::invalid_argument("invalid san: "+QString(san, length).toStdString());
+    }
+
+    // get piece type
+    int pos = 0;
+    uint8_t piece_type = pos < end ? san_piece_type(san[pos].unicode()) : EMPTY;
+    if(piece_type != EMPTY) {
+        pos++;
+    } else {
+        piece_type = PAWN;
+    }
+
+    // get promotion piece. promotion piece _only_ encodes piece, _not_ color
+    uint8_t promotion_piece = 0;
+    if(end > pos) {
+        ushort c = san[end-1].unicode();
+        if(c == 'n' || c == 'b' || c == 'r' || c == 'q' || c == 'N' || c == 'B' || c == 'R' || c == 'Q') {
+            promotion_piece = san_piece_type(c);
+            if(promotion_piece == EMPTY || end - 2 < pos || san[end-2].unicode() != '=') {
+                throw std::invalid_argument("invalid san / promotion: "+QString(san, length).toStdString());
             }
-            //if(this->turn == BLACK) {
-            //    m.promotion_piece += 0x80;
-            //}  NO: promotion piece _only_ encodes piece, _not_ color
-        }
-        // get piece type
-        uint8_t piece_type = 0;
-        if(match.captured(1) == QString("B")) {
-            piece_type = BISHOP;
-        } else if(match.captured(1) == QString("N")) {
-            piece_type = KNIGHT;
-        } else if(match.captured(1) == QString("R")) {
-            piece_type = ROOK;
-        } else if(match.captured(1) == QString("Q")) {
-            piece_type = QUEEN;
-        } else if(match.captured(1) == QString("K")) {
-            piece_type = KING;
-        } else {
-            piece_type = PAWN;
+            end -= 2;
         }
+    }
 
-        // get target square
-        uint8_t src_col = 0;
-        uint8_t src_row = 0;
-        QString str_amb_col = match.captured(2).toUpper();
-        if(!str_amb_col.isNull()) {
-            src_col = this->alpha_to_pos(str_amb_col.at(0));
-        }
-        QString str_amb_row = match.captured(3).toUpper();
-        if(!str_amb_row.isNull()) {
-            src_row = (uint8_t) ((str_amb_row.at(0).toLatin1()-49) +1);
-        }
+    // get target square
+    if(end - pos < 2 || san[end-2].unicode() < 'a' || san[end-2].unicode() > 'h'
+            || san[end-1].unicode() < '1' || san[end-1].unicode() > '8') {
+        throw std::invalid_argument("invalid san: "+QString(san, length).toStdString());
+    }
+    int target = (san[end-1].unicode() - '1') * 8 + (san[end-2].unicode() - 'a');
+    end -= 2;
+
+    // optional source file and rank for disambiguation, and capture
+    Bitboard sources = this->piece_bb[piece_type] & this->color_bb[this->turn];
+    if(pos < end && san[pos].unicode() >= 'a' && san[pos].unicode() <= 'h') {
+        sources &= Q_UINT64_C(0x0101010101010101) << (san[pos].unicode() - 'a');
+        pos++;
+    }
+    if(pos < end && san[pos].unicode() >= '1' && san[pos].unicode() <= '8') {
+        sources &= Q_UINT64_C(0xFF) << (8 * (san[pos].unicode() - '1'));
+        pos++;
+    }
+    if(pos < end && san[pos].unicode() == 'x') {
+        pos++;
+    }
+    if(pos != end) {
+        throw std::invalid_argument("invalid san: "+QString(san, length).toStdString());
+    }
 
-        if(m.promotion_piece!=0) {
-            //std::cout << "is WHITE: " << +(this->turn==WHITE) << std::endl;
+    // the pieces that can reach the target. pawns and the king
+    // have special moves, so their moves are generated
+    Bitboard occupied = this->color_bb[WHITE] | this->color_bb[BLACK];
+    Bitboard candidates = 0;
+    if(piece_type == PAWN) {
+        int behind = this->turn == WHITE ? target - 8 : target + 8;
+        int two_behind = this->turn == WHITE ? target - 16 : target + 16;
+        candidates = PAWN_ATTACKS[!this->turn][target];
+        if(behind >= 0 && behind < 64) {
+            candidates |= square_bb(behind);
         }
-        // filter all moves
-        Moves lgl_piece = Moves();
-        for(int i=0;i<legals->count();i++) {
-            Move mi = legals->at(i);
-            if(m.promotion_piece!=0) {
-             //std::cout << mi.uci().toStdString() << std::endl;
-             //std::cout << "  mi: " << +mi.promotion_piece << std::endl;
-             //std::cout << "  m: " << +m.promotion_piece << std::endl;
-            }
-            uint8_t mi_row = (mi.from / 10) - 1;
-            uint8_t mi_col = mi.from % 10;
-            if(target == mi.to && this->piece_type(mi.from) == piece_type
-                    && mi.promotion_piece == m.promotion_piece) {
-                if(src_col == 0 && src_row == 0) {
-                    lgl_piece.append(mi);
-                } else if(src_col !=0 && src_row ==0 && mi_col == src_col) {
-                    lgl_piece.append(mi);
-                } else if(src_col ==0 && src_row !=0 && mi_row == src_row) {
-                    lgl_piece.append(mi);
-                } else if(src_col !=0 && src_row !=0 && mi_row == src_row && mi_col == src_col) {
-                    lgl_piece.append(mi);
+        if(two_behind >= 0 && two_behind < 64) {
+            candidates |= square_bb(two_behind);
+        }
+    } else if(piece_type == KNIGHT) {
+        candidates = KNIGHT_ATTACKS[target];
+    } else if(piece_type == BISHOP) {
+        candidates = bishop_attacks(target, occupied);
+    } else if(piece_type == ROOK) {
+        candidates = rook_attacks(target, occupied);
+    } else if(piece_type == QUEEN) {
+        candidates = bishop_attacks(target, occupied) | rook_attacks(target, occupied);
+    } else {
+        candidates = ~Bitboard(0);
+    }
+    candidates &= sources;
+    if(this->color_bb[this->turn] & square_bb(target)) {
+        candidates = 0;
+    }
+
+    // exactly one of the candidates must have a legal move
+    // to the target, otherwise the san is wrong or ambiguous
+    Move found;
+    int count = 0;
+    while(candidates != 0) {
+        int from = pop_square(candidates);
+        if(piece_type == PAWN || piece_type == KING) {
+            MoveList moves;
+            this->pseudo_legal_moves_from(SQUARE_120[from], true, this->turn, &moves);
+            for(const Move &m : moves) {
+                if(m.to_square() == target && m.promotion_piece() == promotion_piece
+                        && this->pseudo_is_legal_move(m)) {
+                    found = m;
+                    count++;
                 }
             }
-        }
-        if(m.promotion_piece != 0 && lgl_piece.count() > 1) {
-            //std::cout << "there are too many moves!" << std::endl;
-        }
-
-        // now lgl_piece should contain only one move, since
-        // all ambigiuous have been filtered. otherwise san is wrong
-        if(lgl_piece.count() > 1 || lgl_piece.count() == 0) {
-            //std::cout << *this << std::endl;
-            //std::cout << +this->fullmove_number << std::endl;
-            throw std::invalid_argument("invalid san / ambiguous: "+san.toStdString());
-        } else {
-            Move mi = lgl_piece.at(0);
-            m.from = mi.from;
-            m.to = mi.to;
-            m.promotion_piece = mi.promotion_piece;
-            m.uci_string = mi.uci_string;
+        } else if(promotion_piece == 0) {
+            Move m = Move::from_squares(from, target);
+            if(this->pseudo_is_legal_move(m)) {
+                found = m;
+                count++;
+            }
         }
     }
-    delete legals;
-    return m;
+    if(count != 1) {
+        throw std::invalid_argument("invalid san / ambiguous: "+QString(san, length).toStdString());
+    }
+    return found;
 }
 
 /**
@@ -2247,17 +2400,26 @@ int Board::zobrist_piece_type(uint8_t piece) {
     throw std::invalid_argument("piece type out of range in ZobristHash:kind_of_piece");
 }
 
-void Board::update_transposition_table() {
-    quint64 current_zobrist = this->zobrist();
-    if(this->transpositionTable->contains(current_zobrist)) {
-        int cnt = this->transpositionTable->value(current_zobrist);
-        this->transpositionTable->insert(current_zobrist, cnt+1);
-    } else {
-        this->transpositionTable->insert(current_zobrist, 1);
+quint64 Board::zobrist() {
+    quint64 key = this->zobrist_key;
+    // en passent only counts if a pawn of the player
+    // to move can capture, cf. compute_zobrist()
+    if(this->en_passent_target != 0) {
+        Bitboard pawns = this->piece_bb[PAWN] & this->color_bb[this->turn];
+        if(PAWN_ATTACKS[!this->turn][SQUARE_64[this->en_passent_target]] & pawns) {
+            key ^= POLYGLOT_RANDOM_64[RANDOM_EN_PASSENT + (this->en_passent_target % 10) - 1];
+        }
+    }
+    if(this->turn == WHITE) {
+        key ^= POLYGLOT_RANDOM_64[RANDOM_TURN];
     }
+    Q_ASSERT(key == this->compute_zobrist());
+    return key;
 }
 
-quint64 Board::zobrist() {
+// full computation of the hash key, used to cross-check
+// the incrementally updated key in debug builds
+quint64 Board::compute_zobrist() {
     Board *b = this;
     quint64 piece = Q_UINT64_C(0);
     for(int i=0;i<8;i++) {
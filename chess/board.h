@@ -23,9 +23,12 @@
 
 
 #include <cstdint>
-#include <QRegularExpression>
-#include <QMap>
+#include <QVector>
+#include <QVarLengthArray>
+#include <QAtomicInt>
 #include "move.h"
+#include "move_list.h"
+#include "bitboard.h"
 
 namespace chess {
 
@@ -218,10 +221,39 @@ const uint8_t BLACK_BISHOP = 0x83;
 const uint8_t BLACK_KNIGHT = 0x82;
 const uint8_t BLACK_PAWN = 0x81;
 
-const QRegularExpression FEN_CASTLES_REGEX = QRegularExpression("^-|[KQABCDEFGH]{0,2}[kqabcdefgh]{0,2}$");
-const QRegularExpression SAN_REGEX = QRegularExpression("^([NBKRQ])?([a-h])?([1-8])?x?([a-h][1-8])(=?[nbrqNBRQ])?(\\+|#)?$");
+// longest fen is the board (71), turn, castling rights, e.p. square
+// and two ten digit numbers with separating spaces, plus the '\0'
+const int FEN_BUFFER_SIZE = 128;
 
-typedef QList<Move> Moves;
+// longest san is seven characters (e.g. Qa1xb2+ or exd8=Q#), plus the '\0'
+const int SAN_BUFFER_SIZE = 8;
+
+/**
+ * @brief PositionHistory hash keys of the positions of a line of play,
+ *        indexed by ply. Shared by all boards of the line (each board
+ *        created by copy_and_apply() appends its key), and only
+ *        appended to. Used to detect repetitions.
+ */
+struct PositionHistory
+{
+    QVector<quint64> keys;
+    QAtomicInt refs;
+};
+
+/**
+ * @brief UndoInfo what undo() needs to take back a move: the move itself,
+ *        the captured piece and the state that apply() overwrites
+ */
+struct UndoInfo
+{
+    quint64 zobrist_key;
+    int halfmove_clock;
+    Move move;
+    uint8_t captured;
+    uint8_t castling_rights;
+    uint8_t en_passent_target;
+    bool last_was_null;
+};
 
 class Board
 {
@@ -268,6 +300,16 @@ public:
      */
     Board(const QString &fen_string);
 
+    /**
+     * @brief Board creates board from FEN string, same as above, but reads
+     *        the FEN from a span of bytes, e.g. the FEN of a DCG encoded game.
+     *        Castling rights may also be given as rook files (Shredder-FEN,
+     *        X-FEN). Throws std::invalid_argument if the FEN is invalid
+     * @param fen first byte of the FEN string
+     * @param length number of bytes
+     */
+    Board(const char *fen, int length);
+
     /**
      * @brief Board creates new Board copying position of the pieces of the supplied
      *              board. Parameters (i.e. undo history, move numbers etc. are _not_
@@ -287,9 +329,19 @@ public:
      */
     QString fen();
 
+    /**
+     * @brief write_fen same as above, but writes the FEN into the supplied buffer
+     *        instead of allocating a string
+     * @param fen buffer of at least FEN_BUFFER_SIZE chars, '\0' terminated afterwards
+     * @return length of the FEN
+     */
+    int write_fen(char *fen);
+
     /**
      * @brief copy_and_apply applies move and returns a deep copy of current board
-     *        no check of legality. always call board.is_legal(m) before applying move
+     *        no check of legality. always call board.is_legal(m) before applying move.
+     *        The undo history is not copied, i.e. only the supplied move can be undone
+     *        on the returned board
      * @param m move to apply
      * @return copy of board
      */
@@ -303,10 +355,10 @@ public:
     void apply(const Move &m);
 
     /**
-     * @brief undo undoes the very last move. undoing can only be done once for the very
-     *             last move that was applied before, i.e. apply undo apply undo is ok,
-     *             but apply apply undo undo is not. throws logic error if called
-     *             in wrong fashion. check with is_undo_available() when in doubt
+     * @brief undo undoes the very last move that was applied. Can be called repeatedly,
+     *             i.e. apply apply undo undo is ok, and returns to the position before
+     *             both moves. throws logic error if there is no move to undo.
+     *             check with is_undo_available() when in doubt
      */
     void undo();
 
@@ -315,7 +367,7 @@ public:
      *                           current position
      * @return
      */
-    Moves* pseudo_legal_moves();
+    MoveList pseudo_legal_moves();
 
     /**
      * @brief pseudo_legal_moves_from returns move list with pseudo legal moves
@@ -327,20 +379,31 @@ public:
      * @param turn_color              either WHITE or BLACK, i.e. the player to move
      * @return pseudo legal move list
      */
-    Moves* pseudo_legal_moves_from(int from_square_idx, bool with_castles, bool turn_color);
+    MoveList pseudo_legal_moves_from(int from_square_idx, bool with_castles, bool turn_color);
+
+    /**
+     * @brief pseudo_legal_moves_from same as above, but appends the moves to
+     *                                the supplied list
+     */
+    void pseudo_legal_moves_from(int from_square_idx, bool with_castles, bool turn_color, MoveList *moves);
 
     /**
      * @brief legal_moves returns move list of all legal moves in position
      * @return move list
      */
-    Moves* legal_moves();
+    MoveList legal_moves();
+
+    /**
+     * @brief legal_moves appends all legal moves in position to the supplied list
+     */
+    void legal_moves(MoveList *moves);
 
     /**
      * @brief legal_moves_from computes all legal moves originating in from square
      * @param from_square  move originates from this square. must be in range 21...98
      * @return move list of legal moves
      */
-    Moves* legal_moves_from(int from_square);
+    MoveList legal_moves_from(int from_square);
 
     /**
      * @brief pseudo_is_legal_move checks whether supplied pseudo legal move is legal
@@ -395,6 +458,16 @@ public:
      */
     QString san(const Move &m);
 
+    /**
+     * @brief write_san same as above, but writes the san into the supplied buffer
+     *        instead of allocating a string. the supplied move MUST be legal on this
+     *        board
+     * @param m Move to get the san for
+     * @param san buffer of at least SAN_BUFFER_SIZE chars, '\0' terminated afterwards
+     * @return length of the san
+     */
+    int write_san(const Move &m, char *san);
+
     /**
      * @brief parse_san Given board position and san string, parses the san string
      *        and computes a move for it. Throws std::invalid_argument if the
@@ -405,6 +478,15 @@ public:
      */
     Move parse_san(QString s);
 
+    /**
+     * @brief parse_san same as above, but reads the san from a span of characters,
+     *        e.g. a token of the tokenized movetext, without copying it
+     * @param san first character of the san
+     * @param length number of characters
+     * @return move object (if parsed successfully)
+     */
+    Move parse_san(const QChar *san, int length);
+
     /**
      * @brief movePromotes checks if the supplied move (ignoring the promotion value stored
      *                     in the move is a pawn move to the 8th / 1st rank, i.e. promoting)
@@ -597,6 +679,13 @@ public:
     bool can_claim_fifty_moves();
     bool is_threefold_repetition();
 
+    /**
+     * @brief zobrist returns the polyglot hash key of the position. The key is
+     *                updated incrementally by apply() and undo(), so this
+     *                is cheap to call. In debug builds the key is cross-checked
+     *                against a full recomputation
+     * @return hash key
+     */
     quint64 zobrist();
 
 private:
@@ -614,15 +703,24 @@ private:
      * essentially linearized 10x12 array
      */
     uint8_t board[120];
+
     /**
-     * @brief old_board stores the previous position for undo()
+     * @brief piece_bb squares of the pieces of each type (index PAWN ... KING),
+     *                 of both colors. Kept in sync with board
      */
-    uint8_t old_board[120];
+    Bitboard piece_bb[7];
 
     /**
-     * @brief turn is either WHITE or BLACK
+     * @brief color_bb squares of the pieces of each color (index WHITE, BLACK)
      */
-    bool undo_available;
+    Bitboard color_bb[2];
+
+    /**
+     * @brief undo_stack one entry for each move applied by apply(), last
+     *                   move on top. Most boards only ever apply one or two
+     *                   moves, which are stored without allocation
+     */
+    QVarLengthArray<UndoInfo, 2> undo_stack;
 
     /**
      * @brief castling_rights stores the castling rights
@@ -631,34 +729,79 @@ private:
      * and CASTLE_BQUEEN_POS
      */
     uint8_t castling_rights;
-    uint8_t prev_castling_rights;
 
     uint8_t en_passent_target;
-    uint8_t prev_en_passent_target;
 
-    int prev_halfmove_clock;
+    /**
+     * @brief zobrist_key hash key of the pieces and the castling rights,
+     *                    kept up to date by set_square() and the castling
+     *                    setters. Side to move and en passent are added by zobrist()
+     */
+    quint64 zobrist_key;
+
+    /**
+     * @brief LegalityMasks restrictions on the moves of the side to move,
+     *                     computed once per position. A pseudo legal move
+     *                     that is not a king move, not en passent and not
+     *                     by a pinned piece is legal iff its target is in evasions
+     */
+    struct LegalityMasks
+    {
+        int king;
+        Bitboard pinned;
+        Bitboard evasions;
+    };
 
+    void compute_legality_masks(LegalityMasks *masks);
+    bool pseudo_is_legal_move(const Move &m, const LegalityMasks &masks);
+    bool has_legal_move();
     bool is_empty(uint8_t idx);
     bool is_offside(uint8_t idx);
     bool is_white_at(uint8_t idx);
     bool is_attacked(int idx, bool attacker_color);
+    bool is_attacked(int square, bool attacker_color, Bitboard occupied, Bitboard attackers);
+    int king_square(bool color);
+    void set_square(uint8_t idx, uint8_t piece);
+    void sync_bitboards();
     bool castles_wking(const Move &m);
     bool castles_bking(const Move &m);
     bool castles_wqueen(const Move &m);
     bool castles_bqueen(const Move &m);
     uint8_t piece_from_symbol(QChar c);
+    void parse_fen(const char *fen, int length);
     QChar piece_to_symbol(uint8_t idx);
     QString idx_to_str(int idx);
     uint8_t alpha_to_pos(QChar alpha);
 
-    QMap<quint64, int> *transpositionTable;
+    /**
+     * @brief history keys of the positions that lead to this board, shared
+     *                with the other boards of the line. 0 if the board
+     *                was not created by copy_and_apply() and has no successors yet
+     */
+    PositionHistory *history;
+
+    /**
+     * @brief history_ply index of the key of this board in history
+     */
+    int history_ply;
+
+    /**
+     * @brief history_start index of the first position after the last
+     *                      capture or pawn move. Earlier positions can't repeat
+     */
+    int history_start;
 
     int zobrist_piece_type(uint8_t piece);
+    quint64 compute_zobrist();
+    void set_castling_rights(uint8_t rights);
 
-    void update_transposition_table();
+    void extend_history(Board *previous);
 
     friend std::ostream& operator<<(std::ostream& strm, const Board &b);
 
+    // boards share their history, use copy_and_apply() or a FEN copy
+    Q_DISABLE_COPY(Board)
+
 };
 
 }
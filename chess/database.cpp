@@ -1,6 +1,9 @@
 #include "database.h"
 #include "chess/game.h"
 #include "chess/pgn_reader.h"
+#include "chess/pgn_scanner.h"
+#include "chess/pgn_decompressor.h"
+#include "chess/pgn_block_reader.h"
 #include "chess/dcgencoder.h"
 #include "chess/byteutil.h"
 #include "assert.h"
@@ -9,6 +12,71 @@
 #include <QDataStream>
 #include <QDebug>
 
+namespace chess {
+
+/**
+ * @brief PgnGamePass one pass over the games of a PGN file. Plain files are
+ *        mapped as a whole (cf. PgnScanner). Compressed files are decompressed
+ *        block by block (cf. PgnBlockReader), so that only two blocks are in
+ *        memory at a time instead of the whole decompressed file.
+ */
+class PgnGamePass
+{
+
+public:
+    PgnGamePass(const QString &pgnfile) {
+        this->blocks = 0;
+        this->blockOffset = 0;
+        if(PgnDecompressor::detect(pgnfile) != COMPRESSION_NONE) {
+            this->scanner = 0;
+            this->blocks = new PgnBlockReader(pgnfile);
+            this->blocks->start();
+        } else {
+            this->scanner = new PgnScanner(pgnfile);
+        }
+    }
+
+    ~PgnGamePass() {
+        delete this->scanner;
+        delete this->blocks;
+    }
+
+    // the span of the next game, relative to the data of scanner()
+    bool next(GameSpan *span) {
+        while((this->scanner == 0 || !this->scanner->hasNext()) && this->blocks != 0) {
+            delete this->scanner;
+            this->scanner = 0;
+            if(!this->blocks->nextBlock(&this->block, &this->blockOffset)) {
+                return false;
+            }
+            this->scanner = new PgnScanner(this->block.constData(), this->block.size());
+        }
+        if(this->scanner == 0 || !this->scanner->hasNext()) {
+            return false;
+        }
+        *span = this->scanner->next();
+        return true;
+    }
+
+    PgnScanner* current() {
+        return this->scanner;
+    }
+
+    // offset of the data of current() in the (decompressed) file
+    qint64 offset() {
+        return this->blockOffset;
+    }
+
+private:
+    PgnScanner *scanner;
+    PgnBlockReader *blocks;
+    QByteArray block;
+    qint64 blockOffset;
+
+};
+
+}
+
 chess::Database::Database(QString &filename)
 {
     this->filenameBase = filename;
@@ -296,6 +364,9 @@ void chess::Database::importPgnNamesSites(QString &pgnfile, QMap<QString, quint3
     const char* encoding = pgnreader->detect_encoding(pgnfile);
 
     chess::HeaderOffset* header = new chess::HeaderOffset();
+    // reused for all games. values refer to the scanner's data
+    header->headers = new chess::PgnHeaders();
+    chess::PgnGamePass pass(pgnfile);
 
     quint64 offset = 0;
     bool stop = false;
@@ -307,11 +378,14 @@ void chess::Database::importPgnNamesSites(QString &pgnfile, QMap<QString, quint3
             std::cout << "\rscanning at " << offset;
         }
         i++;
-        int res = pgnreader->readNextHeader(pgnfile, encoding, &offset, header);
-        if(res < 0) {
+        chess::GameSpan span;
+        if(!pass.next(&span)) {
             stop = true;
             continue;
         }
+        offset = pass.offset() + span.offset;
+        header->offset = offset;
+        pass.current()->readHeaders(span, encoding, header->headers);
         // below 4294967295 is the max range val of quint32
         // provided as default key during search. In case we get this
         // default key as return, the current db site and name maps do not contain
@@ -348,12 +422,9 @@ void chess::Database::importPgnNamesSites(QString &pgnfile, QMap<QString, quint3
                 }
             }
         }
-        header->headers->clear();
-        if(header->headers!=0) {
-           delete header->headers;
-        }
     }
     std::cout << std::endl << "scanning finished" << std::flush;
+    delete header->headers;
     delete header;
 }
 
@@ -433,6 +504,9 @@ void chess::Database::importPgnAppendGamesIndices(QString &pgnfile, QMap<QString
 
     // now save everything
     chess::HeaderOffset *header = new chess::HeaderOffset();
+    // reused for all games. values refer to the scanner's data
+    header->headers = new chess::PgnHeaders();
+    chess::PgnGamePass pass(pgnfile);
     quint64 offset = 0;
     QFile pgnFile(pgnfile);
     quint64 size = pgnFile.size();
@@ -458,11 +532,14 @@ void chess::Database::importPgnAppendGamesIndices(QString &pgnfile, QMap<QString
                     std::cout << "\rsaving games: "<<offset<< "/"<<size << std::flush;
                 }
                 i++;
-                int res = pgnreader->readNextHeader(pgnfile, encoding, &offset, header);
-                if(res < 0) {
+                chess::GameSpan span;
+                if(!pass.next(&span)) {
                     stop = true;
                     continue;
                 }
+                offset = pass.offset() + span.offset;
+                header->offset = offset;
+                pass.current()->readHeaders(span, encoding, header->headers);
                 // the current index entry
                 QByteArray iEntry;
                 // first write index entry
@@ -549,16 +626,15 @@ void chess::Database::importPgnAppendGamesIndices(QString &pgnfile, QMap<QString
                 assert(iEntry.size() == 35);
                 fnIndex.write(iEntry, iEntry.length());
                 //qDebug() << "just before reading back file";
-                chess::Game *g = pgnreader->readGameFromFile(pgnfile, encoding, header->offset);
+                // from the bytes in memory, w/o opening and
+                // seeking (or decompressing) the file again
+                chess::Game *g = pgnreader->readGameFromBytes(pass.current()->data() + span.offset,
+                                                              span.length, encoding);
                 //qDebug() << "READ file ok";
                 QByteArray *g_enc = dcgencoder->encodeGame(g); //"<<<<<<<<<<<<<<<<<<<<<< this is the cause of mem acc fault"
                 //qDebug() << "enc ok";
                 fnGames.write(*g_enc, g_enc->length());
                 delete g_enc;
-                header->headers->clear();
-                if(header->headers!=0) {
-                    delete header->headers;
-                }
                 delete g;
             }
             std::cout << "\rsaving games: "<<size<< "/"<<size << std::endl;
@@ -566,6 +642,7 @@ void chess::Database::importPgnAppendGamesIndices(QString &pgnfile, QMap<QString
         fnGames.close();
     }
     fnIndex.close();
+    delete header->headers;
     delete header;
 }
 
@@ -60,9 +60,11 @@ chess::Game* chess::DcgDecoder::decodeGame(Game *g, QByteArray *ba) {
     if(fenmarker == 0x01) {
         idx++;
         int len = this->decodeLength(ba, &idx);
-        QByteArray fen = ba->mid(idx, len);
-        QString fen_string = QString::fromUtf8(fen);
-        chess::Board *b = new chess::Board(fen_string);
+        // the fen is parsed in place, it must not exceed the game bytes
+        if(len < 0 || len > ba->size() - idx) {
+            throw std::invalid_argument("fen length exceeds the game bytes");
+        }
+        chess::Board *b = new chess::Board(ba->constData() + idx, len);
         g->getCurrentNode()->setBoard(b);
         idx += len;
     } else if(fenmarker == 0x00) {
@@ -108,26 +110,12 @@ chess::Game* chess::DcgDecoder::decodeGame(Game *g, QByteArray *ba) {
                 idx++;
             } else if(byte == 0x88) {
                 // null move
-                Move *m = new Move();
-                GameNode *next = new GameNode();
-                Board *b_next = 0;
-                try {
-                    Board *b = current->getBoard();
-                    b_next = b->copy_and_apply(*m);
-                    next->setMove(m);
-                    next->setBoard(b_next);
-                    next->setParent(current);
-                    current->addVariation(next);
-                    current = next;
-                } catch(std::invalid_argument a) {
-                    std::cerr << a.what() << std::endl;
-                    delete m;
-                    delete next;
-                    if(b_next != 0) {
-                        delete b_next;
-                    }
-                    error = true;
-                }
+                Move m = Move();
+                GameNode *next = new (g->getArena()) GameNode();
+                next->setMove(m);
+                next->setParent(current);
+                current->addVariation(next);
+                current = next;
                 idx++;
             } else {
                 error = true;
@@ -138,42 +126,26 @@ chess::Game* chess::DcgDecoder::decodeGame(Game *g, QByteArray *ba) {
             if(idx+1 >= ba->size()) {
                 error = true;
             } else {
+                // moves are stored in the same 16 bit encoding as chess::Move
                 quint16 move = byte*256 + quint8((ba->at(idx+1)));
-                quint8 from = quint8((move << 4) >> 10);
-                quint8 to = quint8((quint8(move) << 2)) >> 2;
-                // ((from % 8) + 1) is x column, (from/8) + 2 is row, cf.
-                // Spracklen: "First steps in chess programming", BYTE 1978
-                // for internal format
-                quint8 from_internal = ((from % 8) + 1) + (((from / 8) + 2) * 10);
-                quint8 to_internal = ((to % 8) + 1) + (((to / 8) + 2) * 10);
-                quint8 promotion_piece = quint8((move << 2) >> 14);
-                Move *m = new Move();
-                GameNode *next = new GameNode();
-                Board *b_next = 0;
+                Move m = Move::from_encoding(move);
+                GameNode *next = new (g->getArena()) GameNode();
                 try {
+                    // the boards of the nodes are computed on demand, from
+                    // the moves. the one of current is usually still cached
                     Board *b = current->getBoard();
-                    if(promotion_piece != 0) {
-                        m = new chess::Move(from_internal, to_internal, promotion_piece);
-                    } else {
-                        m = new chess::Move(from_internal, to_internal);
-                    }
-                    if(b->is_legal_move(*m)) {
-                        b_next = b->copy_and_apply(*m);
+                    if(b->is_legal_move(m)) {
                         next->setMove(m);
-                        next->setBoard(b_next);
                         next->setParent(current);
                         current->addVariation(next);
                         current = next;
                     } else {
+                        delete next;
                         error = true;
                     }
                 } catch(std::invalid_argument a) {
                     std::cerr << a.what() << std::endl;
-                    delete m;
                     delete next;
-                    if(b_next != 0) {
-                        delete b_next;
-                    }
                     error = true;
                 }
                 idx+=2;
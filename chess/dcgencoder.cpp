@@ -18,50 +18,40 @@ DcgEncoder::~DcgEncoder()
     delete this->gameBytes;
 }
 
-void DcgEncoder::traverseNodes(GameNode *current) {
-    int cntVar = current->getVariations()->count();
-
-    // first handle mainline move, if there are variations
-    if(cntVar > 0) {
-        GameNode* main_variation = current->getVariation(0);
-        this->appendMove(main_variation->getMove());
-        // encode nags
-        int cntNags = main_variation->getNags()->count();
-        if(cntNags > 0) {
-            this->appendNags(main_variation);
-        }
-        // encode comment, if any
-        if(!main_variation->getComment().isEmpty()) {
-            this->appendComment(main_variation);
+void DcgEncoder::traverseNodes(GameNode *node) {
+    // mainline move, then each variation with its subtree, then the
+    // rest of the mainline. Only variations recurse, the mainline
+    // is continued in the loop
+    while(!node->isLeaf()) {
+        QList<GameNode*> *variations = node->getVariations();
+        this->appendNode(variations->at(0));
+        for(int i=1;i<variations->count();i++) {
+            GameNode *var_i = variations->at(i);
+            // variation start marker
+            this->appendStartTag();
+            this->appendNode(var_i);
+            this->traverseNodes(var_i);
+            // variation end marker
+            this->appendEndTag();
         }
+        node = variations->at(0);
     }
+}
 
-    // now handle all variations (sidelines)
-    for(int i=1;i<cntVar;i++) {
-        // first create variation start marker
-        GameNode *var_i = current->getVariation(i);
-        this->appendStartTag();
-        this->appendMove(var_i->getMove());
-        // encode nags
-        int cntNags = var_i->getNags()->count();
-        if(cntNags > 0) {
-            this->appendNags(var_i);
-        }
-        // encode comment, if any
-        if(!var_i->getComment().isEmpty()) {
-            this->appendComment(var_i);
-        }
-        // recursive call for all childs
-        this->traverseNodes(var_i);
-
-        // print variation end
-        this->appendEndTag();
+void DcgEncoder::appendNode(GameNode *node) {
+    this->appendMove(*node->getMove());
+    if(!node->hasAnnotations()) {
+        return;
     }
-
-    // finally do the mainline
-    if(cntVar > 0) {
-        GameNode* main_variation = current->getVariation(0);
-        this->traverseNodes(main_variation);
+    // encode nags
+    const QList<int> *nags = node->getNags();
+    if(nags->count() > 0) {
+        this->appendNags(nags);
+    }
+    // encode comment, if any
+    const QString comment = node->getComment();
+    if(!comment.isEmpty()) {
+        this->appendComment(comment);
     }
 }
 
@@ -73,11 +63,11 @@ QByteArray* DcgEncoder::encodeGame(Game *game) {
     // add fen string tag if root is not initial position
     chess::Board* root = game->getRootNode()->getBoard();
     if(!root->is_initial_position()) {
-        const QByteArray fen = root->fen().toUtf8();
-        int l = fen.length();
+        char fen[FEN_BUFFER_SIZE];
+        int l = root->write_fen(fen);
         this->gameBytes->append(quint8(0x01));
         this->appendLength(l);
-        this->gameBytes->append(fen);
+        this->gameBytes->append(fen, l);
     } else {
         this->gameBytes->append((char) (0x00));
     }
@@ -89,19 +79,12 @@ QByteArray* DcgEncoder::encodeGame(Game *game) {
     return new QByteArray(*this->gameBytes);
 }
 
-void DcgEncoder::appendMove(Move *move) {
-    if(move->is_null) {
+void DcgEncoder::appendMove(const Move &move) {
+    if(move.is_null()) {
         this->gameBytes->append(quint8(0x88));
     } else {
-        QPoint fromPoint = move->fromAsXY();
-        QPoint toPoint = move->toAsXY();
-        quint8 from = fromPoint.y() * 8 + fromPoint.x();
-        qint8 to = toPoint.y() * 8 + toPoint.x();
-        quint16 move_binary = qint16(to) + (quint16(from) << 6);
-        if(move->promotion_piece != 0) {
-            move_binary += quint16(move->promotion_piece << 12);
-        }
-        ByteUtil::append_as_uint16(this->gameBytes, move_binary);
+        // chess::Move already uses the 16 bit database encoding
+        ByteUtil::append_as_uint16(this->gameBytes, move.encoding());
     }
 }
 
@@ -143,8 +126,7 @@ void DcgEncoder::prependLength(int len) {
     }
 }
 
-void DcgEncoder::appendNags(GameNode* node) {
-    QList<int>* nags = node->getNags();
+void DcgEncoder::appendNags(const QList<int> *nags) {
     int l = nags->length();
     if(l>0) {
         this->gameBytes->append(quint8(0x87));
@@ -156,8 +138,8 @@ void DcgEncoder::appendNags(GameNode* node) {
     }
 }
 
-void DcgEncoder::appendComment(GameNode* node) {
-    const QByteArray comment_utf8 = node->getComment().toUtf8();
+void DcgEncoder::appendComment(const QString &comment) {
+    const QByteArray comment_utf8 = comment.toUtf8();
     int l = comment_utf8.size();
     if(l>0) {
         this->gameBytes->append(quint8(0x86));
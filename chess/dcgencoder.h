@@ -14,14 +14,15 @@ public:
     ~DcgEncoder();
     QByteArray* encodeGame(Game *game);
     QByteArray* encodeHeader();
-    void traverseNodes(GameNode *current);
+    void traverseNodes(GameNode *node);
     void reset();
 
-    void appendMove(Move *move);
+    void appendNode(GameNode *node);
+    void appendMove(const Move &move);
     void appendLength(int len);
     void prependLength(int len);
-    void appendNags(GameNode* node);
-    void appendComment(GameNode* node);
+    void appendNags(const QList<int> *nags);
+    void appendComment(const QString &comment);
 
     void appendStartTag();
     void appendEndTag();
@@ -19,6 +19,8 @@
 
 
 #include "game.h"
+#include "pgn_reader.h"
+#include "pgn_visitor.h"
 #include <QDebug>
 #include <iostream>
 
@@ -26,11 +28,16 @@ namespace chess {
 
 Game::Game() {
 
-    this->root = new GameNode();
-    this->headers = new QMap<QString, QString>();
+    this->arena = new GameArena(this);
+    this->annotations = new GameAnnotations();
+    this->nodeIndex = 0;
+    this->root = new (this->arena) GameNode();
+    this->headers = new PgnHeaders();
     this->result = RES_UNDEF;
     this->current = root;
     this->treeWasChanged = false;
+    this->parsed = true;
+    this->lazyEncoding = 0;
 
     this->wasEcoClassified = false;
     this->ecoInfo = new EcoInfo{"",""};
@@ -41,14 +48,27 @@ Game::~Game() {
     delete this->headers;
     this->delBelow(this->root);
     delete this->root;
+    delete this->annotations;
+    delete this->arena;
+    delete this->nodeIndex;
     delete this->ecoInfo;
 }
 
 GameNode* Game::getRootNode() {
+    this->ensureParsed();
     return this->root;
 }
 
+GameArena* Game::getArena() {
+    return this->arena;
+}
+
+GameAnnotations* Game::getAnnotations() {
+    return this->annotations;
+}
+
 GameNode* Game::getCurrentNode() {
+    this->ensureParsed();
     return this->current;
 }
 
@@ -57,17 +77,66 @@ void Game::setCurrent(GameNode *new_current) {
 }
 
 void Game::setRoot(GameNode *new_root) {
+    this->ensureParsed();
     this->root = new_root;
+    // rebuilt on the next lookup
+    delete this->nodeIndex;
+    this->nodeIndex = 0;
 }
 
 int Game::getResult() {
+    this->ensureParsed();
     return this->result;
 }
 
 void Game::setResult(int r) {
+    this->ensureParsed();
     this->result = r;
 }
 
+int Game::getPositionResult() {
+    this->ensureParsed();
+    Board *b = this->current->getBoard();
+    if(b->is_checkmate()) {
+        return b->turn == WHITE ? RES_BLACK_WINS : RES_WHITE_WINS;
+    }
+    if(b->is_stalemate() || b->is_threefold_repetition()) {
+        return RES_DRAW;
+    }
+    return RES_UNDEF;
+}
+
+void Game::setLazyPgn(const QByteArray &pgn, const char* encoding) {
+    this->lazyPgn = pgn;
+    this->lazyEncoding = encoding;
+    this->parsed = false;
+}
+
+bool Game::isParsed() {
+    return this->parsed;
+}
+
+void Game::ensureParsed() {
+    if(this->parsed) {
+        return;
+    }
+    // set first, as the builder itself accesses the tree
+    this->parsed = true;
+    QByteArray pgn = this->lazyPgn;
+    this->lazyPgn.clear();
+    PgnReader reader;
+    GameBuilder builder(this);
+    try {
+        reader.visitGameFromBytes(pgn.constData(), pgn.size(), this->lazyEncoding, &builder);
+    } catch(const std::invalid_argument &) {
+        // don't leave a partially read tree
+        this->delBelow(this->root);
+        this->root->setBoard(new Board(true));
+        this->result = RES_UNDEF;
+        throw;
+    }
+}
+
 GameNode* Game::findNodeByIdRec(int id, GameNode *node) {
     if(node->getId() == id) {
         return node;
@@ -83,9 +152,41 @@ GameNode* Game::findNodeByIdRec(int id, GameNode *node) {
     return 0;
 }
 
+void Game::indexNodes(GameNode *node) {
+    if(this->nodeIndex == 0) {
+        return;
+    }
+    this->nodeIndex->insert(node->getId(), node);
+    for(int i=0;i<node->getVariations()->size();i++) {
+        this->indexNodes(node->getVariations()->at(i));
+    }
+}
+
+void Game::unindexNodes(GameNode *node) {
+    if(this->nodeIndex == 0) {
+        return;
+    }
+    this->nodeIndex->remove(node->getId());
+    for(int i=0;i<node->getVariations()->size();i++) {
+        this->unindexNodes(node->getVariations()->at(i));
+    }
+}
+
 GameNode* Game::findNodeById(int id) {
     GameNode *current = this->getRootNode();
-    GameNode *result = this->findNodeByIdRec(id, current);
+    if(this->nodeIndex == 0) {
+        this->nodeIndex = new QHash<int, GameNode*>();
+        this->indexNodes(current);
+    }
+    GameNode *result = this->nodeIndex->value(id, 0);
+    if(result == 0) {
+        // nodes that were added below a node outside of the arena
+        // of this game aren't indexed (cf. GameNode::addVariation)
+        result = this->findNodeByIdRec(id, current);
+        if(result != 0) {
+            this->indexNodes(result);
+        }
+    }
     if(result == 0) {
         throw std::invalid_argument("node doesn't exist");
     } else {
@@ -94,6 +195,7 @@ GameNode* Game::findNodeById(int id) {
 }
 
 void Game::goToMainLineChild() {
+    this->ensureParsed();
     if(this->current->getVariations()->count() > 0) {
         this->current = this->current->getVariation(0);
     }
@@ -108,18 +210,21 @@ GameNode* Game::getEndNode() {
 }
 
 void Game::goToChild(int idx_child) {
+    this->ensureParsed();
     if(this->current->getVariations()->count() > idx_child) {
         this->current = this->current->getVariation(idx_child);
     }
 }
 
 void Game::goToParent() {
+    this->ensureParsed();
     if(this->current->getParent() != 0) {
         this->current = this->current->getParent();
     }
 }
 
 void Game::goToEnd() {
+    this->ensureParsed();
     GameNode *temp = this->root;
     while(temp->getVariations()->count() > 0) {
         temp = temp->getVariation(0);
@@ -128,13 +233,17 @@ void Game::goToEnd() {
 }
 
 void Game::goToRoot() {
+    this->ensureParsed();
     this->current = this->root;
 }
 
 void Game::resetWithNewRootBoard(chess::Board *new_root_board) {
+    // the pending movetext of a lazy game is discarded anyway
+    this->parsed = true;
+    this->lazyPgn.clear();
     chess::GameNode* old_root = this->getRootNode();
     this->delBelow(old_root);
-    chess::GameNode* new_root = new chess::GameNode();
+    chess::GameNode* new_root = new (this->arena) chess::GameNode();
     new_root->setBoard(new_root_board);
     this->setRoot(new_root);
     this->setCurrent(new_root);
@@ -156,16 +265,18 @@ void Game::clearHeaders() {
 }
 
 void Game::goToLeaf() {
+    this->ensureParsed();
     while(!current->isLeaf()) {
         this->goToChild(0);
     }
 }
 
-void Game::applyMove(Move *m) {
+void Game::applyMove(const Move &m) {
+    this->ensureParsed();
     bool exists_child = false;
     for(int i=0;i<this->current->getVariations()->size();i++) {
         Move *mi = this->current->getVariations()->at(i)->getMove();
-        if(*m == *mi) {
+        if(m == *mi) {
             exists_child = true;
             this->current = this->current->getVariations()->at(i);
             break;
@@ -173,13 +284,12 @@ void Game::applyMove(Move *m) {
     }
     if(!exists_child) {
         GameNode *current = this->getCurrentNode();
-        Board *b_current = current->getBoard();
-        Board *b_child = b_current->copy_and_apply(*m);
-        GameNode *new_current = new GameNode();
-        new_current->setBoard(b_child);
+        // the board of the new node is computed on demand
+        GameNode *new_current = new (this->arena) GameNode();
         new_current->setMove(m);
         new_current->setParent(current);
         current->getVariations()->append(new_current);
+        this->indexNodes(new_current);
         this->current = new_current;
         this->treeWasChanged = true;
     }
@@ -227,15 +337,16 @@ void Game::delVariant(GameNode *node) {
     }
     if(idx != -1) {
         var_root->getVariations()->removeAt(idx);
+        this->unindexNodes(child);
         delete child;
         this->current = var_root;
     }
 }
 
 void Game::delBelow(GameNode *node) {
-    for(int i=0;i<node->getVariations()->size();i++) {
-        GameNode *child_i = node->getVariations()->at(i);
-        node->getVariations()->removeAt(i);
+    while(!node->getVariations()->isEmpty()) {
+        GameNode *child_i = node->getVariations()->takeLast();
+        this->unindexNodes(child_i);
         delete child_i;
     }
     this->current = node;
@@ -262,10 +373,13 @@ void Game::removeAllVariants() {
         // delete all variants
         for(int i=1;i<size;i++) {
             GameNode *ni = temp->getVariations()->at(i);
+            this->unindexNodes(ni);
             delete ni;
         }
+        // main is indexed already, so it is put
+        // back without going through addVariation
         temp->getVariations()->clear();
-        temp->addVariation(main);
+        temp->getVariations()->append(main);
         temp = temp->getVariation(0);
         size = temp->getVariations()->size();
     }
@@ -275,15 +389,21 @@ void Game::removeAllVariants() {
 void Game::findEco() {
 
     EcoCode *ec = new EcoCode();
+    // the mainline is played on a copy of the root board, and
+    // then taken back move by move until a position is classified
     GameNode* temp = this->getRootNode();
+    char fen[FEN_BUFFER_SIZE];
+    int length = temp->getBoard()->write_fen(fen);
+    Board board(fen, length);
     int depth = 0;
     while(depth < 29 && temp->getVariations()->count() > 0) {
         temp = temp->getVariation(0);
+        board.apply(*temp->getMove());
         depth++;
     }
     int maxdepth = depth;
     while(depth >= 2)  {
-        EcoInfo *e_temp = ec->classify(temp->getBoard());
+        EcoInfo *e_temp = ec->classify(&board);
         if(!e_temp->code.isEmpty()) {
             this->ecoInfo = e_temp;
             this->wasEcoClassified = true;
@@ -292,7 +412,7 @@ void Game::findEco() {
             break;
         } else {
             delete e_temp;
-            temp = temp->getParent();
+            board.undo();
             depth--;
         }
     }
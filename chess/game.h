@@ -21,8 +21,11 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <QByteArray>
+#include <QHash>
 #include "game_node.h"
 #include "ecocode.h"
+#include "pgn_headers.h"
 
 namespace chess {
 
@@ -52,39 +55,66 @@ public:
      *                object there will always be the 7tag roster index entries
      *                (albeit initialized to empty field)
      */
-    QMap<QString, QString>* headers;
+    PgnHeaders* headers;
 
     /**
      * @brief Game essentially a tree of GameNode objects that
      *             represents a game. Default root node has a
-     *             board position which is empty
+     *             board position which is empty. The functions that
+     *             access the tree or the result first parse the movetext
+     *             of a lazy game (cf. setLazyPgn), and can thus throw
+     *             std::invalid_argument
      */
     Game();
     ~Game();
 
     /**
-     * @brief getRootNode returns the root node of the game
+     * @brief getRootNode returns the root node of the game.
+     *                    throws std::invalid_argument if the game is lazy
+     *                    and its movetext can't be read (cf. setLazyPgn)
      * @return
      */
     GameNode* getRootNode();
 
     /**
-     * @brief getEndNode returns end of mainline
+     * @brief getEndNode returns end of mainline. throws
+     *                   std::invalid_argument like getRootNode()
      * @return
      */
     GameNode* getEndNode();
 
+    /**
+     * @brief getArena the arena that new nodes of this game should be
+     *                 allocated in, i.e. new (game->getArena()) GameNode().
+     *                 Released when the game is deleted, so the nodes
+     *                 must not outlive the game
+     * @return the arena of this game
+     */
+    GameArena* getArena();
+
+    /**
+     * @brief getAnnotations comments, NAGs, arrows and colored fields of
+     *                       the nodes that are allocated in the arena of
+     *                       this game, by node id. Use the accessors of
+     *                       GameNode instead
+     * @return the annotations of this game
+     */
+    GameAnnotations* getAnnotations();
+
 
     /**
      * @brief getCurrentNode returns the current node. The current
      *                       node is a pointer to a node in the tree
-     *                       and used e.g. for the node of the last move
+     *                       and used e.g. for the node of the last move.
+     *                       throws std::invalid_argument like getRootNode()
      * @return
      */
     GameNode* getCurrentNode();
 
     /**
-     * @brief getResult returns the result of the game
+     * @brief getResult returns the result of the game. throws
+     *                  std::invalid_argument like getRootNode(), as
+     *                  the result is read from the end of the movetext
      * @return RES_BLACK_WINS or RES_DRAW or RES_WHITE_WINS or RES_UNDEF
      */
     int getResult();
@@ -95,6 +125,17 @@ public:
      */
     void setResult(int r);
 
+    /**
+     * @brief getPositionResult the result that the rules give the position
+     *                          of the current node, regardless of the
+     *                          result of the game (cf. getResult()), e.g. to
+     *                          tell the user that a move ended the game
+     * @return RES_WHITE_WINS or RES_BLACK_WINS if the side to move is
+     *         checkmated, RES_DRAW after stalemate or a threefold repetition,
+     *         RES_UNDEF otherwise
+     */
+    int getPositionResult();
+
     /**
      * @brief applyMove apply a move to the current node, and change
      *                  the node to the resulting new node (or existing node)
@@ -102,18 +143,29 @@ public:
      *                  There is no check if the supplied move is legal!
      * @param m the move to apply on the current board.
      */
-    void applyMove(Move *m);
+    void applyMove(const Move &m);
 
     /**
      * @brief findNodeById each GameNode has a unique id (see class definition)
      *                     this searches for and find the node given the supplied id
      *                     throw std::invalid_argument if there exists no node
-     *                     with the id
+     *                     with the id. The first call indexes all nodes by id,
+     *                     later calls take constant time. The index is kept up to
+     *                     date by addVariation() and the member functions of Game
+     *                     that add or delete nodes
      * @param id the node id
      * @return gamenode with the supplied id
      */
     GameNode* findNodeById(int id);
 
+    /**
+     * @brief indexNodes adds the node and all nodes below it to the index of
+     *                   findNodeById(), if that index was built already.
+     *                   Called by GameNode::addVariation()
+     * @param node the node
+     */
+    void indexNodes(GameNode *node);
+
     /**
      * @brief setCurrent set the current pointer to the supplied node. There is
      *                   no validity check whether the node is actually a node
@@ -233,17 +285,50 @@ public:
      */
     void clearHeaders();
 
+    /**
+     * @brief setLazyPgn makes this a lazy game: the movetext is not parsed
+     *                   yet, but on first access to the game tree (e.g.
+     *                   getRootNode(), getEndNode(), getResult()). Only
+     *                   headers should be set before. Throws
+     *                   std::invalid_argument on that first access if the
+     *                   movetext can not be read, and the tree then stays empty.
+     * @param pgn the raw, still encoded game (cf. PgnReader::readLazyGameFromBytes)
+     * @param encoding encoding of the bytes, see PgnReader::detect_encoding
+     */
+    void setLazyPgn(const QByteArray &pgn, const char* encoding);
+
+    /**
+     * @brief isParsed false if the game is lazy and its movetext
+     *                 wasn't parsed so far
+     */
+    bool isParsed();
+
     void findEco();
     EcoInfo* getEcoInfo();
     bool wasEcoClassified;
 
 private:
 
+    // deleted after the nodes
+    GameArena* arena;
+    GameAnnotations* annotations;
     GameNode* root;
     GameNode* current;
     int result;
+
+    // movetext of a lazy game that is not yet parsed
+    bool parsed;
+    QByteArray lazyPgn;
+    const char* lazyEncoding;
+    void ensureParsed();
+
     GameNode* findNodeByIdRec(int id, GameNode* node);
 
+    // id -> node of all nodes of the tree. Built on
+    // the first lookup (cf. findNodeById)
+    QHash<int, GameNode*> *nodeIndex;
+    void unindexNodes(GameNode *node);
+
     EcoInfo* ecoInfo;
 
 };
@@ -0,0 +1,48 @@
+#include "game_annotations.h"
+
+namespace chess {
+
+static void deleteAnnotations(NodeAnnotations *a) {
+    for(int i=0;i<a->arrows.size();i++) {
+        delete a->arrows.at(i);
+    }
+    for(int i=0;i<a->coloredFields.size();i++) {
+        delete a->coloredFields.at(i);
+    }
+    delete a;
+}
+
+GameAnnotations::GameAnnotations() {
+}
+
+GameAnnotations::~GameAnnotations() {
+    QList<NodeAnnotations*> all = this->entries.values();
+    for(int i=0;i<all.size();i++) {
+        deleteAnnotations(all.at(i));
+    }
+}
+
+NodeAnnotations* GameAnnotations::find(int nodeId) {
+    if(this->entries.isEmpty()) {
+        return 0;
+    }
+    return this->entries.value(nodeId, 0);
+}
+
+NodeAnnotations* GameAnnotations::get(int nodeId) {
+    NodeAnnotations *a = this->find(nodeId);
+    if(a == 0) {
+        a = new NodeAnnotations();
+        this->entries.insert(nodeId, a);
+    }
+    return a;
+}
+
+void GameAnnotations::remove(int nodeId) {
+    NodeAnnotations *a = this->entries.take(nodeId);
+    if(a != 0) {
+        deleteAnnotations(a);
+    }
+}
+
+}
@@ -0,0 +1,80 @@
+#ifndef GAME_ANNOTATIONS_H
+#define GAME_ANNOTATIONS_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QPoint>
+#include <QtGui/qcolor.h>
+
+namespace chess {
+
+struct Arrow {
+    QPoint from;
+    QPoint to;
+    QColor color;
+};
+
+struct ColoredField {
+    QPoint field;
+    QColor color;
+};
+
+/**
+ * @brief NodeAnnotations everything that is annotated at one node.
+ *        Arrows and colored fields are owned.
+ */
+struct NodeAnnotations {
+    QString comment;
+    QList<int> nags;
+    QList<Arrow*> arrows;
+    QList<ColoredField*> coloredFields;
+};
+
+class GameAnnotations
+{
+
+public:
+
+    /**
+     * @brief GameAnnotations the annotations of the nodes of one game, by
+     *                        node id. Only nodes that are annotated have an
+     *                        entry, so unannotated games take no memory here
+     *                        (cf. GameNode::getNags, GameNode::getComment).
+     *                        Not thread-safe, like the game itself
+     */
+    GameAnnotations();
+    ~GameAnnotations();
+
+    /**
+     * @brief find returns the annotations of a node
+     * @param nodeId id of the node
+     * @return the annotations, or null if the node has none
+     */
+    NodeAnnotations* find(int nodeId);
+
+    /**
+     * @brief get returns the annotations of a node, and
+     *            creates an empty entry if there is none
+     * @param nodeId id of the node
+     * @return the annotations. Valid until remove() is called for the node
+     */
+    NodeAnnotations* get(int nodeId);
+
+    /**
+     * @brief remove deletes the annotations of a node, if any
+     * @param nodeId id of the node
+     */
+    void remove(int nodeId);
+
+private:
+
+    QHash<int, NodeAnnotations*> entries;
+
+    Q_DISABLE_COPY(GameAnnotations)
+
+};
+
+}
+
+#endif // GAME_ANNOTATIONS_H
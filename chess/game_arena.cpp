@@ -0,0 +1,110 @@
+#include "game_arena.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <new>
+
+namespace chess {
+
+/**
+ * @brief BlockHeader start of each block: the previous block of the same
+ *        arena (or the next one in the pool), and the size of the block.
+ *        Blocks of objects that don't fit into ARENA_BLOCK_SIZE are larger
+ */
+struct BlockHeader
+{
+    char *previous;
+    size_t size;
+};
+
+// all allocations are aligned for any type
+static const size_t ALIGNMENT = alignof(std::max_align_t);
+static const size_t HEADER_SIZE = (sizeof(BlockHeader) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+// released blocks of ARENA_BLOCK_SIZE, linked through their headers
+static QMutex poolMutex;
+static char *pool = 0;
+static int poolSize = 0;
+
+static BlockHeader* header(char *block) {
+    return reinterpret_cast<BlockHeader*>(block);
+}
+
+static char* newBlock(size_t size) {
+    if(size == size_t(ARENA_BLOCK_SIZE)) {
+        QMutexLocker locker(&poolMutex);
+        if(pool != 0) {
+            char *block = pool;
+            pool = header(block)->previous;
+            poolSize--;
+            return block;
+        }
+    }
+    char *block = static_cast<char*>(::operator new(size));
+    header(block)->size = size;
+    return block;
+}
+
+GameArena::GameArena(Game *game) {
+    this->block = 0;
+    this->used = 0;
+    this->game = game;
+    this->generation = 0;
+}
+
+Game* GameArena::getGame() {
+    return this->game;
+}
+
+int GameArena::boardGeneration() {
+    return this->generation;
+}
+
+void GameArena::invalidateBoards() {
+    this->generation++;
+}
+
+GameArena::~GameArena() {
+    // blocks of the default size go back to the pool
+    // as long as it isn't full, all others are freed
+    QMutexLocker locker(&poolMutex);
+    while(this->block != 0) {
+        char *previous = header(this->block)->previous;
+        if(header(this->block)->size == size_t(ARENA_BLOCK_SIZE) && poolSize < ARENA_POOL_SIZE) {
+            header(this->block)->previous = pool;
+            pool = this->block;
+            poolSize++;
+        } else {
+            ::operator delete(this->block);
+        }
+        this->block = previous;
+    }
+}
+
+void* GameArena::allocate(size_t size) {
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if(HEADER_SIZE + size > size_t(ARENA_BLOCK_SIZE)) {
+        // an object that doesn't fit into a block gets a block
+        // of its own, which is linked behind the current one
+        char *large = newBlock(HEADER_SIZE + size);
+        if(this->block == 0) {
+            header(large)->previous = 0;
+            this->block = large;
+            this->used = HEADER_SIZE + size;
+        } else {
+            header(large)->previous = header(this->block)->previous;
+            header(this->block)->previous = large;
+        }
+        return large + HEADER_SIZE;
+    }
+    if(this->block == 0 || this->used + size > header(this->block)->size) {
+        char *next = newBlock(ARENA_BLOCK_SIZE);
+        header(next)->previous = this->block;
+        this->block = next;
+        this->used = HEADER_SIZE;
+    }
+    void *p = this->block + this->used;
+    this->used += size;
+    return p;
+}
+
+}
@@ -0,0 +1,80 @@
+#ifndef GAME_ARENA_H
+#define GAME_ARENA_H
+
+#include <cstddef>
+#include <QtGlobal>
+
+namespace chess {
+
+class Game;
+
+// size of the blocks that an arena allocates from
+const int ARENA_BLOCK_SIZE = 8 * 1024;
+
+// number of released blocks that are kept for reuse
+const int ARENA_POOL_SIZE = 256;
+
+class GameArena
+{
+
+public:
+
+    /**
+     * @brief GameArena a monotonic allocator for the nodes of one game.
+     *                  Memory is taken from blocks of ARENA_BLOCK_SIZE bytes,
+     *                  is never freed individually, and is released all at
+     *                  once when the arena is deleted. The blocks then go to
+     *                  a pool that is shared by all threads, and are reused
+     *                  by the next arenas. Not thread-safe: each game has its
+     *                  own arena, so games are built concurrently without
+     *                  contending on the allocator (the pool is only locked
+     *                  once per block).
+     * @param game the game whose nodes are allocated in the arena
+     */
+    GameArena(Game *game);
+    ~GameArena();
+
+    /**
+     * @brief getGame the game whose nodes are allocated in the arena
+     */
+    Game* getGame();
+
+    /**
+     * @brief allocate returns memory for an object of the supplied size,
+     *                 aligned for any type. Valid until the arena is deleted
+     * @param size size in bytes
+     * @return pointer to the memory
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief boardGeneration changes whenever boards that GameNode::getBoard()
+     *                        computed for nodes of the game may have become
+     *                        wrong, i.e. when a move or board of the game
+     *                        changes. Games are independent, so a change to
+     *                        one game doesn't outdate the boards of others
+     * @return the current generation
+     */
+    int boardGeneration();
+
+    /**
+     * @brief invalidateBoards starts a new board generation
+     */
+    void invalidateBoards();
+
+private:
+
+    // the current block. the blocks of the arena are
+    // linked through their headers (cf. game_arena.cpp)
+    char *block;
+    size_t used;
+    Game *game;
+    int generation;
+
+    Q_DISABLE_COPY(GameArena)
+
+};
+
+}
+
+#endif // GAME_ARENA_H
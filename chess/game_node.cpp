@@ -19,54 +19,250 @@
 
 
 #include "game_node.h"
+#include "game.h"
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 #include <iostream>
 #include <assert.h>
+#include <QVarLengthArray>
+#include <new>
 
 namespace chess {
 
-int GameNode::id = 0;
+QAtomicInt GameNode::id(0);
+
+// ids are taken from GameNode::id in blocks of this size, so that
+// threads that create nodes concurrently don't contend on the counter
+static const int NODE_ID_BLOCK_SIZE = 1024;
+
+struct NodeIdBlock
+{
+    int next;
+    int end;
+};
+
+static thread_local NodeIdBlock nodeIds = { 0, 0 };
+
+struct CachedBoard
+{
+    int nodeId;
+    int generation;
+    // plies since the last checkpoint
+    int plies;
+    quint64 lastUsed;
+    Board *board;
+};
+
+/**
+ * @brief BoardCache the boards that GameNode::getBoard() computed last,
+ *        by node id (ids are never reused). One cache per thread, as
+ *        games are read and printed concurrently. When full, the least
+ *        recently used board is replaced. Entries are only valid in the
+ *        board generation of their game (cf. GameArena::boardGeneration),
+ *        so that a change to a game also outdates the entries in the
+ *        caches of other threads.
+ */
+struct BoardCache
+{
+    CachedBoard entries[BOARD_CACHE_SIZE];
+    quint64 clock;
+
+    BoardCache() {
+        this->clock = 0;
+        for(int i=0;i<BOARD_CACHE_SIZE;i++) {
+            this->entries[i].nodeId = -1;
+            this->entries[i].board = 0;
+        }
+    }
+
+    ~BoardCache() {
+        for(int i=0;i<BOARD_CACHE_SIZE;i++) {
+            delete this->entries[i].board;
+        }
+    }
+
+    CachedBoard* find(int nodeId, int generation) {
+        for(int i=0;i<BOARD_CACHE_SIZE;i++) {
+            CachedBoard *e = &this->entries[i];
+            if(e->nodeId == nodeId && e->board != 0 && e->generation == generation) {
+                e->lastUsed = ++this->clock;
+                return e;
+            }
+        }
+        return 0;
+    }
+
+    CachedBoard* insert(int nodeId, int generation, Board *board, int plies) {
+        CachedBoard *e = &this->entries[0];
+        for(int i=1;i<BOARD_CACHE_SIZE && e->board != 0;i++) {
+            if(this->entries[i].board == 0 || this->entries[i].lastUsed < e->lastUsed) {
+                e = &this->entries[i];
+            }
+        }
+        delete e->board;
+        e->nodeId = nodeId;
+        e->generation = generation;
+        e->plies = plies;
+        e->lastUsed = ++this->clock;
+        e->board = board;
+        return e;
+    }
+
+    void remove(int nodeId) {
+        for(int i=0;i<BOARD_CACHE_SIZE;i++) {
+            CachedBoard *e = &this->entries[i];
+            if(e->nodeId == nodeId) {
+                delete e->board;
+                e->board = 0;
+                e->nodeId = -1;
+            }
+        }
+    }
+};
+
+static thread_local BoardCache boardCache;
+
+// each node is preceded by the arena it was allocated in, or null
+// if it is on the heap, so that delete can tell them apart
+static const size_t NODE_HEADER_SIZE = alignof(std::max_align_t);
+
+static GameArena* arenaOf(GameNode *node) {
+    return *reinterpret_cast<GameArena**>(reinterpret_cast<char*>(node) - NODE_HEADER_SIZE);
+}
+
+// board generation of the nodes that are not allocated in
+// the arena of a game (cf. detachedAnnotations)
+static QAtomicInt detachedGeneration(0);
+
+static int boardGeneration(GameNode *node) {
+    GameArena *arena = arenaOf(node);
+    if(arena != 0) {
+        return arena->boardGeneration();
+    }
+    return detachedGeneration.loadAcquire();
+}
+
+static void invalidateBoards(GameNode *node) {
+    GameArena *arena = arenaOf(node);
+    if(arena != 0) {
+        arena->invalidateBoards();
+    } else {
+        detachedGeneration.ref();
+    }
+}
+
+// annotations of nodes that are not allocated in the arena of a
+// game. Locked, as such nodes may be created on any thread
+static GameAnnotations detachedAnnotations;
+static QMutex detachedMutex;
+
+void* GameNode::operator new(size_t size, GameArena *arena) {
+    char *p = 0;
+    if(arena != 0) {
+        p = static_cast<char*>(arena->allocate(NODE_HEADER_SIZE + size));
+    } else {
+        p = static_cast<char*>(::operator new(NODE_HEADER_SIZE + size));
+    }
+    *reinterpret_cast<GameArena**>(p) = arena;
+    return p + NODE_HEADER_SIZE;
+}
+
+void* GameNode::operator new(size_t size) {
+    return GameNode::operator new(size, static_cast<GameArena*>(0));
+}
+
+void GameNode::operator delete(void *p) {
+    if(p == 0) {
+        return;
+    }
+    char *start = static_cast<char*>(p) - NODE_HEADER_SIZE;
+    // memory of nodes in an arena is released with the arena
+    if(*reinterpret_cast<GameArena**>(start) == 0) {
+        ::operator delete(start);
+    }
+}
+
+void GameNode::operator delete(void *p, GameArena *arena) {
+    Q_UNUSED(arena);
+    GameNode::operator delete(p);
+}
+
+int GameNode::initId() {
+    if(nodeIds.next == nodeIds.end) {
+        nodeIds.next = id.fetchAndAddRelaxed(NODE_ID_BLOCK_SIZE);
+        nodeIds.end = nodeIds.next + NODE_ID_BLOCK_SIZE;
+    }
+    return nodeIds.next++;
+}
 
 GameNode::GameNode() {
 
-    this->variations = new QList<GameNode*>();
-    this->board = new Board(true);
-    this->comment = QString("");
-    this->nags = new QList<int>();
+    // set by setBoard(), or computed on demand
+    this->board = 0;
+    this->boardComputed = false;
+    this->checkpointGeneration = 0;
     this->parent = 0;
-    this->m = 0;
+    this->has_move = false;
+    this->annotated = false;
     this->nodeId = this->initId();
-    this->san_cache = QString("");
-    this->arrows = new QList<Arrow*>();
-    this->coloredFields = new QList<ColoredField*>();
     this->depthCache = 0;
     this->userWasInformedAboutResult = false;
 
 }
 
 GameNode::~GameNode() {
-    delete this->m;
-    for(int i=0;i<this->arrows->size();i++) {
-        delete this->arrows->at(i);
-    }
-    delete this->arrows;
-
-    for(int i=0;i<this->coloredFields->size();i++) {
-        delete this->coloredFields->at(i);
+    if(this->annotated) {
+        GameArena *arena = arenaOf(this);
+        if(arena != 0) {
+            arena->getGame()->getAnnotations()->remove(this->nodeId);
+        } else {
+            QMutexLocker locker(&detachedMutex);
+            detachedAnnotations.remove(this->nodeId);
+        }
     }
-    delete this->coloredFields;
-    delete this->nags;
     delete this->board;
-    for(int i=0;i<this->variations->size();i++) {
-        delete this->variations->at(i);
+    for(int i=0;i<this->variations.size();i++) {
+        delete this->variations.at(i);
     }
-    this->variations->clear();
-    delete this->variations;
 }
 
-void GameNode::setMove(Move *m) {
-    assert(m!=0);
+void GameNode::setMove(const Move &m) {
     this->m = m;
+    this->has_move = true;
+    // a node w/o parent (e.g. while a game is read)
+    // never had a board computed
+    if(this->parent != 0) {
+        this->dropComputedBoard();
+    }
+    // other threads may have computed the board of this node or
+    // of the nodes below it, their caches are outdated as well
+    if(this->parent != 0 || !this->variations.isEmpty()) {
+        invalidateBoards(this);
+    }
+}
+
+void GameNode::dropComputedBoard() {
+    if(this->boardComputed) {
+        delete this->board;
+        this->board = 0;
+        this->boardComputed = false;
+    }
+    boardCache.remove(this->nodeId);
+}
+
+bool GameNode::keepsBoard() {
+    if(this->board == 0) {
+        return false;
+    }
+    if(!this->boardComputed || this->checkpointGeneration == boardGeneration(this)) {
+        return true;
+    }
+    // a checkpoint from before a node above changed
+    delete this->board;
+    this->board = 0;
+    this->boardComputed = false;
+    return false;
 }
 
 int GameNode::getDepth() {
@@ -82,15 +278,13 @@ int GameNode::getDepth() {
 }
 
 QString GameNode::getSan() {
-    if(this->san_cache.isEmpty() && this->parent != 0) {
-        Board *b = this->parent->getBoard();
-        Move *m = this->m;
-        //qDebug() << "node to: " << m->uci_string;
-        //QString foo = m->uci();
-        //qDebug() << foo;
-        this->san_cache = b->san(*m);
+    if(this->parent == 0) {
+        return QString("");
     }
-    return this->san_cache;
+    Board *b = this->parent->getBoard();
+    char san[SAN_BUFFER_SIZE];
+    int length = b->write_san(this->m, san);
+    return QString::fromLatin1(san, length);
 }
 
 int GameNode::getId() {
@@ -98,7 +292,10 @@ int GameNode::getId() {
 }
 
 Move* GameNode::getMove() {
-    return this->m;
+    if(!this->has_move) {
+        return 0;
+    }
+    return &this->m;
 }
 
 void GameNode::setParent(GameNode *p) {
@@ -110,31 +307,121 @@ GameNode* GameNode::getParent() {
     return this->parent;
 }
 
+NodeAnnotations* GameNode::findAnnotations() {
+    if(!this->annotated) {
+        return 0;
+    }
+    GameArena *arena = arenaOf(this);
+    if(arena != 0) {
+        return arena->getGame()->getAnnotations()->find(this->nodeId);
+    }
+    QMutexLocker locker(&detachedMutex);
+    return detachedAnnotations.find(this->nodeId);
+}
+
+NodeAnnotations* GameNode::annotations() {
+    this->annotated = true;
+    GameArena *arena = arenaOf(this);
+    if(arena != 0) {
+        return arena->getGame()->getAnnotations()->get(this->nodeId);
+    }
+    QMutexLocker locker(&detachedMutex);
+    return detachedAnnotations.get(this->nodeId);
+}
+
+bool GameNode::hasAnnotations() {
+    return this->annotated;
+}
+
 void GameNode::addNag(int n) {
-    this->nags->append(n);
+    this->annotations()->nags.append(n);
 }
 
 QList<int>* GameNode::getNags() {
-    return this->nags;
+    return &this->annotations()->nags;
 }
 
 void GameNode::setComment(QString &c) {
-    this->comment = c;
+    // removing a comment that doesn't exist
+    // shouldn't create an entry for the node
+    if(c.isEmpty() && !this->annotated) {
+        return;
+    }
+    this->annotations()->comment = c;
 }
 
 QString GameNode::getComment() {
-    return this->comment;
+    NodeAnnotations *a = this->findAnnotations();
+    if(a == 0) {
+        return QString("");
+    }
+    return a->comment;
 }
 
 Board* GameNode::getBoard() {
-    assert(this->board != 0);
-    return this->board;
+    if(this->keepsBoard()) {
+        return this->board;
+    }
+    if(this->parent == 0) {
+        // root w/o board, i.e. the initial position
+        this->board = new Board(true);
+        return this->board;
+    }
+    int generation = boardGeneration(this);
+    CachedBoard *cached = boardCache.find(this->nodeId, generation);
+    if(cached != 0) {
+        return cached->board;
+    }
+    // find the nearest node above that has a board
+    QVarLengthArray<GameNode*, CHECKPOINT_INTERVAL> line;
+    GameNode *node = this;
+    Board *start = 0;
+    int plies = 0;
+    while(start == 0) {
+        line.append(node);
+        node = node->parent;
+        if(node->parent == 0 || node->keepsBoard()) {
+            start = node->getBoard();
+        } else if((cached = boardCache.find(node->nodeId, generation)) != 0) {
+            start = cached->board;
+            plies = cached->plies;
+        }
+    }
+    // replay the moves from there, and keep a
+    // board every CHECKPOINT_INTERVAL plies
+    Board *b = start;
+    bool isCheckpoint = true;
+    for(int i=line.size()-1;i>=0;i--) {
+        Board *next = b->copy_and_apply(line.at(i)->m);
+        if(!isCheckpoint) {
+            delete b;
+        }
+        b = next;
+        isCheckpoint = false;
+        plies++;
+        if(plies >= CHECKPOINT_INTERVAL) {
+            GameNode *checkpoint = line.at(i);
+            checkpoint->board = b;
+            checkpoint->boardComputed = true;
+            checkpoint->checkpointGeneration = generation;
+            isCheckpoint = true;
+            plies = 0;
+        }
+    }
+    if(isCheckpoint) {
+        return b;
+    }
+    return boardCache.insert(this->nodeId, generation, b, plies)->board;
 }
 
 void GameNode::setBoard(Board *b) {
     assert(b != 0);
     delete this->board;
     this->board = b;
+    this->boardComputed = false;
+    if(!this->variations.isEmpty()) {
+        invalidateBoards(this);
+    }
 }
 
 
@@ -147,13 +434,13 @@ GameNode* GameNode::root() {
 }
 
 QList<GameNode*>* GameNode::getVariations() {
-    return this->variations;
+    return &this->variations;
 }
 
 
 GameNode* GameNode::getVariation(int i) {
-    assert(this->variations->size() > i);
-    return this->variations->at(i);
+    assert(this->variations.size() > i);
+    return this->variations.at(i);
 }
 
 bool GameNode::hasVariations() {
@@ -162,20 +449,24 @@ bool GameNode::hasVariations() {
 
 void GameNode::addVariation(GameNode *g) {
     assert(g != 0);
-    this->variations->append(g);
+    this->variations.append(g);
     g->parent = this;
+    GameArena *arena = arenaOf(this);
+    if(arena != 0) {
+        arena->getGame()->indexNodes(g);
+    }
 }
 
 QList<Arrow*>* GameNode::getArrows() {
-    return this->arrows;
+    return &this->annotations()->arrows;
 }
 
 QList<ColoredField*>* GameNode::getColoredFields() {
-    return this->coloredFields;
+    return &this->annotations()->coloredFields;
 }
 
 bool GameNode::isLeaf() {
-    if(this->variations->count() == 0) {
+    if(this->variations.count() == 0) {
         return true;
     } else {
         return false;
@@ -183,23 +474,24 @@ bool GameNode::isLeaf() {
 }
 
 void GameNode::addOrDelArrow(Arrow *a) {
+    QList<Arrow*> *arrows = this->getArrows();
     bool addArrow = true;
-    for(int i=0;i<this->arrows->size();i++) {
-        Arrow *ai = this->arrows->at(i);
+    for(int i=0;i<arrows->size();i++) {
+        Arrow *ai = arrows->at(i);
         if(ai->from.x() == a->from.x() && ai->from.y() == a->from.y()
                 && ai->to.x() == a->to.x() && a->to.y() == ai->to.y()) {
             if(a->color == ai->color) {
-                this->arrows->removeAt(i);
+                arrows->removeAt(i);
                 addArrow = false;
                 break;
             } else {
-                this->arrows->removeAt(i);
+                arrows->removeAt(i);
                 break;
             }
         }
     }
     if(addArrow) {
-        this->arrows->append(a);
+        arrows->append(a);
     } else {
         delete a;
     }
@@ -207,22 +499,23 @@ void GameNode::addOrDelArrow(Arrow *a) {
 
 void GameNode::addOrDelColoredField(ColoredField *c) {
     assert(c != 0);
+    QList<ColoredField*> *coloredFields = this->getColoredFields();
     bool addField = true;
-    for(int i=0;i<this->coloredFields->size();i++) {
-        ColoredField *ci = this->coloredFields->at(i);
+    for(int i=0;i<coloredFields->size();i++) {
+        ColoredField *ci = coloredFields->at(i);
         if(ci->field.x() == c->field.x() && ci->field.y() == c->field.y()) {
             if(ci->color == c->color) {
-                this->coloredFields->removeAt(i);
+                coloredFields->removeAt(i);
                 addField = false;
                 break;
             } else {
-                this->coloredFields->removeAt(i);
+                coloredFields->removeAt(i);
                 break;
             }
         }
     }
     if(addField) {
-        this->coloredFields->append(c);
+        coloredFields->append(c);
     } else {
         delete c;
     }
@@ -23,21 +23,18 @@
 
 #include "board.h"
 #include "move.h"
-#include <QPoint>
-#include <QtGui/qcolor.h>
+#include "game_arena.h"
+#include "game_annotations.h"
+#include <QAtomicInt>
 
 namespace chess {
 
-struct Arrow {
-    QPoint from;
-    QPoint to;
-    QColor color;
-};
+// nodes keep their board only every CHECKPOINT_INTERVAL plies, the
+// boards of all other nodes are computed by replaying the moves
+const int CHECKPOINT_INTERVAL = 16;
 
-struct ColoredField {
-    QPoint field;
-    QColor color;
-};
+// number of computed boards that are kept, per thread
+const int BOARD_CACHE_SIZE = 8;
 
 class GameNode
 {
@@ -54,15 +51,50 @@ public:
      */
     ~GameNode();
 
+    /**
+     * @brief operator new allocates the node in the supplied arena, i.e.
+     *        together with the other nodes of its game (cf. Game::getArena).
+     *        Such nodes are deleted as usual, but their memory is only
+     *        released together with the arena. Nodes created with plain
+     *        new are allocated on the heap. Nodes must always be created
+     *        with new, as they keep their arena in front of the object.
+     */
+    static void* operator new(size_t size, GameArena *arena);
+    static void* operator new(size_t size);
+    static void operator delete(void *p);
+    static void operator delete(void *p, GameArena *arena);
+
     /**
      * @brief getId each game node is assigned a unique id
-     *        automatically during construction.
+     *        automatically during construction. Ids are unique
+     *        across all games and threads, but don't follow the
+     *        order of construction.
      * @return the unique id of this node
      */
     int getId();
 
     /**
-     * @brief getBoard
+     * @brief getBoard returns the position of this node. Only the root,
+     *                 nodes with a board set by setBoard() and every
+     *                 CHECKPOINT_INTERVAL-th node keep their board. For
+     *                 the other nodes, the board is computed by replaying
+     *                 the moves from the nearest such checkpoint, and kept
+     *                 in a small cache: the returned pointer stays valid
+     *                 only until the boards of BOARD_CACHE_SIZE other nodes
+     *                 have been computed, so don't hold on to it.
+     *                 Computed boards are outdated once the board or move
+     *                 of the node or a node above it changes: this starts
+     *                 a new board generation of the game (cf.
+     *                 GameArena::boardGeneration), which outdates the
+     *                 checkpoints and the cached boards of all threads.
+     *                 Only the board of the changed node itself is freed
+     *                 right away, and only in the cache of the calling
+     *                 thread; the outdated entries of other threads are
+     *                 freed when they are replaced. Note that this
+     *                 changes the node and the nodes above it (and the
+     *                 cache of the calling thread), i.e. it is not safe to
+     *                 call getBoard() on the nodes of one game from several
+     *                 threads at once.
      * @return Board of current node
      */
     Board* getBoard();
@@ -70,15 +102,17 @@ public:
     /**
      * @brief setBoard deletes the old board of this node, and sets
      *                 the supplied board as the new one. Does no
-     *                 validity checks of the board position
+     *                 validity checks of the board position. The
+     *                 boards of the child nodes follow from it.
      * @param b The board. Must not be null.
      */
     void setBoard(Board *b);
 
     /**
      * @brief getSan returns san string of move that
-     *               lead to this node.
-     * @return san string or null for move node.
+     *               lead to this node. Not cached, i.e.
+     *               computed from the board of the parent
+     * @return san string or empty string for the root node.
      */
     QString getSan();
 
@@ -106,10 +140,11 @@ public:
     /**
      * @brief setMove set the move that leads to this
      *                game node to m. There is no validity
-     *                or consistency check.
-     * @param m Pointer to the move.
+     *                or consistency check. Computed boards of
+     *                this node and the nodes below are dropped.
+     * @param m the move, stored by value.
      */
-    void setMove(Move *m);
+    void setMove(const Move &m);
 
     /**
      * @brief setParent Set the parent to the supplied Game Node.
@@ -119,6 +154,16 @@ public:
      */
     void setParent(GameNode *g);
 
+    /**
+     * @brief hasAnnotations cheap check whether the node may have a comment,
+     *                       NAGs, arrows or colored fields. If false, it has
+     *                       none. The annotations of all nodes are kept in a
+     *                       table of the game (cf. Game::getAnnotations), and
+     *                       only annotated nodes have an entry.
+     * @return false if the node has no annotations
+     */
+    bool hasAnnotations();
+
     /**
      * @brief setComment Set comment for this node to supplied textstring.
      * @param c The comment.
@@ -175,7 +220,9 @@ public:
     void addNag(int n);
 
     /**
-     * @brief getNags returns all numeric annotation glyphs (see PGN standard)
+     * @brief getNags returns all numeric annotation glyphs (see PGN standard).
+     *                Creates an entry for the node in the annotations of the
+     *                game, so check hasAnnotations() first when only reading.
      * @return list with all NAGs
      */
     QList<int> *getNags();
@@ -183,6 +230,7 @@ public:
     /**
      * @brief getArrows returns a list with all arrows for this node.
      *        Arrows are just annotations done by the user for illustrations.
+     *        Like getNags(), creates an entry in the annotations of the game.
      * @return list of arrows
      */
     QList<Arrow*>* getArrows();
@@ -190,6 +238,7 @@ public:
     /**
      * @brief getColoredFields returns list of colored fields. Such fields
      *        are juts highlighted fields done by the user for illustration.
+     *        Like getNags(), creates an entry in the annotations of the game.
      * @return list of color fields
      */
     QList<ColoredField*> *getColoredFields();
@@ -213,22 +262,32 @@ public:
     bool userWasInformedAboutResult;
 
 protected:
-    static int initId() { return id++; }
+    static int initId();
 
 private:
-    QList<Arrow*> *arrows;
-    QList<ColoredField*> *coloredFields;
-    QString san_cache;
-    static int id;
+    static QAtomicInt id;
     int nodeId;
-    Move* m;
-    QList<GameNode*> *variations;
-    QList<int> *nags;
+    Move m;
+    bool has_move;
+    // set once the node has an entry in the annotations
+    bool annotated;
+    QList<GameNode*> variations;
     Board* board;
-    QString comment;
+    // board is a checkpoint computed by getBoard() (and not set by
+    // setBoard()). It is only valid in checkpointGeneration of the game
+    bool boardComputed;
+    int checkpointGeneration;
     GameNode* parent;
     int depthCache;
 
+    bool keepsBoard();
+    // frees the computed board of this node, and its entry in the
+    // cache of the calling thread only (other threads' entries are
+    // outdated by the board generation of the game)
+    void dropComputedBoard();
+    NodeAnnotations* findAnnotations();
+    NodeAnnotations* annotations();
+
 };
 
 }
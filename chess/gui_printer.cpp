@@ -66,7 +66,12 @@ QString GuiPrinter::printGame(Game *g) {
     if(!root->getComment().isEmpty()) {
         this->printComment(root->getComment());
     }
-    this->printGameContent(root, true);
+    // the moves are applied to a copy of the root board and taken back
+    // again while descending, instead of computing the board of each node
+    char fen[FEN_BUFFER_SIZE];
+    int length = root->getBoard()->write_fen(fen);
+    Board board(fen, length);
+    this->printGameContent(root, &board, true);
     this->printResult(g->getResult());
     this->pgn.append(this->currentLine);
 
@@ -74,11 +79,9 @@ QString GuiPrinter::printGame(Game *g) {
 
 }
 
-void GuiPrinter::printMove(GameNode *node) { //int nodeId, Board *b, Move *m) {
-        int nodeId = node->getId();
-        Board *b = node->getParent()->getBoard();
+void GuiPrinter::printMove(GameNode *node, Board *b) {
         assert(b != 0);
-        QString s_nodeId = QString::number(nodeId);
+        QString s_nodeId = QString::number(node->getId());
         this->writeToken("<a name=\"");
         this->writeToken(s_nodeId);
         this->writeToken("\" href=\"#");
@@ -95,7 +98,9 @@ void GuiPrinter::printMove(GameNode *node) { //int nodeId, Board *b, Move *m) {
             tkn.append(QString("... "));
             this->writeToken(tkn);
         }
-        this->writeToken(node->getSan());
+        char san[SAN_BUFFER_SIZE];
+        int length = b->write_san(*node->getMove(), san);
+        this->writeToken(QString::fromLatin1(san, length));
         this->writeToken("</a> ");
 
     this->forceMoveNumber = false;
@@ -221,60 +226,57 @@ void GuiPrinter::printComment(const QString &comment) {
 
 
 
-void GuiPrinter::printGameContent(GameNode* g, bool onMainLine) {
-
-    // first write mainline move, if there are variations
-    int cntVar = g->getVariations()->count();
-    if(cntVar > 0) {
-        if(onMainLine) {
-            this->writeToken("<b>");
-        }
-        GameNode* main_variation = g->getVariation(0);
-        this->printMove(main_variation);
-        // write nags
-        QList<int> *nags = main_variation->getNags();
-        for(int j=0;j<nags->count();j++) {
-            int n = nags->at(j);
-            this->printNag(n);
-        }
-
-        if(onMainLine) {
-            this->writeToken("</b>");
-        }
-        // write comments
-        if(!main_variation->getComment().isEmpty()) {
-            this->printComment(main_variation->getComment());
+void GuiPrinter::printGameContent(GameNode* g, Board *b, bool onMainLine) {
+
+    // mainline move, then each variation with its subtree, then the
+    // rest of the mainline. Only variations recurse, the mainline
+    // is continued in the loop. b is left as it was on entry
+    int applied = 0;
+    while(!g->isLeaf()) {
+        QList<GameNode*> *variations = g->getVariations();
+        GameNode* main_variation = variations->at(0);
+        this->printNode(main_variation, b, onMainLine);
+        for(int i=1;i<variations->count();i++) {
+            GameNode *var_i = variations->at(i);
+            this->beginVariation();
+            this->printNode(var_i, b, false);
+            b->apply(*var_i->getMove());
+            this->printGameContent(var_i, b, false);
+            b->undo();
+            this->endVariation();
         }
+        b->apply(*main_variation->getMove());
+        applied++;
+        g = main_variation;
     }
-    // now handle all variations (sidelines)
-    for(int i=1;i<cntVar;i++) {
-        // first create variation start marker, and print the move
-        GameNode *var_i = g->getVariation(i);
-
-        this->beginVariation();
-        this->printMove(var_i);
-
-        // next print nags
+    for(int i=0;i<applied;i++) {
+        b->undo();
+    }
+}
 
-        QList<int> *nags = var_i->getNags();
+void GuiPrinter::printNode(GameNode *node, Board *b, bool onMainLine) {
+    if(onMainLine) {
+        this->writeToken("<b>");
+    }
+    this->printMove(node, b);
+    bool annotated = node->hasAnnotations();
+    // write nags
+    if(annotated) {
+        const QList<int> *nags = node->getNags();
         for(int j=0;j<nags->count();j++) {
             int n = nags->at(j);
             this->printNag(n);
         }
-        // finally print comments
-        if(!var_i->getComment().isEmpty()) {
-            this->printComment(var_i->getComment());
-        }
-        // recursive call for all childs
-        this->printGameContent(var_i, false);
-        // print variation end
-        this->endVariation();
     }
-
-    // finally do the mainline
-    if(cntVar > 0) {
-        GameNode* main_variation = g->getVariation(0);
-        this->printGameContent(main_variation, onMainLine && true);
+    if(onMainLine) {
+        this->writeToken("</b>");
+    }
+    // write comments
+    if(annotated) {
+        const QString comment = node->getComment();
+        if(!comment.isEmpty()) {
+            this->printComment(comment);
+        }
     }
 }
 
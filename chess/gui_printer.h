@@ -54,8 +54,9 @@ private:
     void flushCurrentLine();
     void writeToken(const QString &token);
     void writeLine(const QString &token);
-    void printGameContent(GameNode *g, bool onMainLine);
-    void printMove(GameNode *g);
+    void printGameContent(GameNode *g, Board *b, bool onMainLine);
+    void printNode(GameNode *node, Board *b, bool onMainLine);
+    void printMove(GameNode *node, Board *b);
     void printComment(const QString &comment);
     void printNag(int nag);
     void printResult(int result);
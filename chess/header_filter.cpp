@@ -0,0 +1,289 @@
+#include "header_filter.h"
+#include <QTextCodec>
+#include <stdexcept>
+#include <cstring>
+
+const int NODE_COMPARE = 0;
+const int NODE_AND = 1;
+const int NODE_OR = 2;
+const int NODE_NOT = 3;
+
+chess::HeaderFilter::HeaderFilter(const QString &expression, const char* encoding) {
+    this->expression = expression;
+    this->encoding = encoding;
+    this->pos = 0;
+    this->root = this->parseOr();
+    this->skipSpaces();
+    if(!this->atEnd()) {
+        this->deleteNode(this->root);
+        throw std::invalid_argument("unexpected character at position " + std::to_string(this->pos + 1));
+    }
+}
+
+chess::HeaderFilter::~HeaderFilter() {
+    this->deleteNode(this->root);
+}
+
+void chess::HeaderFilter::deleteNode(FilterNode *node) {
+    if(node != 0) {
+        this->deleteNode(node->left);
+        this->deleteNode(node->right);
+        delete node;
+    }
+}
+
+bool chess::HeaderFilter::atEnd() {
+    return this->pos >= this->expression.size();
+}
+
+void chess::HeaderFilter::skipSpaces() {
+    while(!this->atEnd() && this->expression.at(this->pos).isSpace()) {
+        this->pos++;
+    }
+}
+
+bool chess::HeaderFilter::skipKeyword(const char *keyword) {
+    this->skipSpaces();
+    int length = strlen(keyword);
+    if(this->expression.mid(this->pos, length).compare(QString::fromLatin1(keyword), Qt::CaseInsensitive) != 0) {
+        return false;
+    }
+    // words must not continue, e.g. "order" is not "or"
+    bool word = QChar(keyword[0]).isLetter();
+    int next = this->pos + length;
+    if(word && next < this->expression.size()
+            && (this->expression.at(next).isLetterOrNumber() || this->expression.at(next) == '_')) {
+        return false;
+    }
+    this->pos = next;
+    return true;
+}
+
+QString chess::HeaderFilter::nextWord() {
+    this->skipSpaces();
+    int start = this->pos;
+    while(!this->atEnd() && (this->expression.at(this->pos).isLetterOrNumber()
+                             || this->expression.at(this->pos) == '_')) {
+        this->pos++;
+    }
+    return this->expression.mid(start, this->pos - start);
+}
+
+chess::FilterNode* chess::HeaderFilter::parseOr() {
+    FilterNode *left = this->parseAnd();
+    while(this->skipKeyword("or") || this->skipKeyword("||")) {
+        FilterNode *right = 0;
+        try {
+            right = this->parseAnd();
+        } catch(const std::invalid_argument &) {
+            this->deleteNode(left);
+            throw;
+        }
+        FilterNode *node = new FilterNode();
+        node->type = NODE_OR;
+        node->left = left;
+        node->right = right;
+        left = node;
+    }
+    return left;
+}
+
+chess::FilterNode* chess::HeaderFilter::parseAnd() {
+    FilterNode *left = this->parseNot();
+    while(this->skipKeyword("and") || this->skipKeyword("&&")) {
+        FilterNode *right = 0;
+        try {
+            right = this->parseNot();
+        } catch(const std::invalid_argument &) {
+            this->deleteNode(left);
+            throw;
+        }
+        FilterNode *node = new FilterNode();
+        node->type = NODE_AND;
+        node->left = left;
+        node->right = right;
+        left = node;
+    }
+    return left;
+}
+
+chess::FilterNode* chess::HeaderFilter::parseNot() {
+    if(this->skipKeyword("not") || this->skipKeyword("!")) {
+        FilterNode *node = new FilterNode();
+        node->type = NODE_NOT;
+        node->left = 0;
+        node->right = 0;
+        try {
+            node->left = this->parseNot();
+        } catch(const std::invalid_argument &) {
+            delete node;
+            throw;
+        }
+        return node;
+    }
+    if(this->skipKeyword("(")) {
+        FilterNode *node = this->parseOr();
+        if(!this->skipKeyword(")")) {
+            this->deleteNode(node);
+            throw std::invalid_argument("missing ) at position " + std::to_string(this->pos + 1));
+        }
+        return node;
+    }
+    return this->parseComparison();
+}
+
+chess::FilterNode* chess::HeaderFilter::parseComparison() {
+
+    QString tag = this->nextWord();
+    if(tag.isEmpty()) {
+        throw std::invalid_argument("tag name expected at position " + std::to_string(this->pos + 1));
+    }
+    int op = -1;
+    // two character operators first
+    if(this->skipKeyword("!=")) {
+        op = FILTER_NOT_EQUAL;
+    } else if(this->skipKeyword("<=")) {
+        op = FILTER_LESS_EQUAL;
+    } else if(this->skipKeyword(">=")) {
+        op = FILTER_GREATER_EQUAL;
+    } else if(this->skipKeyword("^=")) {
+        op = FILTER_PREFIX;
+    } else if(this->skipKeyword("=")) {
+        op = FILTER_EQUAL;
+    } else if(this->skipKeyword("<")) {
+        op = FILTER_LESS;
+    } else if(this->skipKeyword(">")) {
+        op = FILTER_GREATER;
+    } else if(this->skipKeyword("~")) {
+        op = FILTER_CONTAINS;
+    } else {
+        throw std::invalid_argument("operator expected at position " + std::to_string(this->pos + 1));
+    }
+    this->skipSpaces();
+    QString value;
+    if(!this->atEnd() && this->expression.at(this->pos) == '"') {
+        int end = this->expression.indexOf('"', this->pos + 1);
+        if(end < 0) {
+            throw std::invalid_argument("missing \" at position " + std::to_string(this->pos + 1));
+        }
+        value = this->expression.mid(this->pos + 1, end - this->pos - 1);
+        this->pos = end + 1;
+    } else {
+        int start = this->pos;
+        while(!this->atEnd() && !this->expression.at(this->pos).isSpace()
+              && this->expression.at(this->pos) != ')') {
+            this->pos++;
+        }
+        value = this->expression.mid(start, this->pos - start);
+        if(value.isEmpty()) {
+            throw std::invalid_argument("value expected at position " + std::to_string(this->pos + 1));
+        }
+    }
+    FilterNode *node = new FilterNode();
+    node->type = NODE_COMPARE;
+    node->tag = PgnHeaders::tagId(tag);
+    node->op = op;
+    node->literal = QTextCodec::codecForName(this->encoding)->fromUnicode(value);
+    node->number = value.toDouble(&node->numeric);
+    node->left = 0;
+    node->right = 0;
+    return node;
+}
+
+// parses the number at the start of a tag value. The fraction is only
+// read if the literal has one, i.e. Date>=2020 compares the year only
+static bool leadingNumber(const char *p, int length, bool fraction, double *number) {
+    const char *end = p + length;
+    while(p < end && *p == ' ') {
+        p++;
+    }
+    double sign = 1.0;
+    if(p < end && (*p == '-' || *p == '+')) {
+        sign = *p == '-' ? -1.0 : 1.0;
+        p++;
+    }
+    if(p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    double value = 0.0;
+    while(p < end && *p >= '0' && *p <= '9') {
+        value = value * 10.0 + (*p - '0');
+        p++;
+    }
+    if(fraction && p < end && *p == '.') {
+        p++;
+        double scale = 0.1;
+        while(p < end && *p >= '0' && *p <= '9') {
+            value += (*p - '0') * scale;
+            scale *= 0.1;
+            p++;
+        }
+    }
+    *number = sign * value;
+    return true;
+}
+
+bool chess::HeaderFilter::matches(const PgnHeaders &headers) const {
+    return this->evaluate(this->root, headers);
+}
+
+bool chess::HeaderFilter::evaluate(const FilterNode *node, const PgnHeaders &headers) const {
+
+    if(node->type == NODE_AND) {
+        return this->evaluate(node->left, headers) && this->evaluate(node->right, headers);
+    }
+    if(node->type == NODE_OR) {
+        return this->evaluate(node->left, headers) || this->evaluate(node->right, headers);
+    }
+    if(node->type == NODE_NOT) {
+        return !this->evaluate(node->left, headers);
+    }
+    int length = 0;
+    const char *raw = headers.rawValue(node->tag, &length);
+    if(raw == 0) {
+        raw = "";
+    }
+    const char *lit = node->literal.constData();
+    int litLength = node->literal.size();
+    if(node->op == FILTER_EQUAL) {
+        return length == litLength && memcmp(raw, lit, length) == 0;
+    }
+    if(node->op == FILTER_NOT_EQUAL) {
+        return !(length == litLength && memcmp(raw, lit, length) == 0);
+    }
+    if(node->op == FILTER_PREFIX) {
+        return length >= litLength && memcmp(raw, lit, litLength) == 0;
+    }
+    if(node->op == FILTER_CONTAINS) {
+        for(int i=0;i+litLength<=length;i++) {
+            if(memcmp(raw + i, lit, litLength) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    // ordering
+    int cmp = 0;
+    if(node->numeric) {
+        double value = 0.0;
+        if(!leadingNumber(raw, length, node->literal.contains('.'), &value)) {
+            return false;
+        }
+        cmp = value < node->number ? -1 : (value > node->number ? 1 : 0);
+    } else {
+        cmp = memcmp(raw, lit, qMin(length, litLength));
+        if(cmp == 0) {
+            cmp = length - litLength;
+        }
+    }
+    if(node->op == FILTER_LESS) {
+        return cmp < 0;
+    }
+    if(node->op == FILTER_LESS_EQUAL) {
+        return cmp <= 0;
+    }
+    if(node->op == FILTER_GREATER) {
+        return cmp > 0;
+    }
+    return cmp >= 0;
+}
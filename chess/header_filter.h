@@ -0,0 +1,94 @@
+#ifndef HEADER_FILTER_H
+#define HEADER_FILTER_H
+
+#include <QString>
+#include <QByteArray>
+#include "pgn_headers.h"
+
+namespace chess {
+
+const int FILTER_EQUAL = 0;
+const int FILTER_NOT_EQUAL = 1;
+const int FILTER_LESS = 2;
+const int FILTER_LESS_EQUAL = 3;
+const int FILTER_GREATER = 4;
+const int FILTER_GREATER_EQUAL = 5;
+const int FILTER_CONTAINS = 6;
+const int FILTER_PREFIX = 7;
+
+/**
+ * @brief FilterNode a node of a parsed filter expression: either a
+ *        comparison of a tag with a literal, or a logical operator
+ */
+struct FilterNode
+{
+    int type;
+    // comparison
+    int tag;
+    int op;
+    QByteArray literal;
+    bool numeric;
+    double number;
+    // and / or / not
+    FilterNode *left;
+    FilterNode *right;
+};
+
+class HeaderFilter
+{
+
+public:
+
+    /**
+     * @brief HeaderFilter parses a filter expression over the tags of a game.
+     *                     A comparison is
+     *                         Tag op value
+     *                     where op is one of = != < <= > >= ~ (contains) and
+     *                     ^= (starts with). Values can be quoted ("Carlsen, Magnus").
+     *                     If the value is a number, < <= > >= compare numerically
+     *                     (using the leading number of the tag value, e.g. the year
+     *                     of a date). Otherwise values are compared byte-wise.
+     *                     Comparisons are combined with and, or, not and
+     *                     parentheses, e.g.
+     *                         WhiteElo>=2500 and (ECO^=B9 or Date>=2020.01.01)
+     *                     A missing tag is an empty value (the Seven Tag Roster
+     *                     has the PGN defaults). throws std::invalid_argument on
+     *                     syntax errors
+     * @param expression the filter expression
+     * @param encoding encoding of the PGN file, see PgnReader::detect_encoding.
+     *                 Values are compared with the raw, still encoded tag values
+     */
+    HeaderFilter(const QString &expression, const char* encoding);
+    ~HeaderFilter();
+
+    /**
+     * @brief matches evaluates the filter. Can be called from several threads at once
+     * @param headers tags of the game, e.g. from PgnScanner::readHeaders
+     * @return true if the game passes the filter
+     */
+    bool matches(const PgnHeaders &headers) const;
+
+private:
+
+    FilterNode *root;
+    QString expression;
+    const char* encoding;
+    int pos;
+
+    FilterNode* parseOr();
+    FilterNode* parseAnd();
+    FilterNode* parseNot();
+    FilterNode* parseComparison();
+    QString nextWord();
+    bool skipKeyword(const char *keyword);
+    void skipSpaces();
+    bool atEnd();
+
+    bool evaluate(const FilterNode *node, const PgnHeaders &headers) const;
+    void deleteNode(FilterNode *node);
+
+};
+
+}
+
+#endif // HEADER_FILTER_H
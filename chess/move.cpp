@@ -26,146 +26,90 @@
 namespace chess {
 
 Move::Move(uint8_t from, uint8_t to) {
-
-    // create ascii (latin1) code numbers from
-    // uint8_t board pos numbers
-    QChar col_from = QChar((from % 10) + 96);
-    QChar row_from = QChar((from / 10) + 47);
-
-    QChar col_to = QChar((to % 10) + 96);
-    QChar row_to = QChar((to / 10) + 47);
-
-    this->from = from;
-    this->to = to;
-    this->promotion_piece = 0;
-    this->uci_string = QString(col_from) + row_from + col_to + row_to;
-    this->is_null = false;
-}
-
-/*
- * creates a null move
- */
-Move::Move() {
-    this->from = 0x00;
-    this->to = 0x00;
-    this->promotion_piece = 0;
-    this->uci_string = "0000";
-    this->is_null = true;
+    Q_ASSERT(from < 120 && to < 120 && SQUARE_64[from] >= 0 && SQUARE_64[to] >= 0);
+    this->bits = (uint16_t(SQUARE_64[from]) << 6) | uint16_t(SQUARE_64[to]);
 }
 
 Move::Move(uint8_t from, uint8_t to, uint8_t promotion_piece) {
-
-    QChar col_from = QChar((from % 10) + 96);
-    QChar row_from = QChar((from / 10) + 47);
-
-    QChar col_to = QChar((to % 10) + 96);
-    QChar row_to = QChar((to / 10) + 47);
-
-    QChar prom_piece;
-    if(promotion_piece == KNIGHT) {
-        prom_piece = QChar('N');
-    } else if (promotion_piece == BISHOP) {
-        prom_piece = QChar('B');
-    } else if (promotion_piece == ROOK) {
-        prom_piece = QChar('R');
-    } else if (promotion_piece == QUEEN) {
-        prom_piece = QChar('Q');
-    } else {
-        prom_piece = QChar(' ');
-    }
-    this->from = from;
-    this->to = to;
-    this->promotion_piece = promotion_piece;
-    if(prom_piece == QChar(' ')) {
-        this->uci_string = QString(col_from) + row_from + col_to + row_to;
-    } else {
-        this->uci_string = QString(col_from) + row_from + col_to + row_to + prom_piece;
-    }
-    this->is_null = false;
+    Q_ASSERT(from < 120 && to < 120 && SQUARE_64[from] >= 0 && SQUARE_64[to] >= 0);
+    Q_ASSERT(promotion_piece <= QUEEN);
+    this->bits = (uint16_t(promotion_piece) << 12)
+            | (uint16_t(SQUARE_64[from]) << 6) | uint16_t(SQUARE_64[to]);
 }
 
 Move::Move(QString uci) {
     assert((uci.size()==4) || (uci.size()==5));
-    this->uci_string = uci;
     QString up = uci.toUpper();
     uint8_t from_col = this->alpha_to_pos(up.at(0));
     // -49 for ascii(1) -> int 0, *10 + 20 is to get board coord
     uint8_t from_row = (uint8_t) ((up.at(1).toLatin1()-49) * 10)+20;
-    this->from = from_row + from_col;
+    uint8_t from = from_row + from_col;
     uint8_t to_col = this->alpha_to_pos(up.at(2));
     uint8_t to_row = (uint8_t) ((up.at(3).toLatin1() -49) * 10) + 20;
-    this->to = to_row + to_col;
+    uint8_t to = to_row + to_col;
+    assert(from < 120 && to < 120 && SQUARE_64[from] >= 0 && SQUARE_64[to] >= 0);
+    uint8_t promotion_piece = 0;
     if(uci.size() == 5) {
         QChar piece = up.at(4);
         assert(piece == QChar('N') || piece == QChar('B') ||
                piece == QChar('R') || piece == QChar('Q'));
         if(piece == QChar('N')) {
-            this->promotion_piece = KNIGHT;
+            promotion_piece = KNIGHT;
         }
         if(piece == QChar('B')) {
-            this->promotion_piece = BISHOP;
+            promotion_piece = BISHOP;
         }
         if(piece == QChar('R')) {
-            this->promotion_piece = ROOK;
+            promotion_piece = ROOK;
         }
         if(piece == QChar('Q')) {
-            this->promotion_piece = QUEEN;
+            promotion_piece = QUEEN;
         }
-    } else {
-        this->promotion_piece = 0;
     }
-    this->is_null = false;
+    this->bits = (uint16_t(promotion_piece) << 12)
+            | (uint16_t(SQUARE_64[from]) << 6) | uint16_t(SQUARE_64[to]);
 }
 
-QString Move::uci() {
-    if(this->is_null) {
+QString Move::uci() const {
+    if(this->is_null()) {
         return "0000";
     } else {
-        //return this->uci_string;
-        QChar col_from = QChar((this->from % 10) + 96);
-        QChar row_from = QChar((this->from / 10) + 47);
-
-        QChar col_to = QChar((this->to % 10) + 96);
-        QChar row_to = QChar((this->to / 10) + 47);
-
-        QString uci = QString(col_from) + row_from + col_to + row_to;
-        if(this->promotion_piece==BISHOP) {
-            uci.append("=B");
-        } else if(this->promotion_piece==KNIGHT) {
-            uci.append("=K");
-        } else if(this->promotion_piece==ROOK) {
-            uci.append("=R");
-        } else if(this->promotion_piece==QUEEN) {
-            uci.append("=Q");
-        } else {
-            return uci;
+        int from = this->from_square();
+        int to = this->to_square();
+        char uci[6];
+        uci[0] = 'a' + (from % 8);
+        uci[1] = '1' + (from / 8);
+        uci[2] = 'a' + (to % 8);
+        uci[3] = '1' + (to / 8);
+        int len = 4;
+        uint8_t promotion_piece = this->promotion_piece();
+        if(promotion_piece==BISHOP) {
+            uci[len++] = '=';
+            uci[len++] = 'B';
+        } else if(promotion_piece==KNIGHT) {
+            uci[len++] = '=';
+            uci[len++] = 'K';
+        } else if(promotion_piece==ROOK) {
+            uci[len++] = '=';
+            uci[len++] = 'R';
+        } else if(promotion_piece==QUEEN) {
+            uci[len++] = '=';
+            uci[len++] = 'Q';
         }
-        return uci;
+        return QString::fromLatin1(uci, len);
     }
 }
 
-QPoint Move::fromAsXY() {
-    int col_from = (this->from % 10) - 1;
-    int row_from = (this->from / 10) - 2;
-    return QPoint(col_from, row_from);
-}
-
-QPoint Move::toAsXY() {
-    int col_to = (this->to % 10) - 1;
-    int row_to = (this->to / 10) - 2;
-    return QPoint(col_to, row_to);
+QPoint Move::fromAsXY() const {
+    int from = this->from_square();
+    return QPoint(from % 8, from / 8);
 }
 
-// create deep copy
-Move::Move(const Move& m) {
-    this->from = m.from;
-    this->to = m.to;
-    this->promotion_piece = m.promotion_piece;
-    this->is_null = m.is_null;
-    this->uci_string = this->uci(); // QString::fromUtf16(m.uci_string.utf16());
+QPoint Move::toAsXY() const {
+    int to = this->to_square();
+    return QPoint(to % 8, to / 8);
 }
 
-
 uint8_t Move::alpha_to_pos(QChar alpha) {
     if(alpha == QChar('A')) {
         return 1;
@@ -188,17 +132,6 @@ uint8_t Move::alpha_to_pos(QChar alpha) {
     return 0;
 }
 
-bool Move::operator==(const Move &other) const {
-    return (this->from == other.from
-            && this->to == other.to
-            && this->promotion_piece == other.promotion_piece
-            && this->is_null == other.is_null);
-}
-
-bool Move::operator!=(const Move &other) const {
-  return !(*this == other);
-}
-
 /**
  * @brief operator <<
  * @param strm
@@ -213,7 +146,7 @@ bool Move::operator!=(const Move &other) const {
  */
 std::ostream& operator<<(std::ostream &strm, const Move &m) {
 
-    return strm << m.uci_string.toStdString();
+    return strm << m.uci().toStdString();
 
 }
 
@@ -24,6 +24,8 @@
 #include <QString>
 #include <tuple>
 #include <QPoint>
+#include <type_traits>
+#include "bitboard.h"
 
 
 namespace chess {
@@ -38,21 +40,23 @@ const uint8_t QUEEN = 5;
 const uint8_t KING = 6;
 
 
+/**
+ * @brief Move a move packed into 16 bits, in the same layout as
+ *             moves are stored in DCG databases:
+ *             bits 0-5 target square, bits 6-11 source square (both
+ *             0 = A1 ... 63 = H8), bits 12-14 promotion piece type.
+ *             The null move is 0, which is never a real move (a1a1).
+ *             Trivially copyable, so moves can be passed and stored by value.
+ */
 class Move
 {
 
 public:
 
-    uint8_t from;
-    uint8_t to;
-    uint8_t promotion_piece;
-    QString uci_string;
-    bool is_null;
-
     /**
      * @brief Move creates a null move
      */
-    Move();
+    Move() { this->bits = 0; }
     /**
      * @brief Move creates move, supplied parameters in internal
      *             board coordinate format, i.e. in range 21...98.
@@ -76,15 +80,11 @@ public:
     Move(uint8_t from, uint8_t to, uint8_t promotion_piece);
 
     /**
-     * @brief Move creates a move with en passent capture
-     *             Does not check any validity (i.e. whether
-     *             en passent is possible, source is a pawn, move is legal etc.)
-     *             supplied parameters in internal
-     *             board coordinate format, i.e. in range 21...98.     * @param from
-     * @param to
-     * @param en_passent
+     * @brief Move en passent captures are not marked in the move, they are
+     *             created with Move(from, to). Deleted, so that a bool is not
+     *             taken as promotion piece by the constructor above
      */
-    Move(uint8_t from, uint8_t to, bool en_passent);
+    Move(uint8_t from, uint8_t to, bool en_passent) = delete;
 
     /**
      * @brief Move creates move from uci string (e.g. g1f3, d7d8Q etc.)
@@ -93,43 +93,94 @@ public:
     Move(QString uci);
 
     /**
-     * @brief Move creates a deep copy of supplied move
-     * @param m the move to copy
+     * @brief from_encoding creates a move from its 16 bit encoding
+     *                      (cf. encoding()). Does not check any validity
+     */
+    static Move from_encoding(uint16_t encoding) {
+        Move m;
+        m.bits = encoding & 0x7FFF;
+        return m;
+    }
+
+    /**
+     * @brief from_squares creates a move from bitboard squares (0 ... 63),
+     *                     for move generation. Does not check any validity
+     */
+    static Move from_squares(int from, int to, uint8_t promotion_piece = 0) {
+        return from_encoding((uint16_t(promotion_piece) << 12) | (from << 6) | to);
+    }
+
+    /**
+     * @brief encoding the 16 bit encoding of the move, as stored in DCG databases
      */
-    Move(const Move& m);
+    uint16_t encoding() const { return this->bits; }
 
     /**
-     * @brief uci get uci string (e.g. g1f3, d7d8Q etc.) of current move
+     * @brief from index of source field in internal board
+     *             coordinate format. Undefined for the null move
+     */
+    uint8_t from() const { return SQUARE_120[this->from_square()]; }
+
+    /**
+     * @brief to index of target field in internal board
+     *           coordinate format. Undefined for the null move
+     */
+    uint8_t to() const { return SQUARE_120[this->to_square()]; }
+
+    /**
+     * @brief from_square source square as bitboard square (0 ... 63)
+     */
+    int from_square() const { return (this->bits >> 6) & 0x3F; }
+
+    /**
+     * @brief to_square target square as bitboard square (0 ... 63)
+     */
+    int to_square() const { return this->bits & 0x3F; }
+
+    /**
+     * @brief promotion_piece piece type of the promotion piece, 0 if none
+     */
+    uint8_t promotion_piece() const { return (this->bits >> 12) & 0x07; }
+
+    bool is_null() const { return this->bits == 0; }
+
+    /**
+     * @brief uci get uci string (e.g. g1f3, d7d8=Q etc.) of current move.
+     *            Formatted on each call
      * @return uci string
      */
-    QString uci();
+    QString uci() const;
 
     /**
      * @brief operator == compares two moves by checking whether they
      *                    are semantically the same, i.e. same source square,
-     *                    same target, same promotion, both (or both not) en passent.
+     *                    same target and same promotion (i.e. same encoding).
      * @param other
      * @return true if moves are semantically same (does not care about memory)
      */
-    bool operator==(const Move &other) const;
+    bool operator==(const Move &other) const { return this->bits == other.bits; }
 
     /**
      * @brief operator !=  see ==
      * @param other
      * @return
      */
-    bool operator!=(const Move &other) const;
+    bool operator!=(const Move &other) const { return this->bits != other.bits; }
 
-    QPoint fromAsXY();
-    QPoint toAsXY();
+    QPoint fromAsXY() const;
+    QPoint toAsXY() const;
 
 private:
 
+    uint16_t bits;
+
     uint8_t alpha_to_pos(QChar alpha);
-    std::tuple<char, uint8_t> get_alphanum_coord(uint8_t internal_pos);
     friend std::ostream& operator<<(std::ostream& strm, const Move &m);
 
 };
 
+static_assert(sizeof(Move) == 2, "Move must fit into 16 bits");
+static_assert(std::is_trivially_copyable<Move>::value, "Move must be trivially copyable");
+
 }
 #endif // MOVE_H
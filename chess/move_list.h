@@ -0,0 +1,73 @@
+#ifndef MOVE_LIST_H
+#define MOVE_LIST_H
+
+#include "move.h"
+
+namespace chess {
+
+// no position has more than 218 legal moves
+const int MAX_MOVES = 256;
+
+/**
+ * @brief MoveList a list of at most MAX_MOVES moves, stored inline (i.e. on the
+ *        stack for a local variable) so that move generation doesn't allocate.
+ *        Has the read functions of a QList and iterators, so it can be used
+ *        with range-based for loops.
+ */
+class MoveList
+{
+
+public:
+
+    typedef Move* iterator;
+    typedef const Move* const_iterator;
+
+    MoveList() {
+        this->n = 0;
+    }
+
+    /**
+     * @brief append adds a move. The list must not be full
+     */
+    void append(const Move &m) {
+        Q_ASSERT(this->n < MAX_MOVES);
+        this->moves[this->n] = m;
+        this->n++;
+    }
+
+    void clear() {
+        this->n = 0;
+    }
+
+    int size() const { return this->n; }
+    int count() const { return this->n; }
+    bool isEmpty() const { return this->n == 0; }
+
+    const Move& at(int i) const { return this->moves[i]; }
+    const Move& operator[](int i) const { return this->moves[i]; }
+    Move& operator[](int i) { return this->moves[i]; }
+
+    bool contains(const Move &m) const {
+        for(int i=0;i<this->n;i++) {
+            if(this->moves[i] == m) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    iterator begin() { return this->moves; }
+    iterator end() { return this->moves + this->n; }
+    const_iterator begin() const { return this->moves; }
+    const_iterator end() const { return this->moves + this->n; }
+
+private:
+
+    Move moves[MAX_MOVES];
+    int n;
+
+};
+
+}
+
+#endif // MOVE_LIST_H
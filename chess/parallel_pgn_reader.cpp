@@ -0,0 +1,272 @@
+#include "parallel_pgn_reader.h"
+#include "pgn_reader.h"
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+#include <stdexcept>
+
+namespace chess {
+
+/**
+ * @brief PgnChunkParser parses all games of one chunk. Each task
+ *        uses its own scanner state and reader, and only shares the
+ *        (read-only) file data.
+ */
+class PgnChunkParser : public QRunnable
+{
+
+public:
+    PgnChunkParser(const char *data, qint64 size, PgnIndex *index, const HeaderFilter *filter,
+                   const char* encoding, bool lazy, PgnChunk *chunk, QMutex *mutex, QWaitCondition *chunkDone) {
+        this->data = data;
+        this->size = size;
+        this->index = index;
+        this->filter = filter;
+        this->encoding = encoding;
+        this->lazy = lazy;
+        this->chunk = chunk;
+        this->mutex = mutex;
+        this->chunkDone = chunkDone;
+    }
+
+    void run() {
+        PgnScanner scanner(this->data, this->size);
+        if(this->index != 0) {
+            for(int i=this->chunk->firstGame;i<this->chunk->lastGame;i++) {
+                this->parse(&scanner, this->index->at(i));
+            }
+        } else {
+            scanner.setRange(this->chunk->begin, this->chunk->end);
+            while(scanner.hasNext()) {
+                this->parse(&scanner, scanner.next());
+            }
+        }
+        QMutexLocker locker(this->mutex);
+        this->chunk->games = this->games;
+        this->chunk->errors = this->errors;
+        this->chunk->done = true;
+        this->chunkDone->wakeAll();
+    }
+
+private:
+    const char *data;
+    qint64 size;
+    PgnIndex *index;
+    const HeaderFilter *filter;
+    const char* encoding;
+    bool lazy;
+    PgnChunk *chunk;
+    QMutex *mutex;
+    QWaitCondition *chunkDone;
+    PgnReader reader;
+    PgnHeaders headers;
+    QList<Game*> games;
+    QList<std::string> errors;
+
+    void parse(PgnScanner *scanner, const GameSpan &span) {
+        if(this->filter != 0) {
+            // decide on the raw tags, w/o touching the movetext
+            scanner->readHeaders(span, this->encoding, &this->headers);
+            if(!this->filter->matches(this->headers)) {
+                return;
+            }
+        }
+        try {
+            Game *g = 0;
+            if(this->lazy) {
+                g = this->reader.readLazyGameFromBytes(this->data + span.offset, span.length, this->encoding);
+            } else {
+                g = this->reader.readGameFromBytes(this->data + span.offset, span.length, this->encoding);
+            }
+            this->games.append(g);
+            this->errors.append(std::string());
+        } catch(const std::invalid_argument &e) {
+            this->games.append(0);
+            this->errors.append(std::string(e.what()));
+        }
+    }
+
+};
+
+}
+
+// lower and upper bound for the size of one chunk in bytes
+const qint64 MIN_CHUNK_SIZE = 64 * 1024;
+const qint64 MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+
+chess::ParallelPgnReader::ParallelPgnReader(PgnScanner *scanner, const char* encoding, int threads, PgnIndex *index,
+                                            const HeaderFilter *filter, bool lazy) {
+
+    this->scanner = scanner;
+    this->index = index;
+    this->filter = filter;
+    this->encoding = encoding;
+    this->lazy = lazy;
+    this->blocks = 0;
+    this->init(threads);
+}
+
+chess::ParallelPgnReader::ParallelPgnReader(PgnBlockReader *blocks, const char* encoding, int threads,
+                                            const HeaderFilter *filter, bool lazy) {
+
+    this->scanner = 0;
+    this->index = 0;
+    this->filter = filter;
+    this->encoding = encoding;
+    this->lazy = lazy;
+    this->blocks = blocks;
+    this->init(threads);
+}
+
+void chess::ParallelPgnReader::init(int threads) {
+
+    if(threads <= 0) {
+        threads = QThread::idealThreadCount();
+    }
+    this->pool = new QThreadPool();
+    this->pool->setMaxThreadCount(threads);
+
+    // a few chunks per thread keep all threads busy even if chunks take
+    // different amounts of time, while bounding the number of parsed
+    // games that wait for the consumer
+    this->maxChunks = 4 * threads;
+    this->chunkSize = MIN_CHUNK_SIZE;
+    this->nextBegin = 0;
+    this->nextGameInIndex = 0;
+    this->gameIndex = 0;
+    this->blocksDone = false;
+    if(this->scanner != 0) {
+        this->setChunkSize();
+    }
+    this->submit();
+}
+
+void chess::ParallelPgnReader::setChunkSize() {
+
+    this->chunkSize = this->scanner->size() / this->maxChunks;
+    if(this->chunkSize < MIN_CHUNK_SIZE) {
+        this->chunkSize = MIN_CHUNK_SIZE;
+    }
+    if(this->chunkSize > MAX_CHUNK_SIZE) {
+        this->chunkSize = MAX_CHUNK_SIZE;
+    }
+}
+
+chess::ParallelPgnReader::~ParallelPgnReader() {
+    this->pool->waitForDone();
+    delete this->pool;
+    if(this->blocks != 0) {
+        delete this->scanner;
+    }
+    for(int i=0;i<this->chunks.size();i++) {
+        PgnChunk *chunk = this->chunks.at(i);
+        for(int j=this->gameIndex;j<chunk->games.size();j++) {
+            delete chunk->games.at(j);
+        }
+        // only the first chunk is partially consumed
+        this->gameIndex = 0;
+        delete chunk;
+    }
+    this->chunks.clear();
+}
+
+void chess::ParallelPgnReader::submit() {
+
+    while(this->chunks.size() < this->maxChunks) {
+        if((this->scanner == 0 || this->nextBegin >= this->scanner->size()) && !this->readBlock()) {
+            break;
+        }
+        qint64 size = this->scanner->size();
+        PgnChunk *chunk = new PgnChunk();
+        chunk->begin = this->nextBegin;
+        chunk->end = size;
+        chunk->firstGame = 0;
+        chunk->lastGame = 0;
+        chunk->done = false;
+        if(this->index != 0) {
+            // take whole games until the chunk is large enough
+            int games = this->index->count();
+            int last = this->nextGameInIndex;
+            while(last < games && this->index->at(last).offset < this->nextBegin + this->chunkSize) {
+                last++;
+            }
+            if(last == this->nextGameInIndex && last < games) {
+                last++;
+            }
+            if(last < games) {
+                chunk->end = this->index->at(last).offset;
+            }
+            chunk->firstGame = this->nextGameInIndex;
+            chunk->lastGame = last;
+            this->nextGameInIndex = last;
+        } else if(this->nextBegin + this->chunkSize < size) {
+            chunk->end = this->scanner->resync(this->nextBegin + this->chunkSize);
+        }
+        const char *data = this->scanner->data();
+        if(this->blocks != 0) {
+            chunk->block = this->block;
+            data = chunk->block.constData();
+        }
+        this->chunks.append(chunk);
+        this->pool->start(new PgnChunkParser(data, size, this->index, this->filter,
+                                             this->encoding, this->lazy, chunk, &this->mutex, &this->chunkDone));
+        this->nextBegin = chunk->end;
+    }
+}
+
+bool chess::ParallelPgnReader::readBlock() {
+
+    if(this->blocks == 0 || this->blocksDone) {
+        return false;
+    }
+    // chunks that are still parsed keep their block alive
+    delete this->scanner;
+    this->scanner = 0;
+    this->block = QByteArray();
+    qint64 offset = 0;
+    try {
+        this->blocksDone = !this->blocks->nextBlock(&this->block, &offset);
+    } catch(const std::invalid_argument &e) {
+        this->blocksDone = true;
+        this->blockError = std::string(e.what());
+    }
+    if(this->blocksDone) {
+        return false;
+    }
+    this->scanner = new PgnScanner(this->block.constData(), this->block.size());
+    this->nextBegin = 0;
+    this->setChunkSize();
+    return true;
+}
+
+chess::Game* chess::ParallelPgnReader::nextGame() {
+
+    while(!this->chunks.isEmpty()) {
+        PgnChunk *chunk = this->chunks.first();
+        this->mutex.lock();
+        while(!chunk->done) {
+            this->chunkDone.wait(&this->mutex);
+        }
+        this->mutex.unlock();
+        if(this->gameIndex < chunk->games.size()) {
+            Game *g = chunk->games.at(this->gameIndex);
+            std::string error = chunk->errors.at(this->gameIndex);
+            this->gameIndex++;
+            if(g == 0) {
+                throw std::invalid_argument(error);
+            }
+            return g;
+        }
+        // chunk is consumed, hand the next one to the pool
+        this->chunks.removeFirst();
+        delete chunk;
+        this->gameIndex = 0;
+        this->submit();
+    }
+    if(!this->blockError.empty()) {
+        std::string error = this->blockError;
+        this->blockError.clear();
+        throw std::invalid_argument(error);
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#ifndef PARALLEL_PGN_READER_H
+#define PARALLEL_PGN_READER_H
+
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <string>
+#include "game.h"
+#include "pgn_scanner.h"
+#include "pgn_index.h"
+#include "header_filter.h"
+#include "pgn_block_reader.h"
+
+namespace chess {
+
+/**
+ * @brief PgnChunk is a byte range of a PGN file that starts at a
+ *        game boundary, together with the games parsed from it.
+ *        games and errors are only valid once done is set.
+ */
+struct PgnChunk
+{
+    qint64 begin;
+    qint64 end;
+    // if the file is indexed, the games of the chunk are
+    // [firstGame, lastGame) of the index and are not scanned
+    int firstGame;
+    int lastGame;
+    QList<Game*> games;
+    // error message for each game that failed to parse (game is then 0)
+    QList<std::string> errors;
+    bool done;
+    // block of a compressed file that the chunk is part of. keeps
+    // the data alive while the reader moves on to the next block
+    QByteArray block;
+};
+
+class ParallelPgnReader
+{
+
+public:
+
+    /**
+     * @brief ParallelPgnReader parses the games of a PGN file on a pool of
+     *                          threads. The file is split into byte ranges
+     *                          which are resynchronized to game boundaries
+     *                          (cf. PgnScanner::resync). Each range is parsed
+     *                          by one worker, and games are handed out in
+     *                          the order of the file.
+     * @param scanner scanner of the PGN file. must outlive the reader
+     * @param encoding encoding of the file, see PgnReader::detect_encoding
+     * @param threads number of worker threads. 0 uses one thread per core
+     * @param index game index of the file (optional). If supplied, ranges
+     *              end exactly at game boundaries, and are not scanned again.
+     *              must outlive the reader
+     * @param filter only games whose headers match the filter are parsed
+     *               and returned (optional). Other games are skipped before
+     *               their movetext is read. must outlive the reader
+     * @param lazy if true, only the headers of the games are read, and the
+     *             movetext is parsed on first access to the game tree (cf.
+     *             PgnReader::readLazyGameFromBytes), e.g. to list games
+     */
+    ParallelPgnReader(PgnScanner *scanner, const char* encoding, int threads, PgnIndex *index = 0,
+                      const HeaderFilter *filter = 0, bool lazy = false);
+
+    /**
+     * @brief ParallelPgnReader same as above, but parses the blocks of a
+     *                          compressed file (cf. PgnBlockReader). Chunks
+     *                          of the next block are handed to the pool as
+     *                          soon as the current block is split up, so the
+     *                          workers don't run dry at block boundaries.
+     *                          If the compressed data is corrupt, nextGame()
+     *                          throws std::invalid_argument after the games
+     *                          before the corrupt data have been returned.
+     * @param blocks started block reader. must outlive the reader
+     * @param encoding encoding of the file, see PgnReader::detect_encoding
+     * @param threads number of worker threads. 0 uses one thread per core
+     * @param filter see above
+     * @param lazy see above
+     */
+    ParallelPgnReader(PgnBlockReader *blocks, const char* encoding, int threads,
+                      const HeaderFilter *filter = 0, bool lazy = false);
+    ~ParallelPgnReader();
+
+    /**
+     * @brief nextGame returns the next game of the file, waiting until
+     *                 it is parsed if necessary. throws std::invalid_argument
+     *                 if that game could not be parsed (cf. readGameFromFile).
+     *                 Caller takes ownership.
+     * @return next game, or 0 if all games have been read
+     */
+    Game* nextGame();
+
+private:
+
+    PgnScanner *scanner;
+    PgnIndex *index;
+    const HeaderFilter *filter;
+    const char* encoding;
+    bool lazy;
+    QThreadPool *pool;
+    QMutex mutex;
+    QWaitCondition chunkDone;
+
+    // chunks handed to the pool, in file order
+    QList<PgnChunk*> chunks;
+    int maxChunks;
+    qint64 chunkSize;
+    qint64 nextBegin;
+    int nextGameInIndex;
+    int gameIndex;
+
+    // compressed files: the scanner is owned and scans the current block
+    PgnBlockReader *blocks;
+    QByteArray block;
+    bool blocksDone;
+    std::string blockError;
+
+    void init(int threads);
+    void setChunkSize();
+    void submit();
+    bool readBlock();
+
+};
+
+}
+
+#endif // PARALLEL_PGN_READER_H
@@ -0,0 +1,108 @@
+#include "pgn_block_reader.h"
+#include "pgn_scanner.h"
+#include <QMutexLocker>
+#include <stdexcept>
+
+chess::PgnBlockReader::PgnBlockReader(const QString &filename, qint64 blockSize) {
+    this->decompressor = new PgnDecompressor(filename);
+    this->blockSize = blockSize;
+    this->readyOffset = 0;
+    this->hasReady = false;
+    this->finished = false;
+    this->stopped = false;
+}
+
+chess::PgnBlockReader::~PgnBlockReader() {
+    this->mutex.lock();
+    this->stopped = true;
+    this->changed.wakeAll();
+    this->mutex.unlock();
+    this->wait();
+    delete this->decompressor;
+}
+
+bool chess::PgnBlockReader::publish(const QByteArray &block, qint64 offset) {
+    // wait until the consumer took the previous block
+    QMutexLocker locker(&this->mutex);
+    while(this->hasReady && !this->stopped) {
+        this->changed.wait(&this->mutex);
+    }
+    if(this->stopped) {
+        return false;
+    }
+    this->ready = block;
+    this->readyOffset = offset;
+    this->checkpointList = this->decompressor->checkpoints();
+    this->hasReady = true;
+    this->changed.wakeAll();
+    return true;
+}
+
+void chess::PgnBlockReader::run() {
+
+    // decompressed data that is not yet handed out. always
+    // starts at a game boundary
+    QByteArray pending;
+    qint64 pendingOffset = 0;
+    try {
+        bool atEnd = false;
+        while(!atEnd) {
+            qint64 size = pending.size();
+            pending.resize(size + this->blockSize);
+            qint64 n = this->decompressor->read(pending.data() + size, this->blockSize);
+            pending.resize(size + n);
+            atEnd = n == 0;
+            qint64 cut = pending.size();
+            if(!atEnd) {
+                // cut at the first game boundary in the new data. the
+                // last game might continue in the next block
+                qint64 searchFrom = size > 0 ? size : n / 2;
+                PgnScanner scanner(pending.constData(), pending.size());
+                cut = scanner.resync(qMax(searchFrom, qint64(1)));
+                if(cut == pending.size()) {
+                    continue;
+                }
+            }
+            if(cut > 0) {
+                if(!this->publish(pending.left(cut), pendingOffset)) {
+                    return;
+                }
+                pending.remove(0, cut);
+                pendingOffset += cut;
+            }
+        }
+    } catch(const std::invalid_argument &e) {
+        QMutexLocker locker(&this->mutex);
+        this->error = std::string(e.what());
+    }
+    QMutexLocker locker(&this->mutex);
+    this->checkpointList = this->decompressor->checkpoints();
+    this->finished = true;
+    this->changed.wakeAll();
+}
+
+bool chess::PgnBlockReader::nextBlock(QByteArray *block, qint64 *offset) {
+
+    QMutexLocker locker(&this->mutex);
+    while(!this->hasReady && !this->finished) {
+        this->changed.wait(&this->mutex);
+    }
+    if(this->hasReady) {
+        *block = this->ready;
+        *offset = this->readyOffset;
+        this->ready = QByteArray();
+        this->hasReady = false;
+        this->changed.wakeAll();
+        return true;
+    }
+    if(!this->error.empty()) {
+        throw std::invalid_argument(this->error);
+    }
+    return false;
+}
+
+QList<chess::PgnCheckpoint> chess::PgnBlockReader::checkpoints() {
+    // copied by the reader thread, which owns the decompressor
+    QMutexLocker locker(&this->mutex);
+    return this->checkpointList;
+}
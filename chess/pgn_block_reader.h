@@ -0,0 +1,74 @@
+#ifndef PGN_BLOCK_READER_H
+#define PGN_BLOCK_READER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QList>
+#include <string>
+#include "pgn_decompressor.h"
+
+namespace chess {
+
+class PgnBlockReader : public QThread
+{
+
+public:
+
+    /**
+     * @brief PgnBlockReader decompresses a PGN file on its own thread and
+     *                       hands it out in blocks that end at game
+     *                       boundaries (cf. PgnScanner::resync). One block is
+     *                       decompressed while the previous one is parsed.
+     *                       Call start() to begin reading. throws
+     *                       std::invalid_argument like PgnDecompressor
+     * @param filename name of the compressed file
+     * @param blockSize (minimum) size of a block in bytes
+     */
+    PgnBlockReader(const QString &filename, qint64 blockSize = 8 * 1024 * 1024);
+    ~PgnBlockReader();
+
+    /**
+     * @brief nextBlock returns the next block of complete games, waiting
+     *                  until it is decompressed if necessary. throws
+     *                  std::invalid_argument if the compressed data is corrupt
+     * @param block receives the decompressed bytes
+     * @param offset receives the offset of the block in the decompressed data
+     * @return false if all blocks have been read
+     */
+    bool nextBlock(QByteArray *block, qint64 *offset);
+
+    /**
+     * @brief checkpoints restart points of the file that were passed so far
+     *                    (cf. PgnIndex::updateCompressed). Complete once
+     *                    nextBlock() returned false
+     */
+    QList<PgnCheckpoint> checkpoints();
+
+protected:
+    void run();
+
+private:
+
+    PgnDecompressor *decompressor;
+    qint64 blockSize;
+    QMutex mutex;
+    QWaitCondition changed;
+
+    // the decompressed block that waits for the consumer
+    QByteArray ready;
+    qint64 readyOffset;
+    bool hasReady;
+    bool finished;
+    bool stopped;
+    std::string error;
+    QList<PgnCheckpoint> checkpointList;
+
+    bool publish(const QByteArray &block, qint64 offset);
+
+};
+
+}
+
+#endif // PGN_BLOCK_READER_H
@@ -0,0 +1,342 @@
+#include "pgn_decompressor.h"
+#include <stdexcept>
+#include <cstring>
+#include <zlib.h>
+#ifdef PGN_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef PGN_WITH_BZIP2
+#include <bzlib.h>
+#endif
+
+// size of the buffer for compressed input
+const qint64 INPUT_BUFFER_SIZE = 256 * 1024;
+
+chess::PgnDecompressor::PgnDecompressor(const QString &filename) {
+
+    this->compression = detect(filename);
+    if(this->compression == COMPRESSION_NONE) {
+        throw std::invalid_argument("file is not compressed");
+    }
+    if(!isSupported(this->compression)) {
+        throw std::invalid_argument("compression format not supported by this build");
+    }
+    this->file.setFileName(filename);
+    if(!this->file.open(QFile::ReadOnly)) {
+        throw std::invalid_argument("unable to open file w/ supplied filename");
+    }
+    this->input.resize(INPUT_BUFFER_SIZE);
+    this->stream = 0;
+    this->restart(0, 0);
+}
+
+chess::PgnDecompressor::~PgnDecompressor() {
+    this->endStream();
+    this->file.close();
+}
+
+int chess::PgnDecompressor::detect(const QString &filename) {
+
+    QFile f(filename);
+    if(!f.open(QFile::ReadOnly)) {
+        return COMPRESSION_NONE;
+    }
+    QByteArray magic = f.read(4);
+    f.close();
+    if(magic.size() >= 2 && quint8(magic.at(0)) == 0x1f && quint8(magic.at(1)) == 0x8b) {
+        return COMPRESSION_GZIP;
+    }
+    if(magic.size() == 4 && quint8(magic.at(0)) == 0x28 && quint8(magic.at(1)) == 0xb5
+            && quint8(magic.at(2)) == 0x2f && quint8(magic.at(3)) == 0xfd) {
+        return COMPRESSION_ZSTD;
+    }
+    if(magic.size() >= 3 && magic.at(0) == 'B' && magic.at(1) == 'Z' && magic.at(2) == 'h') {
+        return COMPRESSION_BZIP2;
+    }
+    return COMPRESSION_NONE;
+}
+
+bool chess::PgnDecompressor::isSupported(int compression) {
+    if(compression == COMPRESSION_GZIP) {
+        return true;
+    }
+#ifdef PGN_WITH_ZSTD
+    if(compression == COMPRESSION_ZSTD) {
+        return true;
+    }
+#endif
+#ifdef PGN_WITH_BZIP2
+    if(compression == COMPRESSION_BZIP2) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+qint64 chess::PgnDecompressor::pos() {
+    return this->outputPos;
+}
+
+const QList<chess::PgnCheckpoint>& chess::PgnDecompressor::checkpoints() {
+    return this->restartPoints;
+}
+
+bool chess::PgnDecompressor::fillInput() {
+    this->inputOffset += this->inputLength;
+    this->inputPos = 0;
+    this->inputLength = this->file.read(this->input.data(), this->input.size());
+    if(this->inputLength < 0) {
+        this->inputLength = 0;
+    }
+    return this->inputLength > 0;
+}
+
+bool chess::PgnDecompressor::ensureInput(qint64 length) {
+    // keeps the unread input and appends to it, so
+    // that at least length bytes can be looked at
+    qint64 available = this->inputLength - this->inputPos;
+    if(available >= length) {
+        return true;
+    }
+    memmove(this->input.data(), this->input.constData() + this->inputPos, available);
+    this->inputOffset += this->inputPos;
+    this->inputPos = 0;
+    this->inputLength = available;
+    while(this->inputLength < length) {
+        qint64 n = this->file.read(this->input.data() + this->inputLength, this->input.size() - this->inputLength);
+        if(n <= 0) {
+            break;
+        }
+        this->inputLength += n;
+    }
+    return this->inputLength >= length;
+}
+
+void chess::PgnDecompressor::restart(qint64 compressedOffset, qint64 offset) {
+    this->file.seek(compressedOffset);
+    this->inputOffset = compressedOffset;
+    this->inputPos = 0;
+    this->inputLength = 0;
+    this->outputPos = offset;
+    this->atBoundary = true;
+    this->finished = false;
+}
+
+void chess::PgnDecompressor::initStream() {
+    // (re)initializes the decoder at the start of a member / frame / stream
+    if(this->compression == COMPRESSION_GZIP) {
+        z_stream *z = (z_stream*) this->stream;
+        if(z == 0) {
+            z = new z_stream();
+            z->zalloc = Z_NULL;
+            z->zfree = Z_NULL;
+            z->opaque = Z_NULL;
+            if(inflateInit2(z, 15 + 16) != Z_OK) {
+                delete z;
+                throw std::invalid_argument("unable to initialize gzip decoder");
+            }
+            this->stream = z;
+        } else {
+            inflateReset(z);
+        }
+    }
+#ifdef PGN_WITH_ZSTD
+    if(this->compression == COMPRESSION_ZSTD) {
+        ZSTD_DStream *zs = (ZSTD_DStream*) this->stream;
+        if(zs == 0) {
+            zs = ZSTD_createDStream();
+            this->stream = zs;
+        }
+        ZSTD_initDStream(zs);
+    }
+#endif
+#ifdef PGN_WITH_BZIP2
+    if(this->compression == COMPRESSION_BZIP2) {
+        bz_stream *bz = (bz_stream*) this->stream;
+        if(bz != 0) {
+            BZ2_bzDecompressEnd(bz);
+        } else {
+            bz = new bz_stream();
+            this->stream = bz;
+        }
+        bz->bzalloc = 0;
+        bz->bzfree = 0;
+        bz->opaque = 0;
+        if(BZ2_bzDecompressInit(bz, 0, 0) != BZ_OK) {
+            throw std::invalid_argument("unable to initialize bzip2 decoder");
+        }
+    }
+#endif
+}
+
+void chess::PgnDecompressor::endStream() {
+    if(this->stream == 0) {
+        return;
+    }
+    if(this->compression == COMPRESSION_GZIP) {
+        z_stream *z = (z_stream*) this->stream;
+        inflateEnd(z);
+        delete z;
+    }
+#ifdef PGN_WITH_ZSTD
+    if(this->compression == COMPRESSION_ZSTD) {
+        ZSTD_freeDStream((ZSTD_DStream*) this->stream);
+    }
+#endif
+#ifdef PGN_WITH_BZIP2
+    if(this->compression == COMPRESSION_BZIP2) {
+        bz_stream *bz = (bz_stream*) this->stream;
+        BZ2_bzDecompressEnd(bz);
+        delete bz;
+    }
+#endif
+    this->stream = 0;
+}
+
+qint64 chess::PgnDecompressor::read(char *out, qint64 max) {
+
+    qint64 produced = 0;
+    while(produced < max && !this->finished) {
+        if(this->inputPos == this->inputLength && !this->fillInput()) {
+            if(!this->atBoundary) {
+                throw std::invalid_argument("compressed file is truncated");
+            }
+            this->finished = true;
+            break;
+        }
+        if(this->atBoundary) {
+            // a new member / frame / stream starts here. anything else
+            // (e.g. zero padding) after the last one is ignored
+            bool isStart = false;
+            if(this->compression == COMPRESSION_ZSTD) {
+                // frame magic 0xFD2FB528 or a skippable frame 0x184D2A5?,
+                // both little endian
+                if(this->ensureInput(4)) {
+                    const uchar *magic = (const uchar*) this->input.constData() + this->inputPos;
+                    isStart = (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+                            || ((magic[0] & 0xf0) == 0x50 && magic[1] == 0x2a && magic[2] == 0x4d && magic[3] == 0x18);
+                }
+            } else {
+                char first = this->input.at(int(this->inputPos));
+                isStart = (this->compression == COMPRESSION_GZIP && quint8(first) == 0x1f)
+                        || (this->compression == COMPRESSION_BZIP2 && first == 'B');
+            }
+            if(!isStart) {
+                this->finished = true;
+                break;
+            }
+            qint64 compressedOffset = this->inputOffset + this->inputPos;
+            if(this->restartPoints.isEmpty() || this->restartPoints.last().compressedOffset < compressedOffset) {
+                PgnCheckpoint checkpoint;
+                checkpoint.compressedOffset = compressedOffset;
+                checkpoint.offset = this->outputPos + produced;
+                this->restartPoints.append(checkpoint);
+            }
+            this->initStream();
+            this->atBoundary = false;
+        }
+        const char *in = this->input.constData() + this->inputPos;
+        qint64 available = this->inputLength - this->inputPos;
+        qint64 consumed = 0;
+        qint64 written = 0;
+        if(this->compression == COMPRESSION_GZIP) {
+            z_stream *z = (z_stream*) this->stream;
+            z->next_in = (Bytef*) in;
+            z->avail_in = uInt(qMin(available, qint64(INPUT_BUFFER_SIZE)));
+            z->next_out = (Bytef*) (out + produced);
+            z->avail_out = uInt(qMin(max - produced, qint64(1 << 30)));
+            uInt availIn = z->avail_in;
+            uInt availOut = z->avail_out;
+            int ret = inflate(z, Z_NO_FLUSH);
+            if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                throw std::invalid_argument("corrupt gzip data");
+            }
+            consumed = availIn - z->avail_in;
+            written = availOut - z->avail_out;
+            this->atBoundary = ret == Z_STREAM_END;
+        }
+#ifdef PGN_WITH_ZSTD
+        if(this->compression == COMPRESSION_ZSTD) {
+            ZSTD_inBuffer zin = { in, size_t(available), 0 };
+            ZSTD_outBuffer zout = { out + produced, size_t(max - produced), 0 };
+            size_t ret = ZSTD_decompressStream((ZSTD_DStream*) this->stream, &zout, &zin);
+            if(ZSTD_isError(ret)) {
+                throw std::invalid_argument("corrupt zstd data");
+            }
+            consumed = zin.pos;
+            written = zout.pos;
+            this->atBoundary = ret == 0;
+        }
+#endif
+#ifdef PGN_WITH_BZIP2
+        if(this->compression == COMPRESSION_BZIP2) {
+            bz_stream *bz = (bz_stream*) this->stream;
+            bz->next_in = (char*) in;
+            bz->avail_in = (unsigned int) qMin(available, qint64(INPUT_BUFFER_SIZE));
+            bz->next_out = out + produced;
+            bz->avail_out = (unsigned int) qMin(max - produced, qint64(1 << 30));
+            unsigned int availIn = bz->avail_in;
+            unsigned int availOut = bz->avail_out;
+            int ret = BZ2_bzDecompress(bz);
+            if(ret != BZ_OK && ret != BZ_STREAM_END) {
+                throw std::invalid_argument("corrupt bzip2 data");
+            }
+            consumed = availIn - bz->avail_in;
+            written = availOut - bz->avail_out;
+            this->atBoundary = ret == BZ_STREAM_END;
+        }
+#endif
+        this->inputPos += consumed;
+        produced += written;
+    }
+    this->outputPos += produced;
+    return produced;
+}
+
+bool chess::PgnDecompressor::seek(qint64 offset, const QList<PgnCheckpoint> &checkpoints) {
+
+    // closest restart point at or before offset
+    PgnCheckpoint best;
+    best.compressedOffset = 0;
+    best.offset = 0;
+    QList<PgnCheckpoint> candidates = checkpoints;
+    candidates.append(this->restartPoints);
+    for(int i=0;i<candidates.size();i++) {
+        const PgnCheckpoint &c = candidates.at(i);
+        if(c.offset <= offset && c.offset > best.offset) {
+            best = c;
+        }
+    }
+    // just skip ahead if the current position is closer
+    if(this->outputPos > offset || this->outputPos < best.offset) {
+        this->restart(best.compressedOffset, best.offset);
+    }
+    QByteArray skip;
+    skip.resize(64 * 1024);
+    while(this->outputPos < offset) {
+        qint64 n = this->read(skip.data(), qMin(qint64(skip.size()), offset - this->outputPos));
+        if(n == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray chess::PgnDecompressor::readAt(qint64 offset, qint64 length, const QList<PgnCheckpoint> &checkpoints) {
+
+    QByteArray bytes;
+    if(!this->seek(offset, checkpoints)) {
+        return bytes;
+    }
+    bytes.resize(length);
+    qint64 done = 0;
+    while(done < length) {
+        qint64 n = this->read(bytes.data() + done, length - done);
+        if(n == 0) {
+            break;
+        }
+        done += n;
+    }
+    bytes.resize(done);
+    return bytes;
+}
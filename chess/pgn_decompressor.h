@@ -0,0 +1,125 @@
+#ifndef PGN_DECOMPRESSOR_H
+#define PGN_DECOMPRESSOR_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+namespace chess {
+
+const int COMPRESSION_NONE = 0;
+const int COMPRESSION_GZIP = 1;
+const int COMPRESSION_ZSTD = 2;
+const int COMPRESSION_BZIP2 = 3;
+
+/**
+ * @brief PgnCheckpoint is a position in a compressed file at which
+ *        decompression can be restarted, i.e. the start of a gzip
+ *        member, a zstd frame or a bzip2 stream.
+ */
+struct PgnCheckpoint
+{
+    qint64 compressedOffset;  // byte offset in the compressed file
+    qint64 offset;            // corresponding offset in the decompressed data
+};
+
+class PgnDecompressor
+{
+
+public:
+
+    /**
+     * @brief PgnDecompressor opens a compressed PGN file for streaming
+     *                        decompression. throws std::invalid_argument
+     *                        if the file can not be opened, is not compressed
+     *                        or the format is not supported by this build
+     * @param filename name of the compressed file
+     */
+    PgnDecompressor(const QString &filename);
+    ~PgnDecompressor();
+
+    /**
+     * @brief detect detects the compression of a file by its magic bytes
+     * @param filename name of the file
+     * @return COMPRESSION_GZIP, COMPRESSION_ZSTD, COMPRESSION_BZIP2 or
+     *         COMPRESSION_NONE (also if the file can't be read)
+     */
+    static int detect(const QString &filename);
+
+    /**
+     * @brief isSupported checks whether this build can decompress the format
+     * @param compression one of the COMPRESSION_ constants
+     */
+    static bool isSupported(int compression);
+
+    /**
+     * @brief read decompresses the next bytes. throws std::invalid_argument
+     *             if the compressed data is corrupt
+     * @param out buffer for the decompressed bytes
+     * @param max size of the buffer
+     * @return number of bytes written to out, 0 at the end of the file
+     */
+    qint64 read(char *out, qint64 max);
+
+    /**
+     * @brief pos offset in the decompressed data of the next byte read() returns
+     */
+    qint64 pos();
+
+    /**
+     * @brief seek continues decompression at the supplied offset of the
+     *             decompressed data. Restarts at the closest checkpoint at
+     *             or before offset (or at the start of the file if there is
+     *             none) and skips the remaining bytes.
+     * @param offset offset in the decompressed data
+     * @param checkpoints restart points of this file, e.g. from a previous
+     *                    pass (cf. checkpoints())
+     * @return false if the file ends before offset
+     */
+    bool seek(qint64 offset, const QList<PgnCheckpoint> &checkpoints);
+
+    /**
+     * @brief readAt decompresses length bytes at the supplied offset of the
+     *               decompressed data, e.g. a single game of the file (cf.
+     *               PgnIndex::checkpoints()). Continues from the closest
+     *               restart point like seek(). throws std::invalid_argument
+     *               like read()
+     * @param offset offset in the decompressed data
+     * @param length number of bytes
+     * @param checkpoints restart points of this file
+     * @return the bytes. Shorter than length if the file ends before
+     */
+    QByteArray readAt(qint64 offset, qint64 length, const QList<PgnCheckpoint> &checkpoints);
+
+    /**
+     * @brief checkpoints restart points that were passed so far, in file order
+     */
+    const QList<PgnCheckpoint>& checkpoints();
+
+private:
+
+    int compression;
+    QFile file;
+    QByteArray input;
+    qint64 inputPos;
+    qint64 inputLength;
+    // file offset of input[0]
+    qint64 inputOffset;
+    qint64 outputPos;
+    bool atBoundary;
+    bool finished;
+    void *stream;
+    QList<PgnCheckpoint> restartPoints;
+
+    bool fillInput();
+    bool ensureInput(qint64 length);
+    void initStream();
+    void endStream();
+    void restart(qint64 compressedOffset, qint64 offset);
+
+};
+
+}
+
+#endif // PGN_DECOMPRESSOR_H
@@ -0,0 +1,305 @@
+#include "pgn_headers.h"
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextCodec>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <utility>
+
+// where the value of a tag is stored
+const quint8 VALUE_NONE = 0;
+const quint8 VALUE_SOURCE = 1;
+const quint8 VALUE_POOL = 2;
+const quint8 VALUE_DEFAULT = 3;
+
+static const char* ROSTER_NAMES[] = { "Event", "Site", "Date", "Round", "White", "Black", "Result" };
+static const char* ROSTER_DEFAULTS[] = { "?", "?", "????.??.??", "?", "?", "?", "*" };
+
+/**
+ * @brief TagTable interned tag names, shared by all games. The Seven
+ *        Tag Roster always has the first ids.
+ */
+struct TagTable
+{
+    QMutex mutex;
+    QHash<QByteArray, int> ids;
+    QVector<QString> names;
+
+    TagTable() {
+        for(int i=0;i<chess::ROSTER_SIZE;i++) {
+            this->ids.insert(QByteArray(ROSTER_NAMES[i]), i);
+            this->names.append(QString::fromLatin1(ROSTER_NAMES[i]));
+        }
+    }
+};
+
+static TagTable& tagTable() {
+    static TagTable table;
+    return table;
+}
+
+static int rosterId(const char *name, int length) {
+    for(int i=0;i<chess::ROSTER_SIZE;i++) {
+        if(int(strlen(ROSTER_NAMES[i])) == length && memcmp(ROSTER_NAMES[i], name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+chess::PgnHeaders::PgnHeaders() {
+    this->source = 0;
+    this->codec = 0;
+    this->clear();
+}
+
+int chess::PgnHeaders::tagId(const char *name, int length) {
+    // no need to lock for the common tags
+    int id = rosterId(name, length);
+    if(id >= 0) {
+        return id;
+    }
+    TagTable &table = tagTable();
+    QByteArray key(name, length);
+    QMutexLocker locker(&table.mutex);
+    if(table.ids.contains(key)) {
+        return table.ids.value(key);
+    }
+    id = table.names.size();
+    table.ids.insert(key, id);
+    table.names.append(QString::fromLatin1(name, length));
+    return id;
+}
+
+int chess::PgnHeaders::tagId(const QString &name) {
+    QByteArray latin1 = name.toLatin1();
+    return tagId(latin1.constData(), latin1.size());
+}
+
+int chess::PgnHeaders::findTagId(const QString &name) {
+    QByteArray latin1 = name.toLatin1();
+    int id = rosterId(latin1.constData(), latin1.size());
+    if(id >= 0) {
+        return id;
+    }
+    TagTable &table = tagTable();
+    QMutexLocker locker(&table.mutex);
+    return table.ids.value(latin1, -1);
+}
+
+QString chess::PgnHeaders::tagName(int id) {
+    TagTable &table = tagTable();
+    QMutexLocker locker(&table.mutex);
+    return table.names.at(id);
+}
+
+void chess::PgnHeaders::setSource(const char *data, const char* encoding) {
+    this->source = data;
+    this->codec = QTextCodec::codecForName(encoding);
+}
+
+chess::PgnHeaders::Value* chess::PgnHeaders::find(int tag) {
+    if(tag < ROSTER_SIZE) {
+        return this->roster[tag].kind != VALUE_NONE ? &this->roster[tag] : 0;
+    }
+    for(int i=0;i<this->extraTags.size();i++) {
+        if(this->extraTags.at(i) == tag) {
+            return &this->extraValues[i];
+        }
+    }
+    return 0;
+}
+
+const chess::PgnHeaders::Value* chess::PgnHeaders::find(int tag) const {
+    return const_cast<PgnHeaders*>(this)->find(tag);
+}
+
+chess::PgnHeaders::Value* chess::PgnHeaders::findOrAdd(int tag) {
+    if(tag < ROSTER_SIZE) {
+        return &this->roster[tag];
+    }
+    Value *v = this->find(tag);
+    if(v == 0) {
+        Value empty = { 0, 0, VALUE_NONE };
+        this->extraTags.append(tag);
+        this->extraValues.append(empty);
+        v = &this->extraValues.last();
+    }
+    return v;
+}
+
+void chess::PgnHeaders::setSpan(int tag, const char *value, int length) {
+    Q_ASSERT(value >= this->source && value - this->source <= std::numeric_limits<qint32>::max());
+    Value *v = this->findOrAdd(tag);
+    v->offset = qint32(value - this->source);
+    v->length = length;
+    v->kind = VALUE_SOURCE;
+}
+
+void chess::PgnHeaders::setRosterDefaults() {
+    for(int i=0;i<ROSTER_SIZE;i++) {
+        this->roster[i].offset = i;
+        this->roster[i].length = strlen(ROSTER_DEFAULTS[i]);
+        this->roster[i].kind = VALUE_DEFAULT;
+    }
+}
+
+void chess::PgnHeaders::insert(int tag, const QString &value) {
+    QByteArray utf8 = value.toUtf8();
+    Value *v = this->findOrAdd(tag);
+    v->offset = this->pool.size();
+    v->length = utf8.size();
+    v->kind = VALUE_POOL;
+    this->pool.append(utf8);
+}
+
+void chess::PgnHeaders::insert(const QString &tag, const QString &value) {
+    this->insert(tagId(tag), value);
+}
+
+QString chess::PgnHeaders::decode(int tag, const Value &v) const {
+    if(v.kind == VALUE_SOURCE) {
+        return this->codec->toUnicode(this->source + v.offset, v.length);
+    }
+    if(v.kind == VALUE_POOL) {
+        return QString::fromUtf8(this->pool.constData() + v.offset, v.length);
+    }
+    if(v.kind == VALUE_DEFAULT) {
+        return QString::fromLatin1(ROSTER_DEFAULTS[tag]);
+    }
+    return QString();
+}
+
+const char* chess::PgnHeaders::rawValue(int tag, int *length) const {
+    const Value *v = this->find(tag);
+    if(v == 0) {
+        *length = 0;
+        return 0;
+    }
+    *length = v->length;
+    if(v->kind == VALUE_SOURCE) {
+        return this->source + v->offset;
+    }
+    if(v->kind == VALUE_POOL) {
+        return this->pool.constData() + v->offset;
+    }
+    return ROSTER_DEFAULTS[tag];
+}
+
+QString chess::PgnHeaders::value(int tag) const {
+    const Value *v = this->find(tag);
+    if(v == 0) {
+        return QString();
+    }
+    return this->decode(tag, *v);
+}
+
+QString chess::PgnHeaders::value(const QString &tag) const {
+    int id = findTagId(tag);
+    if(id < 0) {
+        return QString();
+    }
+    return this->value(id);
+}
+
+bool chess::PgnHeaders::contains(int tag) const {
+    return this->find(tag) != 0;
+}
+
+bool chess::PgnHeaders::contains(const QString &tag) const {
+    int id = findTagId(tag);
+    return id >= 0 && this->contains(id);
+}
+
+void chess::PgnHeaders::remove(const QString &tag) {
+    int id = findTagId(tag);
+    if(id < 0) {
+        return;
+    }
+    if(id < ROSTER_SIZE) {
+        this->roster[id].kind = VALUE_NONE;
+        return;
+    }
+    int i = this->extraTags.indexOf(id);
+    if(i >= 0) {
+        this->extraTags.removeAt(i);
+        this->extraValues.removeAt(i);
+    }
+}
+
+void chess::PgnHeaders::clear() {
+    for(int i=0;i<ROSTER_SIZE;i++) {
+        this->roster[i].offset = 0;
+        this->roster[i].length = 0;
+        this->roster[i].kind = VALUE_NONE;
+    }
+    this->extraTags.clear();
+    this->extraValues.clear();
+    this->pool.clear();
+}
+
+int chess::PgnHeaders::size() const {
+    int n = this->extraTags.size();
+    for(int i=0;i<ROSTER_SIZE;i++) {
+        if(this->roster[i].kind != VALUE_NONE) {
+            n++;
+        }
+    }
+    return n;
+}
+
+void chess::PgnHeaders::detach() {
+    for(int i=0;i<ROSTER_SIZE;i++) {
+        if(this->roster[i].kind == VALUE_SOURCE) {
+            this->insert(i, this->decode(i, this->roster[i]));
+        }
+    }
+    for(int i=0;i<this->extraTags.size();i++) {
+        if(this->extraValues.at(i).kind == VALUE_SOURCE) {
+            this->insert(this->extraTags.at(i), this->decode(this->extraTags.at(i), this->extraValues.at(i)));
+        }
+    }
+    this->source = 0;
+}
+
+QStringList chess::PgnHeaders::keys() const {
+    return this->toMap().keys();
+}
+
+QVector<int> chess::PgnHeaders::tags() const {
+    QVector<int> ids;
+    for(int i=0;i<ROSTER_SIZE;i++) {
+        if(this->roster[i].kind != VALUE_NONE) {
+            ids.append(i);
+        }
+    }
+    if(this->extraTags.isEmpty()) {
+        return ids;
+    }
+    QVector<std::pair<QString, int> > named;
+    for(int i=0;i<this->extraTags.size();i++) {
+        int tag = this->extraTags.at(i);
+        named.append(std::make_pair(tagName(tag), tag));
+    }
+    std::sort(named.begin(), named.end());
+    for(int i=0;i<named.size();i++) {
+        ids.append(named.at(i).second);
+    }
+    return ids;
+}
+
+QMap<QString, QString> chess::PgnHeaders::toMap() const {
+    QMap<QString, QString> map;
+    for(int i=0;i<ROSTER_SIZE;i++) {
+        if(this->roster[i].kind != VALUE_NONE) {
+            map.insert(QString::fromLatin1(ROSTER_NAMES[i]), this->decode(i, this->roster[i]));
+        }
+    }
+    for(int i=0;i<this->extraTags.size();i++) {
+        int tag = this->extraTags.at(i);
+        map.insert(tagName(tag), this->decode(tag, this->extraValues.at(i)));
+    }
+    return map;
+}
@@ -0,0 +1,157 @@
+#ifndef PGN_HEADERS_H
+#define PGN_HEADERS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMap>
+#include <QStringList>
+
+class QTextCodec;
+
+namespace chess {
+
+// ids of the Seven Tag Roster in the interned tag table
+const int TAG_EVENT = 0;
+const int TAG_SITE = 1;
+const int TAG_DATE = 2;
+const int TAG_ROUND = 3;
+const int TAG_WHITE = 4;
+const int TAG_BLACK = 5;
+const int TAG_RESULT = 6;
+const int ROSTER_SIZE = 7;
+
+/**
+ * @brief PgnHeaders are the tag pairs of a game. Tag names are interned
+ *        in a table shared by all games (cf. tagId()), the Seven Tag Roster
+ *        is stored inline, and values are either spans into the raw bytes
+ *        of the PGN file (not copied or decoded until they are accessed) or
+ *        strings in a small pool owned by the headers.
+ *        The QMap-like functions (insert, value, contains, ...) take tag
+ *        names and keep existing code working.
+ */
+class PgnHeaders
+{
+
+public:
+
+    PgnHeaders();
+
+    /**
+     * @brief tagId returns the id of a tag name, and adds the name to
+     *              the table if it isn't there yet. Thread-safe
+     * @param name first byte of the (latin1) tag name
+     * @param length length of the name
+     * @return id of the tag. The Seven Tag Roster has the ids TAG_EVENT ... TAG_RESULT
+     */
+    static int tagId(const char *name, int length);
+    static int tagId(const QString &name);
+
+    /**
+     * @brief findTagId like tagId, but doesn't add unknown names
+     * @return id of the tag, or -1 if no game ever used that tag
+     */
+    static int findTagId(const QString &name);
+
+    /**
+     * @brief tagName returns the name of an interned tag
+     */
+    static QString tagName(int id);
+
+    /**
+     * @brief setSource sets the raw bytes that values set by setSpan() point
+     *                  into. The bytes are not copied and must outlive the
+     *                  headers (or detach() must be called). Values are stored
+     *                  as 32 bit offsets from data, so the buffer should be the
+     *                  tag section of one game, not a whole (multi-GB) file
+     * @param data first byte of the buffer, e.g. of the tag section of a game
+     *             in a memory mapped PGN file
+     * @param encoding encoding of the buffer, see PgnReader::detect_encoding
+     */
+    void setSource(const char *data, const char* encoding);
+
+    /**
+     * @brief setSpan sets the value of a tag to raw bytes of the source
+     * @param tag id of the tag
+     * @param value first byte of the (still encoded) value within the source.
+     *              At most 2 GiB after the start of the source
+     * @param length length of the value in bytes
+     */
+    void setSpan(int tag, const char *value, int length);
+
+    /**
+     * @brief setRosterDefaults sets the Seven Tag Roster to the PGN defaults
+     *                          ("?", "????.??.??" and "*"), without any allocation
+     */
+    void setRosterDefaults();
+
+    /**
+     * @brief detach copies all values that point into the source to the pool,
+     *               so that the source may go away
+     */
+    void detach();
+
+    /**
+     * @brief rawValue returns the value of a tag without decoding it, i.e. in
+     *                 the encoding of the source for values set by setSpan(),
+     *                 and as UTF-8 otherwise. The data is not copied, and only
+     *                 valid as long as the headers (and the source) are
+     * @param tag id of the tag
+     * @param length receives the length of the value in bytes
+     * @return first byte of the value, or 0 if the tag is not set
+     */
+    const char* rawValue(int tag, int *length) const;
+
+    void insert(int tag, const QString &value);
+    void insert(const QString &tag, const QString &value);
+    QString value(int tag) const;
+    QString value(const QString &tag) const;
+    bool contains(int tag) const;
+    bool contains(const QString &tag) const;
+    void remove(const QString &tag);
+    void clear();
+    int size() const;
+
+    /**
+     * @brief keys tag names in alphabetical order (as for a QMap)
+     */
+    QStringList keys() const;
+
+    /**
+     * @brief tags ids of all tags that are set, without decoding any value:
+     *             first the Seven Tag Roster (in roster order), then the
+     *             other tags ordered by name (as keys() and toMap())
+     */
+    QVector<int> tags() const;
+
+    /**
+     * @brief toMap compatibility accessor: all tags as a map of names to values
+     */
+    QMap<QString, QString> toMap() const;
+
+private:
+
+    struct Value
+    {
+        qint32 offset;
+        qint32 length;
+        quint8 kind;
+    };
+
+    Value roster[ROSTER_SIZE];
+    QVector<int> extraTags;
+    QVector<Value> extraValues;
+    QByteArray pool;
+    const char *source;
+    QTextCodec *codec;
+
+    Value* find(int tag);
+    const Value* find(int tag) const;
+    Value* findOrAdd(int tag);
+    QString decode(int tag, const Value &v) const;
+
+};
+
+}
+
+#endif // PGN_HEADERS_H
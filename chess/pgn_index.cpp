@@ -0,0 +1,279 @@
+#include "pgn_index.h"
+#include "pgn_block_reader.h"
+#include "byteutil.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+
+// number of bytes at the start and at the end of the indexed part
+// of the PGN file that are used as content fingerprint
+const qint64 FINGERPRINT_BYTES = 4096;
+
+// magic + version + size + mtime + two fingerprints + data size
+// + count + number of checkpoints
+const qint64 INDEX_HEADER_SIZE = 10 + 1 + 8 + 8 + 8 + 8 + 8 + 4 + 4;
+const qint64 INDEX_ENTRY_SIZE = 8 + 4 + 4;
+const qint64 CHECKPOINT_ENTRY_SIZE = 8 + 8;
+
+const quint8 INDEX_VERSION = 2;
+
+chess::PgnIndex::PgnIndex(const QString &pgnFilename)
+{
+    this->pgnFilename = pgnFilename;
+    this->magicIndexString = QByteArrayLiteral("\x70\x67\x6e\x32\x70\x67\x6e\x50\x47\x49");
+    this->fileSize = 0;
+    this->dataSize = 0;
+    this->modified = 0;
+    this->headPrint = 0;
+    this->tailPrint = 0;
+}
+
+QString chess::PgnIndex::indexFilename() {
+    return QString(this->pgnFilename).append(".pgi");
+}
+
+int chess::PgnIndex::count() {
+    return this->games.size();
+}
+
+chess::GameSpan chess::PgnIndex::at(int i) {
+    return this->games.at(i);
+}
+
+const QVector<chess::GameSpan>& chess::PgnIndex::spans() {
+    return this->games;
+}
+
+const QList<chess::PgnCheckpoint>& chess::PgnIndex::checkpoints() {
+    return this->checkpointList;
+}
+
+quint64 chess::PgnIndex::fingerprint(const char *data, qint64 length) {
+    // 64 bit FNV-1a
+    quint64 hash = Q_UINT64_C(0xcbf29ce484222325);
+    for(qint64 i=0;i<length;i++) {
+        hash ^= quint8(data[i]);
+        hash *= Q_UINT64_C(0x100000001b3);
+    }
+    return hash;
+}
+
+bool chess::PgnIndex::update(PgnScanner *scanner) {
+
+    QFileInfo info(this->pgnFilename);
+    qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    quint64 size = scanner->size();
+
+    quint64 storedSize = 0;
+    qint64 storedMtime = 0;
+    quint64 storedHead = 0;
+    quint64 storedTail = 0;
+    bool valid = this->load(&storedSize, &storedMtime, &storedHead, &storedTail);
+    if(valid && storedSize <= size) {
+        qint64 n = qMin(qint64(storedSize), FINGERPRINT_BYTES);
+        valid = storedHead == this->fingerprint(scanner->data(), n)
+                && storedTail == this->fingerprint(scanner->data() + storedSize - n, n);
+    } else {
+        valid = false;
+    }
+    if(valid && storedSize == size && storedMtime != mtime) {
+        // same size, but modified: can't tell what changed
+        valid = false;
+    }
+    bool changed = true;
+    if(!valid) {
+        this->games.clear();
+        this->scan(scanner, 0);
+    } else if(storedSize < size) {
+        // the file grew. the last game might have been continued, so
+        // it is scanned again together with the appended part
+        qint64 from = storedSize;
+        if(!this->games.isEmpty()) {
+            from = this->games.last().offset;
+            this->games.removeLast();
+        }
+        this->scan(scanner, from);
+    } else {
+        changed = false;
+    }
+    this->checkpointList.clear();
+    this->fileSize = size;
+    this->dataSize = size;
+    this->modified = mtime;
+    qint64 n = qMin(qint64(size), FINGERPRINT_BYTES);
+    this->headPrint = this->fingerprint(scanner->data(), n);
+    this->tailPrint = this->fingerprint(scanner->data() + size - n, n);
+    if(changed) {
+        this->save();
+    }
+    return valid;
+}
+
+void chess::PgnIndex::fileFingerprints(quint64 size, quint64 *head, quint64 *tail) {
+    // of the compressed bytes, which are not kept in memory
+    *head = 0;
+    *tail = 0;
+    QFile file(this->pgnFilename);
+    if(!file.open(QFile::ReadOnly)) {
+        return;
+    }
+    qint64 n = qMin(qint64(size), FINGERPRINT_BYTES);
+    QByteArray bytes = file.read(n);
+    *head = this->fingerprint(bytes.constData(), bytes.size());
+    file.seek(size - n);
+    bytes = file.read(n);
+    *tail = this->fingerprint(bytes.constData(), bytes.size());
+}
+
+bool chess::PgnIndex::updateCompressed() {
+
+    QFileInfo info(this->pgnFilename);
+    qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    quint64 size = info.size();
+    quint64 head = 0;
+    quint64 tail = 0;
+    this->fileFingerprints(size, &head, &tail);
+
+    quint64 storedSize = 0;
+    qint64 storedMtime = 0;
+    quint64 storedHead = 0;
+    quint64 storedTail = 0;
+    // appended data can't be told apart from a changed file
+    // w/o decompressing, so any change means a new scan
+    bool valid = this->load(&storedSize, &storedMtime, &storedHead, &storedTail)
+            && storedSize == size && storedMtime == mtime
+            && storedHead == head && storedTail == tail;
+    if(!valid) {
+        this->games.clear();
+        this->checkpointList.clear();
+        PgnBlockReader blocks(this->pgnFilename);
+        blocks.start();
+        QByteArray block;
+        qint64 blockOffset = 0;
+        this->dataSize = 0;
+        while(blocks.nextBlock(&block, &blockOffset)) {
+            PgnScanner scanner(block.constData(), block.size());
+            while(scanner.hasNext()) {
+                GameSpan span = scanner.next();
+                span.offset += blockOffset;
+                this->games.append(span);
+            }
+            this->dataSize = blockOffset + block.size();
+        }
+        this->checkpointList = blocks.checkpoints();
+    }
+    this->fileSize = size;
+    this->modified = mtime;
+    this->headPrint = head;
+    this->tailPrint = tail;
+    if(!valid) {
+        this->save();
+    }
+    return valid;
+}
+
+void chess::PgnIndex::scan(PgnScanner *scanner, qint64 from) {
+    scanner->setRange(from, scanner->size());
+    while(scanner->hasNext()) {
+        this->games.append(scanner->next());
+    }
+}
+
+bool chess::PgnIndex::load(quint64 *size, qint64 *mtime, quint64 *head, quint64 *tail) {
+
+    this->games.clear();
+    QFile pgiFile(this->indexFilename());
+    if(!pgiFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QDataStream gi(&pgiFile);
+    QByteArray magic;
+    magic.resize(10);
+    magic.fill(char(0x20));
+    gi.readRawData(magic.data(), 10);
+    quint8 version = 0;
+    gi >> version;
+    if(magic != this->magicIndexString || version != INDEX_VERSION) {
+        return false;
+    }
+    quint32 count = 0;
+    quint32 checkpointCount = 0;
+    quint64 dataSize = 0;
+    gi >> *size;
+    gi >> *mtime;
+    gi >> *head;
+    gi >> *tail;
+    gi >> dataSize;
+    gi >> count;
+    gi >> checkpointCount;
+    if(pgiFile.size() != INDEX_HEADER_SIZE + qint64(count) * INDEX_ENTRY_SIZE
+            + qint64(checkpointCount) * CHECKPOINT_ENTRY_SIZE) {
+        return false;
+    }
+    this->games.reserve(count);
+    for(quint32 i=0;i<count;i++) {
+        quint64 offset = 0;
+        quint32 length = 0;
+        quint32 headerLength = 0;
+        gi >> offset;
+        gi >> length;
+        gi >> headerLength;
+        GameSpan span;
+        span.offset = offset;
+        span.length = length;
+        span.headerLength = headerLength;
+        if(span.offset + span.length > qint64(dataSize)) {
+            this->games.clear();
+            return false;
+        }
+        this->games.append(span);
+    }
+    this->checkpointList.clear();
+    for(quint32 i=0;i<checkpointCount;i++) {
+        quint64 compressedOffset = 0;
+        quint64 offset = 0;
+        gi >> compressedOffset;
+        gi >> offset;
+        PgnCheckpoint checkpoint;
+        checkpoint.compressedOffset = compressedOffset;
+        checkpoint.offset = offset;
+        this->checkpointList.append(checkpoint);
+    }
+    this->dataSize = dataSize;
+    return true;
+}
+
+bool chess::PgnIndex::save() {
+
+    QByteArray pgi;
+    pgi.reserve(INDEX_HEADER_SIZE + this->games.size() * INDEX_ENTRY_SIZE
+                + this->checkpointList.size() * CHECKPOINT_ENTRY_SIZE);
+    pgi.append(this->magicIndexString);
+    ByteUtil::append_as_uint8(&pgi, INDEX_VERSION);
+    ByteUtil::append_as_uint64(&pgi, this->fileSize);
+    ByteUtil::append_as_uint64(&pgi, quint64(this->modified));
+    ByteUtil::append_as_uint64(&pgi, this->headPrint);
+    ByteUtil::append_as_uint64(&pgi, this->tailPrint);
+    ByteUtil::append_as_uint64(&pgi, this->dataSize);
+    ByteUtil::append_as_uint32(&pgi, this->games.size());
+    ByteUtil::append_as_uint32(&pgi, this->checkpointList.size());
+    for(int i=0;i<this->games.size();i++) {
+        const GameSpan &span = this->games.at(i);
+        ByteUtil::append_as_uint64(&pgi, span.offset);
+        ByteUtil::append_as_uint32(&pgi, span.length);
+        ByteUtil::append_as_uint32(&pgi, span.headerLength);
+    }
+    for(int i=0;i<this->checkpointList.size();i++) {
+        const PgnCheckpoint &checkpoint = this->checkpointList.at(i);
+        ByteUtil::append_as_uint64(&pgi, checkpoint.compressedOffset);
+        ByteUtil::append_as_uint64(&pgi, checkpoint.offset);
+    }
+    QFile pgiFile(this->indexFilename());
+    if(!pgiFile.open(QFile::WriteOnly)) {
+        return false;
+    }
+    bool ok = pgiFile.write(pgi) == pgi.size();
+    pgiFile.close();
+    return ok;
+}
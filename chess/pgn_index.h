@@ -0,0 +1,103 @@
+#ifndef PGN_INDEX_H
+#define PGN_INDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QList>
+#include "pgn_scanner.h"
+#include "pgn_decompressor.h"
+
+namespace chess {
+
+class PgnIndex
+{
+
+public:
+
+    /**
+     * @brief PgnIndex game index of a PGN file, that is persisted as a
+     *                 sidecar file (<pgnfile>.pgi) next to the PGN file
+     * @param pgnFilename name of the PGN file
+     */
+    PgnIndex(const QString &pgnFilename);
+
+    /**
+     * @brief update makes sure the index matches the current PGN file. A
+     *               stored index is reused if file size, modification time
+     *               and content fingerprints match. If the file only grew
+     *               (fingerprints of the indexed part match), only the
+     *               appended part is scanned. Otherwise the whole file is
+     *               scanned. A changed index is saved (if the directory is
+     *               not writable, the index is just kept in memory).
+     * @param scanner scanner of the same PGN file. Its range is modified.
+     * @return true if the stored index could be used (possibly extended)
+     */
+    bool update(PgnScanner *scanner);
+
+    /**
+     * @brief updateCompressed same as update(), for a compressed PGN file
+     *                         (cf. PgnDecompressor). Game locations are
+     *                         offsets in the decompressed data. The stored
+     *                         index is reused if size, modification time
+     *                         and fingerprints of the compressed file match.
+     *                         Otherwise the file is decompressed once, block
+     *                         by block (cf. PgnBlockReader), and the restart
+     *                         points of the decompressor are saved together
+     *                         with the games (cf. checkpoints()).
+     *                         throws std::invalid_argument like PgnBlockReader
+     * @return true if the stored index could be used
+     */
+    bool updateCompressed();
+
+    /**
+     * @brief count number of games in the index
+     */
+    int count();
+
+    /**
+     * @brief at location of the i-th game (starting from 0)
+     */
+    GameSpan at(int i);
+
+    /**
+     * @brief spans all game locations in file order
+     */
+    const QVector<GameSpan>& spans();
+
+    /**
+     * @brief checkpoints restart points of a compressed PGN file, e.g. to read
+     *                    a single game with PgnDecompressor::readAt(). Empty
+     *                    for plain files
+     */
+    const QList<PgnCheckpoint>& checkpoints();
+
+    /**
+     * @brief indexFilename name of the sidecar file
+     */
+    QString indexFilename();
+
+private:
+    QString pgnFilename;
+    QByteArray magicIndexString;
+    QVector<GameSpan> games;
+    QList<PgnCheckpoint> checkpointList;
+    quint64 fileSize;
+    // size of the PGN data the game offsets refer to, i.e.
+    // the decompressed size for compressed files
+    quint64 dataSize;
+    qint64 modified;
+    quint64 headPrint;
+    quint64 tailPrint;
+
+    bool load(quint64 *size, qint64 *mtime, quint64 *head, quint64 *tail);
+    bool save();
+    void scan(PgnScanner *scanner, qint64 from);
+    void fileFingerprints(quint64 size, quint64 *head, quint64 *tail);
+    static quint64 fingerprint(const char *data, qint64 length);
+
+};
+
+}
+
+#endif // PGN_INDEX_H
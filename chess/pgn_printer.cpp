@@ -64,6 +64,13 @@ void PgnPrinter::writeToken(const QString &token) {
     this->currentLine.append(token);
 }
 
+void PgnPrinter::writeToken(QLatin1String token) {
+    if(80 - this->currentLine.length() < token.size()) {
+        this->flushCurrentLine();
+    }
+    this->currentLine.append(token);
+}
+
 void PgnPrinter::writeLine(const QString &line) {
     this->flushCurrentLine();
     this->pgn->append(line.trimmed());
@@ -89,32 +96,35 @@ void PgnPrinter::writeGame(Game *g, const QString &filename) {
     }
 }
 
-void PgnPrinter::printHeaders(QStringList *pgn, Game *g) {
-    QMap<QString, QString>* headers = g->headers;
-    QString tag = "[Event \"" + headers->value("Event") + "\"]";
+void PgnPrinter::printTags(QStringList *pgn, PgnHeaders *headers) {
+    // the Seven Tag Roster is always printed first, the
+    // other tags follow ordered by name (cf. PgnHeaders::tags)
+    QString tag = "[Event \"" + headers->value(TAG_EVENT) + "\"]";
     pgn->append(tag);
-    tag = "[Site \"" + headers->value("Site") + "\"]";
+    tag = "[Site \"" + headers->value(TAG_SITE) + "\"]";
     pgn->append(tag);
-    tag = "[Date \"" + headers->value("Date") + "\"]";
+    tag = "[Date \"" + headers->value(TAG_DATE) + "\"]";
     pgn->append(tag);
-    tag = "[Round \"" + headers->value("Round") + "\"]";
+    tag = "[Round \"" + headers->value(TAG_ROUND) + "\"]";
     pgn->append(tag);
-    tag = "[White \"" + headers->value("White") + "\"]";
+    tag = "[White \"" + headers->value(TAG_WHITE) + "\"]";
     pgn->append(tag);
-    tag = "[Black \"" + headers->value("Black") + "\"]";
+    tag = "[Black \"" + headers->value(TAG_BLACK) + "\"]";
     pgn->append(tag);
-    tag = "[Result \"" + headers->value("Result") + "\"]";
+    tag = "[Result \"" + headers->value(TAG_RESULT) + "\"]";
     pgn->append(tag);
-    QMapIterator<QString, QString> i(*(headers));
-    while (i.hasNext()) {
-        i.next();
-        if(i.key() != "Event" && i.key() != "Site" && i.key() != "Date" && i.key() != "Round"
-                && i.key() != "White" && i.key() != "Black" && i.key() != "Result" )
-        {
-            QString tag = "[" + i.key() + " \"" + i.value() + "\"]";
+    QVector<int> tags = headers->tags();
+    for(int i=0;i<tags.size();i++) {
+        int id = tags.at(i);
+        if(id >= ROSTER_SIZE) {
+            QString tag = "[" + PgnHeaders::tagName(id) + " \"" + headers->value(id) + "\"]";
             pgn->append(tag);
         }
     }
+}
+
+void PgnPrinter::printHeaders(QStringList *pgn, Game *g) {
+    this->printTags(pgn, g->headers);
     // add fen string tag if root is not initial position
     chess::Board* root = g->getRootNode()->getBoard();
     if(!root->is_initial_position()) {
@@ -124,6 +134,12 @@ void PgnPrinter::printHeaders(QStringList *pgn, Game *g) {
 
 }
 
+QStringList* PgnPrinter::printTags(Game *g) {
+    QStringList *tags = new QStringList();
+    this->printTags(tags, g->headers);
+    return tags;
+}
+
 QStringList* PgnPrinter::printGame(Game *g) {
 
     this->reset();
@@ -144,7 +160,12 @@ QStringList* PgnPrinter::printGame(Game *g) {
         this->printComment(root->getComment());
     }
 
-    this->printGameContent(root);
+    // the moves are applied to a copy of the root board and taken back
+    // again while descending, instead of computing the board of each node
+    char fen[FEN_BUFFER_SIZE];
+    int length = root->getBoard()->write_fen(fen);
+    Board board(fen, length);
+    this->printGameContent(root, &board);
     this->printResult(g->getResult());
     this->pgn->append(this->currentLine);
 
@@ -152,7 +173,7 @@ QStringList* PgnPrinter::printGame(Game *g) {
 
 }
 
-void PgnPrinter::printMove(Board *b, Move *m) {
+void PgnPrinter::printMove(Board *b, const Move &m) {
     if(b->turn == WHITE) {
         QString tkn = QString::number(b->fullmove_number);
         tkn.append(QString(". "));
@@ -163,9 +184,12 @@ void PgnPrinter::printMove(Board *b, Move *m) {
         tkn.append(QString("... "));
         this->writeToken(tkn);
     }
-    //qDebug() << "Move: " << m->uci_string;
-    //qDebug() << "san: " << b->san(*m);
-    this->writeToken((b->san(*m)).append(QString(" ")));
+    // san and the trailing space are written
+    // without creating an intermediate string
+    char san[SAN_BUFFER_SIZE + 1];
+    int length = b->write_san(m, san);
+    san[length++] = ' ';
+    this->writeToken(QLatin1String(san, length));
     this->forceMoveNumber = false;
 }
 
@@ -211,56 +235,50 @@ void PgnPrinter::printComment(const QString &comment) {
 
 
 
-void PgnPrinter::printGameContent(GameNode* g) {
-
-    Board *b = g->getBoard();
-
-    // first write mainline move, if there are variations
-    int cntVar = g->getVariations()->count();
-    if(cntVar > 0) {
-        GameNode* main_variation = g->getVariation(0);
-        Move *m = main_variation->getMove();
-        this->printMove(b,m);
-        // write nags
-        QList<int> *nags = main_variation->getNags();
-        for(int j=0;j<nags->count();j++) {
-            int n = nags->at(j);
-            this->printNag(n);
-        }
-        // write comments
-        if(!main_variation->getComment().isEmpty()) {
-            this->printComment(main_variation->getComment());
+void PgnPrinter::printGameContent(GameNode* g, Board *b) {
+
+    // mainline move, then each variation with its subtree, then the
+    // rest of the mainline. Only variations recurse, the mainline
+    // is continued in the loop. b is left as it was on entry
+    int applied = 0;
+    while(!g->isLeaf()) {
+        QList<GameNode*> *variations = g->getVariations();
+        GameNode* main_variation = variations->at(0);
+        this->printMove(b, *main_variation->getMove());
+        this->printAnnotations(main_variation);
+        for(int i=1;i<variations->count();i++) {
+            GameNode *var_i = variations->at(i);
+            this->beginVariation();
+            this->printMove(b, *var_i->getMove());
+            this->printAnnotations(var_i);
+            b->apply(*var_i->getMove());
+            this->printGameContent(var_i, b);
+            b->undo();
+            this->endVariation();
         }
+        b->apply(*main_variation->getMove());
+        applied++;
+        g = main_variation;
     }
-
-    // now handle all variations (sidelines)
-    for(int i=1;i<cntVar;i++) {
-        // first create variation start marker, and print the move
-        GameNode *var_i = g->getVariation(i);
-        this->beginVariation();
-        this->printMove(b,var_i->getMove());
-        // next print nags
-        QList<int> *nags = var_i->getNags();
-        for(int j=0;j<nags->count();j++) {
-            int n = nags->at(j);
-            this->printNag(n);
-        }
-        // finally print comments
-        if(!var_i->getComment().isEmpty()) {
-            this->printComment(var_i->getComment());
-        }
-
-        // recursive call for all childs
-        this->printGameContent(var_i);
-
-        // print variation end
-        this->endVariation();
+    for(int i=0;i<applied;i++) {
+        b->undo();
     }
+}
 
-    // finally do the mainline
-    if(cntVar > 0) {
-        GameNode* main_variation = g->getVariation(0);
-        this->printGameContent(main_variation);
+void PgnPrinter::printAnnotations(GameNode *node) {
+    if(!node->hasAnnotations()) {
+        return;
+    }
+    // write nags
+    const QList<int> *nags = node->getNags();
+    for(int j=0;j<nags->count();j++) {
+        int n = nags->at(j);
+        this->printNag(n);
+    }
+    // write comments
+    const QString comment = node->getComment();
+    if(!comment.isEmpty()) {
+        this->printComment(comment);
     }
 }
 
@@ -45,6 +45,17 @@ public:
      */
     QStringList* printGame(Game *g);
 
+    /**
+     * @brief printTags prints only the tag section of the supplied game,
+     *                  e.g. to list games. Tags are printed as they were
+     *                  read, and the game tree is not accessed, so the
+     *                  movetext of a lazy game is not parsed (cf.
+     *                  PgnReader::readLazyGameFromBytes)
+     * @param g game to print
+     * @return string list of the tag lines
+     */
+    QStringList* printTags(Game *g);
+
     /**
      * @brief writeGame prints the supplied game to PGN format and saves
      *                  the game as filename on disk. Throws
@@ -64,12 +75,15 @@ private:
     void reset();
     void flushCurrentLine();
     void writeToken(const QString &token);
+    void writeToken(QLatin1String token);
     void writeLine(const QString &token);
-    void printGameContent(GameNode *g);
-    void printMove(Board *board, Move *m);
+    void printGameContent(GameNode *g, Board *b);
+    void printMove(Board *board, const Move &m);
+    void printAnnotations(GameNode *node);
     void printComment(const QString &comment);
     void printNag(int nag);
     void printHeaders(QStringList *pgn, Game *g);
+    void printTags(QStringList *pgn, PgnHeaders *headers);
     void printResult(int result);
     void beginVariation();
     void endVariation();
@@ -19,6 +19,11 @@
 
 
 #include "chess/pgn_reader.h"
+#include "chess/pgn_tokenizer.h"
+#include "chess/pgn_scanner.h"
+#include "chess/pgn_decompressor.h"
+#include "chess/header_filter.h"
+#include "chess/pgn_visitor.h"
 #include "chess/game.h"
 #include "chess/game_node.h"
 #include <QFile>
@@ -28,6 +33,7 @@
 #include <QDebug>
 #include <QTextCodec>
 #include <QDataStream>
+#include <climits>
 
 namespace chess {
 
@@ -39,6 +45,23 @@ const char* PgnReader::detect_encoding(const QString &filename) {
     // if conversion errors occur, we simply assume UTF-8
     const char* iso = "ISO 8859-1";
     const char* utf8 = "UTF-8";
+    if(PgnDecompressor::detect(filename) != COMPRESSION_NONE) {
+        // look at the decompressed text instead
+        try {
+            PgnDecompressor decompressor(filename);
+            QByteArray head;
+            head.resize(100 * 100);
+            qint64 n = decompressor.read(head.data(), head.size());
+            QTextCodec::ConverterState state;
+            QTextCodec *codec = QTextCodec::codecForName("UTF-8");
+            const QString text = codec->toUnicode(head.constData(), n, &state);
+            if(state.invalidChars > 0) {
+                return iso;
+            }
+        } catch(const std::invalid_argument &) {
+        }
+        return utf8;
+    }
     QFile file(filename);
     if(!file.open(QFile::ReadOnly)) {
         return utf8;
@@ -76,96 +99,26 @@ const char* PgnReader::detect_encoding(const QString &filename) {
 }
 
 QList<HeaderOffset*>* PgnReader::scan_headers(const QString &filename, const char* encoding) {
+    return this->scan_headers(filename, encoding, 0);
+}
 
-    QList<HeaderOffset*> *header_offsets = new QList<HeaderOffset*>();
-    QFile file(filename);
-
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return header_offsets;
-
-    bool inComment = false;
-
-    QMap<QString,QString> *game_header = new QMap<QString,QString>();
-    qint64 game_pos = -1;
-
-    QTextStream in(&file);
-    QTextCodec *codec = QTextCodec::codecForName(encoding);
-    in.setCodec(codec);
-    QString line = QString("");
-    qint64 last_pos = in.pos();
-
-    //qDebug() << "before while loop";
-    int i= 0;
-    while(!in.atEnd()) {
-
-        i++;
-        line = in.readLine();
+QList<HeaderOffset*>* PgnReader::scan_headers(const QString &filename, const char* encoding, const HeaderFilter *filter) {
 
-        if(i%1000==0) {
-            qDebug() << "read next line: " << i;
-        }
-        // skip comments
-        if(line.startsWith("%")) {
-            line = in.readLine();
+    QList<HeaderOffset*> *header_offsets = new QList<HeaderOffset*>();
+    PgnScanner scanner(filename);
+    PgnHeaders headers;
+    while(scanner.hasNext()) {
+        GameSpan span = scanner.next();
+        scanner.readHeaders(span, encoding, &headers);
+        if(filter != 0 && !filter->matches(headers)) {
             continue;
         }
-
-        if(!inComment && line.startsWith("[")) {
-            QRegularExpressionMatch match_t = TAG_REGEX.match(line);
-
-            if(match_t.hasMatch()) {
-
-                if(game_pos == -1) {
-                    game_header->insert("Event","?");
-                    game_header->insert("Site","?");
-                    game_header->insert("Date","????.??.??");
-                    game_header->insert("Round","?");
-                    game_header->insert("White","?");
-                    game_header->insert("Black","?");
-                    game_header->insert("Result","*");
-
-                    game_pos = last_pos;
-                }
-
-                QString tag = match_t.captured(1);
-                QString value = match_t.captured(2);
-
-                game_header->insert(tag,value);
-
-                last_pos = in.pos();
-                line = in.readLine();
-                continue;
-            }
-        }
-        if((!inComment && line.contains("{"))
-                || (inComment && line.contains("}"))) {
-            inComment = line.lastIndexOf("{") > line.lastIndexOf("}");
-        }
-
-        if(game_pos != -1) {
-            HeaderOffset *ho = new HeaderOffset();
-            ho->headers = game_header;
-            ho->offset = game_pos;
-
-            header_offsets->append(ho);
-            game_pos = -1;
-            game_header = new QMap<QString,QString>();
-        }
-
-        last_pos = in.pos();
-        line = in.readLine();
-    }
-    // for the last game
-    if(game_pos != -1) {
         HeaderOffset *ho = new HeaderOffset();
-        ho->headers = game_header;
-        ho->offset = game_pos;
-
+        ho->headers = new PgnHeaders(headers);
+        ho->headers->detach();
+        ho->offset = span.offset;
         header_offsets->append(ho);
-        game_pos = -1;
-        game_header = new QMap<QString,QString>();
     }
-
     return header_offsets;
 }
 
@@ -182,7 +135,7 @@ int PgnReader::readNextHeader(const QString &filename, const char* encoding,
     bool inComment = false;
 
     //qDebug() << "kk0";
-    QMap<QString,QString> *game_header = new QMap<QString,QString>();
+    PgnHeaders *game_header = new PgnHeaders();
     qint64 game_pos = -1;
 
     QTextCodec *codec = QTextCodec::codecForName(encoding);
@@ -252,104 +205,8 @@ int PgnReader::readNextHeader(const QString &filename, const char* encoding,
 }
 
 QList<HeaderOffset*>* PgnReader::scan_headers_fast(const QString &filename, const char* encoding) {
-
-    QList<HeaderOffset*> *header_offsets = new QList<HeaderOffset*>();
-    QFile file(filename);
-
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return header_offsets;
-
-    bool inComment = false;
-
-    QMap<QString,QString> *game_header = new QMap<QString,QString>();
-    qint64 game_pos = -1;
-
-    QTextCodec *codec = QTextCodec::codecForName(encoding);
-
-    QString line = QString("");
-    qint64 last_pos = file.pos();
-
-    qDebug() << "before while loop";
-    int i= 0;
-
-    QByteArray raw_line;
-
-    while(!file.atEnd()) {
-        i++;
-        raw_line = file.readLine();
-        line = codec->toUnicode(raw_line);
-
-        if(i%1000==0) {
-            qDebug() << "read next line: " << i;
-        }
-        // skip comments
-        if(line.startsWith("%")) {
-            raw_line = file.readLine();
-            line = codec->toUnicode(raw_line);
-            continue;
-        }
-
-        if(!inComment && line.startsWith("[")) {
-            QRegularExpressionMatch match_t = TAG_REGEX.match(line);
-
-            if(match_t.hasMatch()) {
-
-                if(game_pos == -1) {
-                    game_header->insert("Event","?");
-                    game_header->insert("Site","?");
-                    game_header->insert("Date","????.??.??");
-                    game_header->insert("Round","?");
-                    game_header->insert("White","?");
-                    game_header->insert("Black","?");
-                    game_header->insert("Result","*");
-
-                    game_pos = last_pos;
-                }
-
-                QString tag = match_t.captured(1);
-                QString value = match_t.captured(2);
-
-                game_header->insert(tag,value);
-
-                last_pos = file.pos();
-                // line = in.readLine();
-                raw_line = file.readLine();
-                line = codec->toUnicode(raw_line);
-                continue;
-            }
-        }
-        if((!inComment && line.contains("{"))
-                || (inComment && line.contains("}"))) {
-            inComment = line.lastIndexOf("{") > line.lastIndexOf("}");
-        }
-
-        if(game_pos != -1) {
-            HeaderOffset *ho = new HeaderOffset();
-            ho->headers = game_header;
-            ho->offset = game_pos;
-
-            header_offsets->append(ho);
-            game_pos = -1;
-            game_header = new QMap<QString,QString>();
-        }
-
-        last_pos = file.pos();
-        raw_line = file.readLine();
-        line = codec->toUnicode(raw_line);
-
-    }
-    // for the last game
-    if(game_pos != -1) {
-        HeaderOffset *ho = new HeaderOffset();
-        ho->headers = game_header;
-        ho->offset = game_pos;
-
-        header_offsets->append(ho);
-        game_pos = -1;
-        game_header = new QMap<QString,QString>();
-    }
-
-    return header_offsets;
+    // scan_headers is single pass over the mapped file anyway
+    return this->scan_headers(filename, encoding);
 }
 
 
@@ -387,7 +244,7 @@ QList<HeaderOffset*>* PgnReader::scan_headersFromString(QString *contents) {
 
     bool inComment = false;
 
-    QMap<QString,QString> *game_header = new QMap<QString,QString>();
+    PgnHeaders *game_header = new PgnHeaders();
     qint64 game_pos = -1;
 
     QTextStream in(contents);
@@ -444,7 +301,7 @@ QList<HeaderOffset*>* PgnReader::scan_headersFromString(QString *contents) {
 
             header_offsets->append(ho);
             game_pos = -1;
-            game_header = new QMap<QString,QString>();
+            game_header = new PgnHeaders();
         }
 
         last_pos = in.pos();
@@ -458,7 +315,7 @@ QList<HeaderOffset*>* PgnReader::scan_headersFromString(QString *contents) {
 
         header_offsets->append(ho);
         game_pos = -1;
-        game_header = new QMap<QString,QString>();
+        game_header = new PgnHeaders();
     }
 
     return header_offsets;
@@ -481,8 +338,28 @@ Game* PgnReader::readGameFromString(QString *pgn_string, quint64 offset) {
 }
 
 
+Game* PgnReader::readGameFromBytes(const char* bytes, qint64 length, const char* encoding) {
+
+    QTextCodec *codec = QTextCodec::codecForName(encoding);
+    QString pgn = codec->toUnicode(bytes, length);
+    QTextStream in(&pgn);
+    return this->readGame(in);
+}
+
+Game* PgnReader::readLazyGameFromBytes(const char* bytes, qint64 length, const char* encoding) {
+
+    Game *g = new Game();
+    HeaderCollector collector(g->headers);
+    this->visitGameFromBytes(bytes, length, encoding, &collector);
+    g->setLazyPgn(QByteArray(bytes, length), encoding);
+    return g;
+}
+
 Game* PgnReader::readGameFromFile(const QString &filename, const char* encoding, qint64 offset) {
 
+    if(PgnDecompressor::detect(filename) != COMPRESSION_NONE) {
+        return this->readCompressedGame(filename, encoding, offset);
+    }
     QFile file(filename);
 
     if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -498,22 +375,92 @@ Game* PgnReader::readGameFromFile(const QString &filename, const char* encoding,
         chess::Game *g = this->readGame(in);
         file.close();
         return g;
-    } catch(std::invalid_argument e) {
-        qDebug() << "stuff happened";
+    } catch(const std::invalid_argument &) {
         file.close();
-        throw e;
+        throw;
     }
 }
 
+Game* PgnReader::readCompressedGame(const QString &filename, const char* encoding, qint64 offset) {
+
+    // w/o the game's length (cf. PgnIndex), decompress from the
+    // start until the next game starts
+    PgnDecompressor decompressor(filename);
+    if(!decompressor.seek(offset, QList<PgnCheckpoint>())) {
+        throw std::invalid_argument("offset is beyond the end of the file");
+    }
+    // decompress until the next game starts
+    QByteArray pgn;
+    const qint64 chunk = 64 * 1024;
+    qint64 n = 0;
+    do {
+        qint64 size = pgn.size();
+        pgn.resize(size + chunk);
+        n = decompressor.read(pgn.data() + size, chunk);
+        pgn.resize(size + n);
+        PgnScanner scanner(pgn.constData(), pgn.size());
+        if(n > 0 && scanner.resync(qMax(size, qint64(1))) < pgn.size()) {
+            break;
+        }
+    } while(n > 0);
+    return this->readGameFromBytes(pgn.constData(), pgn.size(), encoding);
+}
+
 Game* PgnReader::readGame(QTextStream& in) {
 
-    //qDebug() << "read game 1";
-    Game* g = new Game();
-    QString starting_fen = QString("");
+    GameBuilder builder;
+    this->visitGame(in, &builder);
+    return builder.takeGame();
+}
 
-    QStack<GameNode*> *game_stack = new QStack<GameNode*>();
-    game_stack->push(g->getRootNode());
-    GameNode* current = g->getRootNode();
+void PgnReader::visitGameFromBytes(const char* bytes, qint64 length, const char* encoding, PgnVisitor *visitor) {
+
+    QTextCodec *codec = QTextCodec::codecForName(encoding);
+    QString pgn = codec->toUnicode(bytes, length);
+    QTextStream in(&pgn);
+    this->visitGame(in, visitor);
+}
+
+/**
+ * @brief MoveLine the working board of the reader and the moves of the
+ *        line that is currently read, as they are applied to the board.
+ *        A variation takes back the last move of the line, which is kept
+ *        and played again when the variation ends. The board is owned.
+ */
+struct MoveLine
+{
+    Board *board;
+    QVector<Move> moves;
+    // for each open variation: length of the line
+    // and the move that was replaced by the variation
+    QStack<int> savedLength;
+    QStack<Move> savedMove;
+
+    MoveLine() {
+        this->board = 0;
+    }
+
+    void apply(const Move &m) {
+        this->board->apply(m);
+        this->moves.append(m);
+    }
+
+    void truncate(int length) {
+        while(this->moves.size() > length) {
+            this->board->undo();
+            this->moves.removeLast();
+        }
+    }
+
+    ~MoveLine() {
+        delete this->board;
+    }
+};
+
+void PgnReader::visitGame(QTextStream& in, PgnVisitor *visitor) {
+
+    QString starting_fen = QString("");
+    MoveLine line_moves;
 
     QString line = in.readLine();
     //qDebug() << "line @ offset: " << line;
@@ -528,7 +475,7 @@ Game* PgnReader::readGame(QTextStream& in) {
         if(match_t.hasMatch()) {
             QString tag = match_t.captured(1);
             QString value = match_t.captured(2);
-            g->headers->insert(tag,value);
+            visitor->onHeader(tag, value);
             if(tag == QString("FEN")) {
                 starting_fen = value;
             }
@@ -538,18 +485,28 @@ Game* PgnReader::readGame(QTextStream& in) {
 
         line = in.readLine();
     }
+    if(!visitor->onHeadersEnd()) {
+        return;
+    }
     //qDebug() << "tags ok";
     // set starting fen, if available
+    Board *root = 0;
     if(!starting_fen.isEmpty()) {
-        chess::Board *b_fen = new chess::Board(starting_fen);
-        if(!b_fen->is_consistent()) {
-            if(b_fen != 0) {
-                delete b_fen;
-            }
+        root = new chess::Board(starting_fen);
+        if(!root->is_consistent()) {
+            delete root;
             throw std::invalid_argument("starting fen position is not consistent");
-        } else {
-            current->setBoard(b_fen);
         }
+    } else {
+        root = new chess::Board(true);
+    }
+    if(visitor->onPosition(root)) {
+        // the visitor keeps the starting position, play on a copy
+        char fen[FEN_BUFFER_SIZE];
+        int length = root->write_fen(fen);
+        line_moves.board = new Board(fen, length);
+    } else {
+        line_moves.board = root;
     }
     //qDebug() << "initial board ok";
     // Get the next non-empty line.
@@ -568,20 +525,19 @@ Game* PgnReader::readGame(QTextStream& in) {
         }
         bool readNextLine = true;
         if(line.trimmed().isEmpty() && foundContent) {
-            delete game_stack;
-            return g;
+            return;
         }
-        QRegularExpressionMatchIterator i = MOVETEXT_REGEX.globalMatch(line);
-        while (i.hasNext()) {
-            QRegularExpressionMatch match = i.next();
-            QString token = match.captured(0);
-            // qDebug() << token;
-            if(token.startsWith("%")) {
+        PgnTokenizer tokenizer(line);
+        PgnToken t;
+        while (tokenizer.next(&t)) {
+            const QChar *chars = tokenizer.data() + t.offset;
+            // qDebug() << QString(chars, t.length);
+            if(t.type == TOKEN_ESCAPE) {
                 line = in.readLine();
                 continue;
             }
-            if(token.startsWith("{")) {
-                line = token.remove(0,1);
+            if(t.type == TOKEN_COMMENT) {
+                line = line.mid(t.offset + 1);
                 QStringList *comment_lines = new QStringList();
                 // get comments - possibly over multiple lines
                 // qDebug() << "line after token cut: " << line;
@@ -607,7 +563,7 @@ Game* PgnReader::readGame(QTextStream& in) {
                     line = QString("");
                 }
                 QString comment_joined = comment_lines->join(QString("\n"));
-                current->setComment(comment_joined);
+                visitor->onComment(comment_joined);
                 // if the line didn't end with }, we don't want to read the next line yet
                 if(!line.trimmed().isEmpty()) {
                     readNextLine = false;
@@ -615,103 +571,85 @@ Game* PgnReader::readGame(QTextStream& in) {
                 delete comment_lines;
                 break;
             }
-            else if(token.startsWith("$")) {
+            else if(t.type == TOKEN_NAG) {
                 // found a nag
-                int nag = token.remove(0,1).toInt();
-                current->addNag(nag);
-            }
-            else if(token == QString("?")) {
-                current->addNag(NAG_MISTAKE);
-            }
-            else if(token == QString("??")) {
-                current->addNag(NAG_BLUNDER);
-            }
-            else if(token == QString("!")) {
-                current->addNag(NAG_GOOD_MOVE);
-            }
-            else if(token == QString("!!")) {
-                current->addNag(NAG_BRILLIANT_MOVE);
-            }
-            else if(token == QString("!?")) {
-                current->addNag(NAG_SPECULATIVE_MOVE);
-            }
-            else if(token == QString("?!")) {
-                current->addNag(NAG_DUBIOUS_MOVE);
-            }
-            else if(token == QString("(")) {
-                // put current node on stack, so that we don't forget it.
-                game_stack->push(current);
-                current = current->getParent();
-            }
-            else if(token == QString(")")) {
-                // pop from stack. but always leave root
-                if(game_stack->size() > 1) {
-                    current = game_stack->pop();
+                qint64 nag = 0;
+                for(int j=1;j<t.length && nag <= INT_MAX;j++) {
+                    nag = nag * 10 + chars[j].digitValue();
+                }
+                // out of range, as with QString::toInt()
+                if(nag > INT_MAX) {
+                    nag = 0;
                 }
+                visitor->onNag(int(nag));
             }
-            else if(token == QString("1-0")) {
-                g->setResult(RES_WHITE_WINS);
-                foundContent = true;
+            else if(t.type == TOKEN_SUFFIX) {
+                ushort c0 = chars[0].unicode();
+                ushort c1 = t.length > 1 ? chars[1].unicode() : 0;
+                if(c0 == '?' && c1 == 0) {
+                    visitor->onNag(NAG_MISTAKE);
+                }
+                else if(c0 == '?' && c1 == '?') {
+                    visitor->onNag(NAG_BLUNDER);
+                }
+                else if(c0 == '!' && c1 == 0) {
+                    visitor->onNag(NAG_GOOD_MOVE);
+                }
+                else if(c0 == '!' && c1 == '!') {
+                    visitor->onNag(NAG_BRILLIANT_MOVE);
+                }
+                else if(c0 == '!' && c1 == '?') {
+                    visitor->onNag(NAG_SPECULATIVE_MOVE);
+                }
+                else if(c0 == '?' && c1 == '!') {
+                    visitor->onNag(NAG_DUBIOUS_MOVE);
+                }
             }
-            else if(token == QString("0-1")) {
-                g->setResult(RES_BLACK_WINS);
-                foundContent = true;
+            else if(t.type == TOKEN_VARIATION_START) {
+                // the variation replaces the last move, i.e. continue
+                // from the position before. not possible w/o a move
+                if(!line_moves.moves.isEmpty()) {
+                    line_moves.savedLength.push(line_moves.moves.size());
+                    line_moves.savedMove.push(line_moves.moves.last());
+                    line_moves.truncate(line_moves.moves.size() - 1);
+                    visitor->onVariationStart();
+                }
             }
-            else if(token == QString("1/2-1/2")) {
-                g->setResult(RES_DRAW);
-                foundContent = true;
+            else if(t.type == TOKEN_VARIATION_END) {
+                // back to the line before the variation. but always leave root
+                if(!line_moves.savedLength.isEmpty()) {
+                    line_moves.truncate(line_moves.savedLength.pop() - 1);
+                    line_moves.apply(line_moves.savedMove.pop());
+                    visitor->onVariationEnd();
+                }
             }
-            else if(token == QString("*")) {
-                g->setResult(RES_UNDEF);
+            else if(t.type == TOKEN_RESULT) {
+                if(t.length == 1) {
+                    visitor->onResult(RES_UNDEF);
+                } else if(t.length == 7) {
+                    visitor->onResult(RES_DRAW);
+                } else if(chars[0].unicode() == '1') {
+                    visitor->onResult(RES_WHITE_WINS);
+                } else {
+                    visitor->onResult(RES_BLACK_WINS);
+                }
                 foundContent = true;
             }
             else { // this should be a san token
                 foundContent = true;
 
-                // zeros in castling (common bug)
-                if(token==QString("0-0")) {
-                    token = QString("O-O");
-                } else if(token ==QString("0-0-0")) {
-                    token = QString("O-O-O");
-                }
-                Move *m = 0;
-                GameNode *next = new GameNode();
-                Board *b_next = 0;
+                Board *b = line_moves.board;
+                Move m;
                 try {
-                    Board *b = current->getBoard();
-                    //qDebug() << "token: " << token;
-                    m = new Move(b->parse_san(token));
-                    //qDebug() << "uci: " << m->uci_string;
-                    //qDebug() << "san:" << b->san(*m);
-                    //qDebug() << "--";
-                    b_next = b->copy_and_apply(*m);
-                    next->setMove(m);
-                    next->setBoard(b_next);
-                    next->setParent(current);
-                    current->addVariation(next);
-                    current = next;
-                    /*
-                    if(token==QString("O-O-O")) {
-                        Move mtest = b->parse_san(token);
-                        std::cout << "castles, returned: " << +mtest.from << + mtest.to << std::endl;
-                    }*/
+                    // parsed in place, also accepts zeros in castling (common bug)
+                    m = b->parse_san(chars, t.length);
                 }
-                catch(std::invalid_argument a) {
-                    // just silently fail... but first clean up
-                    if(m!=0) {
-                        //delete m;
-                    }
-                    //delete next;
-                    if(b_next!=0) {
-                        //delete b_next;
-                    }
-                    qDebug() << "error catch";
-                    delete g;
-                    game_stack->clear();
-                    delete game_stack;
-                    std::cout << a.what() << std::endl;
-                    throw std::invalid_argument("unable to parse game fen@ " + token.toStdString());
+                catch(const std::invalid_argument &e) {
+                    throw std::invalid_argument("unable to parse move " + QString(chars, t.length).toStdString()
+                                                + ": " + e.what());
                 }
+                visitor->onMove(b, m);
+                line_moves.apply(m);
             }
         }
         if(readNextLine) {
@@ -719,8 +657,5 @@ Game* PgnReader::readGame(QTextStream& in) {
         }
     }
     //qDebug() << "standard return";
-    game_stack->clear();
-    delete game_stack;
-    return g;
 }
 }
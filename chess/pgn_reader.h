@@ -22,13 +22,12 @@
 #define PGN_READER_H
 
 #include <QTextStream>
+#include <QRegularExpression>
 #include "game.h"
 
 namespace chess {
 
 const QRegularExpression TAG_REGEX = QRegularExpression("\\[([A-Za-z0-9]+)\\s+\"(.*)\"\\]");
-const QRegularExpression MOVETEXT_REGEX =
-QRegularExpression("(%.*?[\n\r])|(\{.*)|(\\$[0-9]+)|(\\()|(\\))|(\\*|1-0|0-1|1/2-1/2)|([NBKRQ]?[a-h]?[1-8]?[\\-x]?[a-h][1-8](?:=?[nbrqNBRQ])?|--|O-O(?:-O)?|0-0(?:-0)?)|([\?!]{1,2})");
 
 const int NAG_NULL = 0;
 
@@ -69,10 +68,13 @@ const int NAG_BLACK_HAS_ATTACK = 41;
 const int NAG_WHITE_MODERATE_COUNTERPLAY = 132;
 const int NAG_BLACK_MODERATE_COUNTERPLAY = 133;
 
+class PgnVisitor;
+class HeaderFilter;
+
 struct HeaderOffset
 {
     qint64 offset;
-    QMap<QString, QString>* headers;
+    PgnHeaders* headers;
 };
 
 class PgnReader
@@ -106,12 +108,43 @@ public:
      * @brief readGameFromFile read the game at supplied offset from the PGN filename
      *                throws std::invalid_argument if impossible to read from
      *                that PGN or if the offset leads to an invalid position.
+     *                Compressed files (cf. PgnDecompressor) are decompressed
+     *                from the start; to read single games of them, see
+     *                PgnIndex::checkpoints() and PgnDecompressor::readAt()
      * @param filename name of the file
-     * @param offset integer denoting the offset position to seek to prior reading the file
+     * @param offset integer denoting the offset position to seek to prior reading
+     *               the file (in the decompressed data for compressed files)
      * @return pointer to generated game
      */
     Game* readGameFromFile(const QString &filename, const char* encoding, qint64 offset);
 
+    /**
+     * @brief readGameFromBytes reads the (first) game from a raw, still
+     *                encoded chunk of a PGN file, e.g. a game span of a
+     *                memory mapped file (cf. PgnScanner). Reentrant, i.e.
+     *                can be called from several threads at once.
+     *                throws std::invalid_argument if impossible to read
+     *                a valid game
+     * @param bytes pointer to the first byte of the game
+     * @param length number of bytes
+     * @param encoding encoding of the bytes, see detect_encoding
+     * @return pointer to generated game
+     */
+    Game* readGameFromBytes(const char* bytes, qint64 length, const char* encoding);
+
+    /**
+     * @brief readLazyGameFromBytes like readGameFromBytes, but only reads the
+     *                headers. The game keeps a copy of the bytes, and the
+     *                movetext is parsed on first access to the game tree
+     *                (cf. Game::setLazyPgn). Errors in the movetext are thus
+     *                only reported then.
+     * @param bytes pointer to the first byte of the game
+     * @param length number of bytes
+     * @param encoding encoding of the bytes, see detect_encoding
+     * @return pointer to generated game, with headers only
+     */
+    Game* readLazyGameFromBytes(const char* bytes, qint64 length, const char* encoding);
+
     QList<HeaderOffset*>* scan_headers_fast(const QString &filename, const char* encoding);
 
     int readNextHeader(const QString &filename, const char* encoding,
@@ -152,6 +185,27 @@ public:
      */
     Game* readGame(QTextStream& in);
 
+    /**
+     * @brief visitGame reads a game from supplied textstream, and reports
+     *                  its contents to the visitor instead of building a
+     *                  Game tree. throws std::invalid_argument if the game
+     *                  can not be read (as readGame does)
+     * @param in the textstream to read from
+     * @param visitor receives headers, moves, comments etc.
+     */
+    void visitGame(QTextStream& in, PgnVisitor *visitor);
+
+    /**
+     * @brief visitGameFromBytes same as visitGame, but reads the (first)
+     *                  game from a raw chunk of a PGN file
+     *                  (cf. readGameFromBytes)
+     * @param bytes pointer to the first byte of the game
+     * @param length number of bytes
+     * @param encoding encoding of the bytes, see detect_encoding
+     * @param visitor receives headers, moves, comments etc.
+     */
+    void visitGameFromBytes(const char* bytes, qint64 length, const char* encoding, PgnVisitor *visitor);
+
     /**
      * @brief scan_headers scans a PGN file, reads the headers and
      *         remembers the offsets on which the games start. skips
@@ -161,6 +215,17 @@ public:
      */
     QList<HeaderOffset*>* scan_headers(const QString &filename, const char* encoding);
 
+    /**
+     * @brief scan_headers same as above, but only returns the games whose
+     *         headers match the supplied filter. The filter is evaluated on
+     *         the raw tag values of the file, i.e. nothing of other games is
+     *         decoded.
+     * @param filename name of the PGN file
+     * @param filter header filter
+     * @return list of headers and offset pairs of the matching games
+     */
+    QList<HeaderOffset*>* scan_headers(const QString &filename, const char* encoding, const HeaderFilter *filter);
+
     /**
      * @brief scan_headersFromString scans a PGN string, reads the headers and
      *         remembers the offsets on which the games start. skips
@@ -172,6 +237,8 @@ public:
 
 private:
 
+    // decompresses a compressed file from the start up to the game at offset
+    Game* readCompressedGame(const QString &filename, const char* encoding, qint64 offset);
 
 };
 
@@ -0,0 +1,374 @@
+#include "pgn_scanner.h"
+#include "structural_scan.h"
+#include "pgn_decompressor.h"
+#include <QTextCodec>
+#include <cstring>
+#include <QtAlgorithms>
+
+chess::PgnScanner::PgnScanner(const QString &filename) {
+
+    this->bytes = 0;
+    this->fileSize = 0;
+    this->opened = false;
+    this->pos = 0;
+    this->rangeEnd = 0;
+    this->inComment = false;
+    this->lookaheadValid = false;
+    this->syncPoint = 0;
+    this->decompressor = 0;
+    this->windowOffset = 0;
+    this->keepFrom = 0;
+
+    this->file.setFileName(filename);
+    if(!this->file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    this->opened = true;
+    this->fileSize = this->file.size();
+    if(PgnDecompressor::detect(filename) != COMPRESSION_NONE) {
+        // compressed files are decompressed chunk by chunk while
+        // scanning, cf. fill()
+        this->file.close();
+        this->decompressor = new PgnDecompressor(filename);
+        this->bytes = this->buffer.constData();
+        this->fileSize = 0;
+    } else if(this->fileSize > 0) {
+        uchar *mapped = this->file.map(0, this->fileSize);
+        if(mapped != 0) {
+            this->bytes = reinterpret_cast<const char*>(mapped);
+        } else {
+            // e.g. pipes or special files that can't be mapped
+            this->buffer = this->file.readAll();
+            this->bytes = this->buffer.constData();
+            this->fileSize = this->buffer.size();
+        }
+    }
+    this->rangeEnd = this->fileSize;
+}
+
+chess::PgnScanner::PgnScanner(const char *data, qint64 size) {
+
+    this->bytes = data;
+    this->fileSize = size;
+    this->opened = true;
+    this->pos = 0;
+    this->rangeEnd = size;
+    this->inComment = false;
+    this->lookaheadValid = false;
+    this->syncPoint = 0;
+    this->decompressor = 0;
+    this->windowOffset = 0;
+    this->keepFrom = 0;
+}
+
+chess::PgnScanner::~PgnScanner() {
+    // unmaps automatically
+    this->file.close();
+    delete this->decompressor;
+}
+
+bool chess::PgnScanner::isOpen() {
+    return this->opened;
+}
+
+const char* chess::PgnScanner::data() {
+    return this->bytes;
+}
+
+qint64 chess::PgnScanner::size() {
+    return this->fileSize;
+}
+
+bool chess::PgnScanner::hasNext() {
+    if(!this->lookaheadValid) {
+        this->lookaheadValid = this->findGame(&this->lookahead);
+    }
+    return this->lookaheadValid;
+}
+
+chess::GameSpan chess::PgnScanner::next() {
+    this->hasNext();
+    GameSpan current = this->lookahead;
+    // the game stays in the window of a compressed file until the next call
+    this->keepFrom = current.offset;
+    // a game extends until the next one starts
+    this->lookaheadValid = this->findGame(&this->lookahead);
+    if(this->lookaheadValid) {
+        current.length = this->lookahead.offset - current.offset;
+    } else {
+        current.length = this->windowOffset + this->rangeEnd - current.offset;
+    }
+    return current;
+}
+
+void chess::PgnScanner::setRange(qint64 begin, qint64 end) {
+    this->pos = begin;
+    this->rangeEnd = end;
+    this->inComment = false;
+    this->lookaheadValid = false;
+}
+
+qint64 chess::PgnScanner::resync(qint64 offset) {
+
+    if(offset <= 0) {
+        return 0;
+    }
+    const char *end = this->bytes + this->fileSize;
+    const char *p = this->bytes + offset;
+    // move to the beginning of the next line
+    if(p[-1] != '\n') {
+        p = this->lineEnd(p, end) + 1;
+    }
+    bool prevEmpty = false;
+    if(p < end) {
+        // check the line before
+        const char *q = p - 1;
+        prevEmpty = true;
+        while(q > this->bytes && q[-1] != '\n') {
+            q--;
+            if(*q != ' ' && *q != '\t' && *q != '\r') {
+                prevEmpty = false;
+                break;
+            }
+        }
+    }
+    while(p < end) {
+        const char *eol = this->lineEnd(p, end);
+        if(prevEmpty && *p == '[' && this->isTagLine(p, eol) && !this->isInComment(p)) {
+            this->syncPoint = p - this->bytes;
+            return this->syncPoint;
+        }
+        prevEmpty = true;
+        for(const char *c = p; c < eol; c++) {
+            if(*c != ' ' && *c != '\t' && *c != '\r') {
+                prevEmpty = false;
+                break;
+            }
+        }
+        p = eol + 1;
+    }
+    return this->fileSize;
+}
+
+bool chess::PgnScanner::isInComment(const char *p) {
+
+    // same state as findGame() tracks: p is inside a comment if the last
+    // brace before it opens one. Braces on escaped lines don't count. The
+    // search ends at the last boundary that was found outside a comment
+    const char *begin = this->bytes;
+    if(this->syncPoint <= p - this->bytes) {
+        begin += this->syncPoint;
+    }
+    const char *c = p;
+    while(c > begin) {
+        c--;
+        if(*c != '{' && *c != '}') {
+            continue;
+        }
+        const char *lineStart = c;
+        while(lineStart > this->bytes && lineStart[-1] != '\n') {
+            lineStart--;
+        }
+        if(*lineStart == '%') {
+            c = lineStart;
+            continue;
+        }
+        return *c == '{';
+    }
+    return false;
+}
+
+const char* chess::PgnScanner::lineEnd(const char *p, const char *end) {
+    const char *nl = static_cast<const char*>(memchr(p, '\n', end - p));
+    return nl == 0 ? end : nl;
+}
+
+bool chess::PgnScanner::isTagLine(const char *p, const char *end) {
+
+    // [Tag "value"], cf. TAG_REGEX
+    if(p >= end || *p != '[') {
+        return false;
+    }
+    p++;
+    const char *tagStart = p;
+    while(p < end && ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9'))) {
+        p++;
+    }
+    if(p == tagStart) {
+        return false;
+    }
+    const char *wsStart = p;
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\f' || *p == '\v')) {
+        p++;
+    }
+    if(p == wsStart || p >= end || *p != '"') {
+        return false;
+    }
+    p++;
+    for(; p + 1 < end; p++) {
+        if(p[0] == '"' && p[1] == ']') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool chess::PgnScanner::findGame(GameSpan *span) {
+
+    if(this->decompressor == 0) {
+        return this->findGameInWindow(span);
+    }
+    // decompress more until the tag section of the next game is complete,
+    // i.e. until it ends before the end of the decompressed data
+    while(true) {
+        qint64 start = this->windowOffset + this->pos;
+        bool inComment = this->inComment;
+        bool found = this->findGameInWindow(span);
+        if(found && span->offset + span->headerLength < this->windowOffset + this->fileSize) {
+            return true;
+        }
+        if(!this->fill()) {
+            return found;
+        }
+        // scan the same bytes again, now with more data after them
+        this->pos = start - this->windowOffset;
+        this->inComment = inComment;
+    }
+}
+
+bool chess::PgnScanner::fill() {
+
+    // drop the data before the game that was returned last, and
+    // append the next chunk of decompressed data
+    const qint64 chunk = 4 * 1024 * 1024;
+    qint64 drop = this->keepFrom - this->windowOffset;
+    if(drop > 0) {
+        this->buffer.remove(0, int(drop));
+        this->windowOffset += drop;
+        this->pos -= drop;
+    }
+    qint64 size = this->buffer.size();
+    this->buffer.resize(int(size + chunk));
+    qint64 n = this->decompressor->read(this->buffer.data() + size, chunk);
+    this->buffer.resize(int(size + n));
+    this->bytes = this->buffer.constData();
+    this->fileSize = this->buffer.size();
+    this->rangeEnd = this->fileSize;
+    return n > 0;
+}
+
+bool chess::PgnScanner::findGameInWindow(GameSpan *span) {
+
+    const char *end = this->bytes + this->rangeEnd;
+    const char *p = this->bytes + this->pos;
+
+    // first seek until we have new tags. Instead of looking at every byte,
+    // only line breaks and comment braces are visited (cf. StructuralScan)
+    const char *gameStart = 0;
+    const char *line = p;
+    bool lineChecked = false;
+    bool skipLine = false;
+    const char *lastOpen = 0;
+    const char *lastClose = 0;
+    const char *block = p;
+    quint64 mask = StructuralScan::structuralMask(block, end);
+    while(line < end) {
+        if(!lineChecked) {
+            if(*line == '%') {
+                // escape mechanism, skip line
+                skipLine = true;
+            } else if(!this->inComment && *line == '[' && this->isTagLine(line, this->lineEnd(line, end))) {
+                gameStart = line;
+                break;
+            }
+            lineChecked = true;
+        }
+        while(mask == 0 && block + 64 < end) {
+            block += 64;
+            mask = StructuralScan::structuralMask(block, end);
+        }
+        if(mask == 0) {
+            break;
+        }
+        const char *c = block + qCountTrailingZeroBits(mask);
+        mask &= mask - 1;
+        if(*c == '{') {
+            lastOpen = c;
+        } else if(*c == '}') {
+            lastClose = c;
+        } else {
+            // track multi-line comments, so that a line starting with '['
+            // inside a comment is not mistaken as the start of a new game
+            if(!skipLine && ((!this->inComment && lastOpen != 0) || (this->inComment && lastClose != 0))) {
+                this->inComment = lastOpen > lastClose;
+            }
+            line = c + 1;
+            lastOpen = 0;
+            lastClose = 0;
+            skipLine = false;
+            lineChecked = false;
+        }
+    }
+    if(gameStart == 0) {
+        this->pos = this->rangeEnd;
+        return false;
+    }
+    p = gameStart;
+    end = this->bytes + this->fileSize;
+    // tag section ends at the first line not starting with '['
+    while(p < end && *p == '[') {
+        p = this->lineEnd(p, end) + 1;
+    }
+    if(p > end) {
+        p = end;
+    }
+    span->offset = this->windowOffset + (gameStart - this->bytes);
+    span->headerLength = p - gameStart;
+    span->length = span->headerLength;
+    this->pos = p - this->bytes;
+    return true;
+}
+
+chess::PgnHeaders* chess::PgnScanner::readHeaders(const GameSpan &span, const char* encoding) {
+
+    PgnHeaders *game_header = new PgnHeaders();
+    this->readHeaders(span, encoding, game_header);
+    game_header->detach();
+    return game_header;
+}
+
+void chess::PgnScanner::readHeaders(const GameSpan &span, const char* encoding, PgnHeaders *headers) {
+
+    headers->clear();
+    // values are stored relative to the tag section of the
+    // game, so that they fit even far into multi-GB files
+    const char *p = this->bytes + (span.offset - this->windowOffset);
+    headers->setSource(p, encoding);
+    headers->setRosterDefaults();
+
+    const char *end = p + span.headerLength;
+    while(p < end) {
+        const char *eol = this->lineEnd(p, end);
+        if(this->isTagLine(p, eol)) {
+            const char *tagStart = p + 1;
+            const char *tagEnd = tagStart;
+            while(*tagEnd != ' ' && *tagEnd != '\t' && *tagEnd != '\r'
+                  && *tagEnd != '\f' && *tagEnd != '\v') {
+                tagEnd++;
+            }
+            const char *valueStart = tagEnd;
+            while(*valueStart != '"') {
+                valueStart++;
+            }
+            valueStart++;
+            // value is greedy, i.e. extends to the last "]
+            const char *valueEnd = eol - 2;
+            while(!(valueEnd[0] == '"' && valueEnd[1] == ']')) {
+                valueEnd--;
+            }
+            int tag = PgnHeaders::tagId(tagStart, tagEnd - tagStart);
+            headers->setSpan(tag, valueStart, valueEnd - valueStart);
+        }
+        p = eol + 1;
+    }
+}
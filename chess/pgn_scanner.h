@@ -0,0 +1,170 @@
+#ifndef PGN_SCANNER_H
+#define PGN_SCANNER_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QMap>
+#include "pgn_headers.h"
+
+namespace chess {
+
+class PgnDecompressor;
+
+/**
+ * @brief GameSpan locates one game inside a PGN file. All values
+ *        are byte offsets / byte counts into the raw file.
+ */
+struct GameSpan
+{
+    qint64 offset;        // first byte of the game's tag section
+    qint64 headerLength;  // number of bytes covered by the tag section
+    qint64 length;        // number of bytes until the next game starts (or eof)
+};
+
+class PgnScanner
+{
+
+public:
+
+    /**
+     * @brief PgnScanner maps the supplied PGN file into memory (falls back
+     *                   to reading it into memory if mapping fails) and
+     *                   walks the raw bytes to find game boundaries. The file
+     *                   is opened exactly once. Compressed files (cf.
+     *                   PgnDecompressor) are decompressed in chunks while
+     *                   scanning, and only the data from the last game
+     *                   returned by next() on is kept in memory. Such a
+     *                   scanner is sequential only (no setRange() or
+     *                   resync()), and hasNext() and next() throw
+     *                   std::invalid_argument if the data is corrupt.
+     * @param filename name of the PGN file
+     */
+    PgnScanner(const QString &filename);
+
+    /**
+     * @brief PgnScanner scans a PGN file that is already in memory. The
+     *                   buffer is not copied and must outlive the scanner.
+     * @param data first byte of the PGN data
+     * @param size size of the data in bytes
+     */
+    PgnScanner(const char *data, qint64 size);
+    ~PgnScanner();
+
+    /**
+     * @brief isOpen checks whether the file could be opened
+     * @return true if the file is available for scanning
+     */
+    bool isOpen();
+
+    /**
+     * @brief hasNext checks whether there is another game left
+     * @return true if next() will return another game
+     */
+    bool hasNext();
+
+    /**
+     * @brief next returns the span of the next game and advances the scanner.
+     *             only call if hasNext() returned true.
+     * @return location of the game in the file
+     */
+    GameSpan next();
+
+    /**
+     * @brief setRange restricts scanning to games that start within
+     *                 [begin, end). The last game of the range is assumed
+     *                 to extend up to end. Resets the scanner state.
+     * @param begin byte offset to start scanning from
+     * @param end byte offset to stop scanning at
+     */
+    void setRange(qint64 begin, qint64 end);
+
+    /**
+     * @brief resync finds the first game boundary at or after the supplied
+     *               offset without scanning from the start of the file: the
+     *               first tag line that starts a tag section, i.e. that is
+     *               preceded by an empty line (or the start of the file), and
+     *               that is not inside a multi-line comment. The comment state
+     *               is found by looking back to the last brace, at most up to
+     *               the boundary found by the previous call, so a parallel
+     *               parse splits the file into the same games as next() does.
+     * @param offset arbitrary byte offset
+     * @return offset of the game boundary, or size() if there is none
+     */
+    qint64 resync(qint64 offset);
+
+    /**
+     * @brief readHeaders decodes the tag section of the supplied game. The
+     *                    seven tag roster is always present (initialized with
+     *                    the PGN defaults if missing). Caller takes ownership.
+     * @param span the game, as returned by next()
+     * @param encoding encoding of the file, see PgnReader::detect_encoding
+     * @return headers of the game (not referring to the scanner's data)
+     */
+    PgnHeaders* readHeaders(const GameSpan &span, const char* encoding);
+
+    /**
+     * @brief readHeaders same as above, but reuses the supplied headers, and
+     *                    doesn't copy or decode any value: the values refer
+     *                    to the data of the scanner (cf. PgnHeaders::setSpan)
+     * @param span the game, as returned by next()
+     * @param encoding encoding of the file, see PgnReader::detect_encoding
+     * @param headers cleared, and then receives the tags of the game
+     */
+    void readHeaders(const GameSpan &span, const char* encoding, PgnHeaders *headers);
+
+    /**
+     * @brief data pointer to the raw bytes of the whole file. For compressed
+     *             files, these are just the bytes decompressed so far.
+     * @return pointer to the first byte (valid as long as the scanner lives)
+     */
+    const char* data();
+
+    /**
+     * @brief size size of the file in bytes
+     * @return file size
+     */
+    qint64 size();
+
+    /**
+     * @brief isTagLine checks if the line starting at p is a PGN tag
+     *                  pair, i.e. [Tag "value"] (cf. TAG_REGEX)
+     * @param p first byte of the line
+     * @param end one past the last byte of the line (w/o line break)
+     * @return true if the line is a tag pair
+     */
+    static bool isTagLine(const char *p, const char *end);
+
+private:
+
+    QFile file;
+    QByteArray buffer;
+    const char *bytes;
+    qint64 fileSize;
+    bool opened;
+
+    qint64 pos;
+    qint64 rangeEnd;
+    bool inComment;
+    bool lookaheadValid;
+    GameSpan lookahead;
+    // last boundary found by resync()
+    qint64 syncPoint;
+
+    // compressed files: bytes holds the decompressed data starting
+    // at windowOffset, data before keepFrom may be dropped by fill()
+    PgnDecompressor *decompressor;
+    qint64 windowOffset;
+    qint64 keepFrom;
+
+    bool findGame(GameSpan *span);
+    bool findGameInWindow(GameSpan *span);
+    bool fill();
+    bool isInComment(const char *p);
+    const char* lineEnd(const char *p, const char *end);
+
+};
+
+}
+
+#endif // PGN_SCANNER_H
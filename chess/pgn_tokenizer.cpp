@@ -0,0 +1,201 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "pgn_tokenizer.h"
+
+namespace chess {
+
+static inline bool isPieceChar(ushort c) {
+    return c == 'N' || c == 'B' || c == 'K' || c == 'R' || c == 'Q';
+}
+
+static inline bool isFileChar(ushort c) {
+    return c >= 'a' && c <= 'h';
+}
+
+static inline bool isRankChar(ushort c) {
+    return c >= '1' && c <= '8';
+}
+
+static inline bool isPromotionChar(ushort c) {
+    return c == 'n' || c == 'b' || c == 'r' || c == 'q'
+            || c == 'N' || c == 'B' || c == 'R' || c == 'Q';
+}
+
+PgnTokenizer::PgnTokenizer(const QString &line) {
+    this->line = line;
+    this->chars = this->line.unicode();
+    this->length = this->line.length();
+    this->pos = 0;
+}
+
+const QChar* PgnTokenizer::data() {
+    return this->chars;
+}
+
+int PgnTokenizer::matchSan(int at) {
+
+    // [NBKRQ]?[a-h]?[1-8]?[\-x]?[a-h][1-8](?:=?[nbrqNBRQ])?
+    // the four optional prefix characters are tried in the same order a
+    // backtracking regex would (take before skip), so that tokens
+    // are split exactly as before
+    const QChar *c = this->chars;
+    int end = this->length;
+    for(int skip=0;skip<16;skip++) {
+        int p = at;
+        if(!(skip & 8)) {
+            if(p >= end || !isPieceChar(c[p].unicode())) { continue; }
+            p++;
+        }
+        if(!(skip & 4)) {
+            if(p >= end || !isFileChar(c[p].unicode())) { continue; }
+            p++;
+        }
+        if(!(skip & 2)) {
+            if(p >= end || !isRankChar(c[p].unicode())) { continue; }
+            p++;
+        }
+        if(!(skip & 1)) {
+            if(p >= end || (c[p].unicode() != '-' && c[p].unicode() != 'x')) { continue; }
+            p++;
+        }
+        if(p + 1 >= end || !isFileChar(c[p].unicode()) || !isRankChar(c[p+1].unicode())) {
+            continue;
+        }
+        p += 2;
+        if(p + 1 < end && c[p].unicode() == '=' && isPromotionChar(c[p+1].unicode())) {
+            p += 2;
+        } else if(p < end && isPromotionChar(c[p].unicode())) {
+            p++;
+        }
+        return p - at;
+    }
+    return 0;
+}
+
+bool PgnTokenizer::next(PgnToken *token) {
+
+    const QChar *c = this->chars;
+    int end = this->length;
+    while(this->pos < end) {
+        int at = this->pos;
+        ushort ch = c[at].unicode();
+        int len = 0;
+        int type = -1;
+        switch(ch) {
+        case '%':
+            for(int p=at+1;p<end;p++) {
+                if(c[p].unicode() == '\n' || c[p].unicode() == '\r') {
+                    len = p + 1 - at;
+                    type = TOKEN_ESCAPE;
+                    break;
+                }
+            }
+            break;
+        case '{':
+            len = end - at;
+            type = TOKEN_COMMENT;
+            break;
+        case '$':
+            len = 1;
+            while(at + len < end && c[at+len].unicode() >= '0' && c[at+len].unicode() <= '9') {
+                len++;
+            }
+            if(len > 1) {
+                type = TOKEN_NAG;
+            }
+            break;
+        case '(':
+            len = 1;
+            type = TOKEN_VARIATION_START;
+            break;
+        case ')':
+            len = 1;
+            type = TOKEN_VARIATION_END;
+            break;
+        case '*':
+            len = 1;
+            type = TOKEN_RESULT;
+            break;
+        case '!':
+        case '?':
+            len = 1;
+            if(at + 1 < end && (c[at+1].unicode() == '!' || c[at+1].unicode() == '?')) {
+                len = 2;
+            }
+            type = TOKEN_SUFFIX;
+            break;
+        case '-':
+            len = this->matchSan(at);
+            if(len == 0 && at + 1 < end && c[at+1].unicode() == '-') {
+                len = 2;
+            }
+            if(len > 0) {
+                type = TOKEN_SAN;
+            }
+            break;
+        case 'O':
+        case '0':
+            if(ch == '0' && at + 2 < end && c[at+1].unicode() == '-' && c[at+2].unicode() == '1') {
+                len = 3;
+                type = TOKEN_RESULT;
+            } else if(at + 2 < end && c[at+1].unicode() == '-' && c[at+2].unicode() == ch) {
+                len = 3;
+                if(at + 4 < end && c[at+3].unicode() == '-' && c[at+4].unicode() == ch) {
+                    len = 5;
+                }
+                type = TOKEN_SAN;
+            }
+            break;
+        case '1':
+            if(at + 2 < end && c[at+1].unicode() == '-' && c[at+2].unicode() == '0') {
+                len = 3;
+                type = TOKEN_RESULT;
+            } else if(at + 6 < end && c[at+1].unicode() == '/' && c[at+2].unicode() == '2'
+                      && c[at+3].unicode() == '-' && c[at+4].unicode() == '1'
+                      && c[at+5].unicode() == '/' && c[at+6].unicode() == '2') {
+                len = 7;
+                type = TOKEN_RESULT;
+            } else {
+                len = this->matchSan(at);
+                if(len > 0) {
+                    type = TOKEN_SAN;
+                }
+            }
+            break;
+        default:
+            len = this->matchSan(at);
+            if(len > 0) {
+                type = TOKEN_SAN;
+            }
+        }
+        if(type >= 0) {
+            token->type = type;
+            token->offset = at;
+            token->length = len;
+            this->pos = at + len;
+            return true;
+        }
+        this->pos++;
+    }
+    return false;
+}
+
+}
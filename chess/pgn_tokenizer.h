@@ -0,0 +1,93 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef PGN_TOKENIZER_H
+#define PGN_TOKENIZER_H
+
+#include <QString>
+
+namespace chess {
+
+// % escape, up to the next line break
+const int TOKEN_ESCAPE = 0;
+// { up to the end of the line
+const int TOKEN_COMMENT = 1;
+// $ followed by digits
+const int TOKEN_NAG = 2;
+const int TOKEN_VARIATION_START = 3;
+const int TOKEN_VARIATION_END = 4;
+// *, 1-0, 0-1 or 1/2-1/2
+const int TOKEN_RESULT = 5;
+// a SAN move, null move (--) or castles (O-O, 0-0 ...)
+const int TOKEN_SAN = 6;
+// move suffix annotation !, ?, !!, ??, !? or ?!
+const int TOKEN_SUFFIX = 7;
+
+/**
+ * @brief PgnToken is a view into the tokenized line,
+ *        i.e. no text is copied
+ */
+struct PgnToken
+{
+    int type;
+    int offset;
+    int length;
+};
+
+class PgnTokenizer
+{
+
+public:
+
+    /**
+     * @brief PgnTokenizer splits one line of PGN movetext into tokens.
+     *                     It accepts the same tokens as the former
+     *                     MOVETEXT_REGEX; everything else (move numbers,
+     *                     whitespace, garbage) is skipped.
+     * @param line the line to tokenize (shared, not copied)
+     */
+    PgnTokenizer(const QString &line);
+
+    /**
+     * @brief next finds the next token
+     * @param token set to the next token, if there is one
+     * @return false if the end of the line is reached
+     */
+    bool next(PgnToken *token);
+
+    /**
+     * @brief data the characters the token offsets refer to
+     * @return pointer to the first character of the line
+     */
+    const QChar* data();
+
+private:
+    QString line;
+    const QChar *chars;
+    int length;
+    int pos;
+
+    int matchSan(int at);
+
+};
+
+}
+
+#endif // PGN_TOKENIZER_H
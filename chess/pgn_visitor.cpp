@@ -0,0 +1,117 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "pgn_visitor.h"
+
+namespace chess {
+
+GameBuilder::GameBuilder() {
+    this->game = new Game();
+    this->ownsGame = true;
+    this->current = this->game->getRootNode();
+    this->game_stack = new QStack<GameNode*>();
+    this->game_stack->push(this->current);
+}
+
+GameBuilder::GameBuilder(Game *game) {
+    this->game = game;
+    this->ownsGame = false;
+    this->current = this->game->getRootNode();
+    this->game_stack = new QStack<GameNode*>();
+    this->game_stack->push(this->current);
+}
+
+GameBuilder::~GameBuilder() {
+    // game wasn't taken, e.g. due to a parse error
+    if(this->ownsGame) {
+        delete this->game;
+    }
+    this->game_stack->clear();
+    delete this->game_stack;
+}
+
+Game* GameBuilder::takeGame() {
+    Game *g = this->game;
+    this->game = 0;
+    return g;
+}
+
+void GameBuilder::onHeader(const QString &tag, const QString &value) {
+    // headers of a lazy game are already read
+    if(this->ownsGame) {
+        this->game->headers->insert(tag, value);
+    }
+}
+
+void GameBuilder::onMove(Board *board, const Move &move) {
+    Q_UNUSED(board);
+    GameNode *next = new (this->game->getArena()) GameNode();
+    next->setMove(move);
+    next->setParent(this->current);
+    this->current->addVariation(next);
+    this->current = next;
+}
+
+bool GameBuilder::onPosition(Board *board) {
+    // the starting position, the nodes compute
+    // their boards from the moves on demand
+    this->current->setBoard(board);
+    return true;
+}
+
+void GameBuilder::onComment(const QString &comment) {
+    QString c = comment;
+    this->current->setComment(c);
+}
+
+void GameBuilder::onNag(int nag) {
+    this->current->addNag(nag);
+}
+
+void GameBuilder::onVariationStart() {
+    // put current node on stack, so that we don't forget it.
+    this->game_stack->push(this->current);
+    this->current = this->current->getParent();
+}
+
+void GameBuilder::onVariationEnd() {
+    // pop from stack. but always leave root
+    if(this->game_stack->size() > 1) {
+        this->current = this->game_stack->pop();
+    }
+}
+
+void GameBuilder::onResult(int result) {
+    this->game->setResult(result);
+}
+
+HeaderCollector::HeaderCollector(PgnHeaders *headers) {
+    this->headers = headers;
+}
+
+void HeaderCollector::onHeader(const QString &tag, const QString &value) {
+    this->headers->insert(tag, value);
+}
+
+bool HeaderCollector::onHeadersEnd() {
+    return false;
+}
+
+}
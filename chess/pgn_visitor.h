@@ -0,0 +1,170 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef PGN_VISITOR_H
+#define PGN_VISITOR_H
+
+#include <QString>
+#include <QStack>
+#include "board.h"
+#include "move.h"
+#include "game.h"
+#include "game_node.h"
+
+namespace chess {
+
+/**
+ * @brief PgnVisitor receives the contents of a PGN game while it
+ *        is read (cf. PgnReader::visitGame), without a Game tree being
+ *        built. All callbacks do nothing by default, so a visitor only
+ *        overrides what it needs.
+ */
+class PgnVisitor
+{
+
+public:
+    virtual ~PgnVisitor() {}
+
+    /**
+     * @brief onHeader called for each tag pair, in the order of the file
+     */
+    virtual void onHeader(const QString &tag, const QString &value) { Q_UNUSED(tag); Q_UNUSED(value); }
+
+    /**
+     * @brief onHeadersEnd called after the last tag pair
+     * @return false to stop reading, i.e. to skip the movetext
+     */
+    virtual bool onHeadersEnd() { return true; }
+
+    /**
+     * @brief onMove called for each move (main line and variations)
+     * @param board position before the move. Owned by the reader, which plays
+     *              the whole game on this one board, i.e. it is only valid
+     *              during the call and must not be changed
+     * @param move the move that is played
+     */
+    virtual void onMove(Board *board, const Move &move) { Q_UNUSED(board); Q_UNUSED(move); }
+
+    /**
+     * @brief onPosition called once with the starting position of the game,
+     *                   before the first move. The visitor can take over
+     *                   ownership of the board by returning true. The reader
+     *                   then plays the game on a copy. Later positions are
+     *                   only passed to onMove()
+     * @param board the position
+     * @return true if the visitor takes ownership of the board
+     */
+    virtual bool onPosition(Board *board) { Q_UNUSED(board); return false; }
+
+    /**
+     * @brief onComment called for each comment, after the move it belongs to
+     */
+    virtual void onComment(const QString &comment) { Q_UNUSED(comment); }
+
+    /**
+     * @brief onNag called for each nag (also for suffixes like !? or ??),
+     *              after the move it belongs to
+     */
+    virtual void onNag(int nag) { Q_UNUSED(nag); }
+
+    /**
+     * @brief onVariationStart called at the start of a variation. The next
+     *                         move is an alternative to the last move.
+     */
+    virtual void onVariationStart() {}
+
+    /**
+     * @brief onVariationEnd called at the end of a variation. Play continues
+     *                       after the move that was replaced by the variation.
+     */
+    virtual void onVariationEnd() {}
+
+    /**
+     * @brief onResult called for the game termination marker
+     * @param result RES_WHITE_WINS, RES_BLACK_WINS, RES_DRAW or RES_UNDEF
+     */
+    virtual void onResult(int result) { Q_UNUSED(result); }
+
+};
+
+/**
+ * @brief GameBuilder is the visitor behind PgnReader::readGame. It
+ *        builds the complete Game tree.
+ */
+class GameBuilder : public PgnVisitor
+{
+
+public:
+    GameBuilder();
+
+    /**
+     * @brief GameBuilder builds the tree into an existing, empty game
+     *                    (cf. Game::setLazyPgn). The headers of the game
+     *                    are kept, and the game is not deleted by the builder.
+     */
+    GameBuilder(Game *game);
+    ~GameBuilder();
+
+    /**
+     * @brief takeGame returns the built game. Caller takes ownership.
+     */
+    Game* takeGame();
+
+    void onHeader(const QString &tag, const QString &value);
+    void onMove(Board *board, const Move &move);
+    bool onPosition(Board *board);
+    void onComment(const QString &comment);
+    void onNag(int nag);
+    void onVariationStart();
+    void onVariationEnd();
+    void onResult(int result);
+
+private:
+    Game *game;
+    bool ownsGame;
+    GameNode *current;
+    QStack<GameNode*> *game_stack;
+
+};
+
+/**
+ * @brief HeaderCollector reads only the tag pairs of a game into
+ *        a header map, and skips the movetext.
+ */
+class HeaderCollector : public PgnVisitor
+{
+
+public:
+    /**
+     * @param headers map the tags are inserted into. Not owned
+     */
+    HeaderCollector(PgnHeaders *headers);
+
+    void onHeader(const QString &tag, const QString &value);
+    bool onHeadersEnd();
+
+private:
+    PgnHeaders *headers;
+
+};
+
+}
+
+#endif // PGN_VISITOR_H
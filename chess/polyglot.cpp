@@ -95,8 +95,8 @@ Move Polyglot::moveFromEntry(Entry e) {
     return m;
 }
 
-Moves* Polyglot::findMoves(Board *board) {
-    Moves* bookMoves = new Moves();
+MoveList Polyglot::findMoves(Board *board) {
+    MoveList bookMoves;
     if(this->book != 0 && this->readFile) {
         quint64 zh_board = board->zobrist();
         quint64 low = 0;
@@ -116,13 +116,13 @@ Moves* Polyglot::findMoves(Board *board) {
         quint64 size = this->book->size() / 16;
         // now we have the lowest key pos
         // where a possible entry is. collect all
-        while(offset < size) {
+        while(offset < size && bookMoves.size() < MAX_MOVES) {
             Entry e = this->entryFromOffset(offset*16);
             if(e.key != zh_board) {
                 break;
             }
             Move m = this->moveFromEntry(e);
-            bookMoves->append(m);
+            bookMoves.append(m);
             offset += 1;
         }
     }
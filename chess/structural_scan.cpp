@@ -0,0 +1,103 @@
+#include "structural_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define STRUCTURAL_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled in with a function level target attribute, so that the
+// rest of the program can still run on cpus without AVX2
+#if defined(STRUCTURAL_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define STRUCTURAL_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+typedef quint64 (*StructuralKernel)(const char *block);
+
+static quint64 structuralMaskScalar(const char *block, int n) {
+    quint64 mask = 0;
+    for(int i=0;i<n;i++) {
+        char c = block[i];
+        if(c == '\n' || c == '{' || c == '}') {
+            mask |= quint64(1) << i;
+        }
+    }
+    return mask;
+}
+
+#ifndef STRUCTURAL_SCAN_SSE2
+static quint64 structuralMaskScalar64(const char *block) {
+    return structuralMaskScalar(block, 64);
+}
+#endif
+
+#ifdef STRUCTURAL_SCAN_SSE2
+static quint64 structuralMaskSse2(const char *block) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    quint64 mask = 0;
+    for(int i=0;i<4;i++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, newline),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, open), _mm_cmpeq_epi8(v, close)));
+        mask |= quint64(quint16(_mm_movemask_epi8(hits))) << (16 * i);
+    }
+    return mask;
+}
+#endif
+
+#ifdef STRUCTURAL_SCAN_AVX2
+__attribute__((target("avx2")))
+static quint64 structuralMaskAvx2(const char *block) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    __m256i hitsLo = _mm256_or_si256(_mm256_cmpeq_epi8(lo, newline),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(lo, open), _mm256_cmpeq_epi8(lo, close)));
+    __m256i hitsHi = _mm256_or_si256(_mm256_cmpeq_epi8(hi, newline),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(hi, open), _mm256_cmpeq_epi8(hi, close)));
+    return quint64(quint32(_mm256_movemask_epi8(hitsLo)))
+            | (quint64(quint32(_mm256_movemask_epi8(hitsHi))) << 32);
+}
+#endif
+
+static StructuralKernel selectKernel(const char **name) {
+#ifdef STRUCTURAL_SCAN_AVX2
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return structuralMaskAvx2;
+    }
+#endif
+#ifdef STRUCTURAL_SCAN_SSE2
+    // always available on x86-64
+    *name = "sse2";
+    return structuralMaskSse2;
+#else
+    *name = "scalar";
+    return structuralMaskScalar64;
+#endif
+}
+
+static const char *kernel_name = "scalar";
+
+static StructuralKernel kernel() {
+    // selected once, thread-safe since C++11
+    static const StructuralKernel selected = selectKernel(&kernel_name);
+    return selected;
+}
+
+quint64 chess::StructuralScan::structuralMask(const char *block, const char *end) {
+    if(end - block >= 64) {
+        return kernel()(block);
+    }
+    return structuralMaskScalar(block, int(end - block));
+}
+
+const char* chess::StructuralScan::kernelName() {
+    kernel();
+    return kernel_name;
+}
@@ -0,0 +1,37 @@
+#ifndef STRUCTURAL_SCAN_H
+#define STRUCTURAL_SCAN_H
+
+#include <QtGlobal>
+
+namespace chess {
+
+class StructuralScan
+{
+
+public:
+
+    /**
+     * @brief structuralMask classifies a block of raw PGN bytes. Bit i of
+     *                       the result is set iff block[i] is a line break
+     *                       or a comment brace ('\n', '{' or '}'), i.e. all
+     *                       bits are zero for (most) blocks of movetext and
+     *                       tags. Uses AVX2 or SSE2 if available (checked
+     *                       once at runtime), and plain C++ otherwise.
+     * @param block first byte of the block
+     * @param end one past the last readable byte. If less than 64 bytes
+     *            are available, only those are classified
+     * @return bitmask of the structural characters of the (up to) 64 bytes
+     */
+    static quint64 structuralMask(const char *block, const char *end);
+
+    /**
+     * @brief kernelName name of the kernel selected for this cpu
+     * @return "avx2", "sse2" or "scalar"
+     */
+    static const char* kernelName();
+
+};
+
+}
+
+#endif // STRUCTURAL_SCAN_H
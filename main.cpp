@@ -6,6 +6,12 @@
 #include <QStringList>
 #include <QDebug>
 #include "chess/pgn_reader.h"
+#include "chess/pgn_scanner.h"
+#include "chess/parallel_pgn_reader.h"
+#include "chess/pgn_index.h"
+#include "chess/pgn_decompressor.h"
+#include "chess/pgn_block_reader.h"
+#include "chess/header_filter.h"
 #include "chess/pgn_printer.h"
 #include "chess/dcgencoder.h"
 #include "chess/database.h"
@@ -35,6 +41,28 @@ int main(int argc, char *argv[])
               QCoreApplication::translate("main", "filename."));
     parser.addOption(dbFileOption);
 
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+              QCoreApplication::translate("main", "number of parser threads (default: one per core)."),
+              QCoreApplication::translate("main", "threads."), "0");
+    parser.addOption(jobsOption);
+
+    QCommandLineOption gameOption(QStringList() << "g" << "game",
+              QCoreApplication::translate("main", "only convert game <n> (starting from 1)."),
+              QCoreApplication::translate("main", "n."), "0");
+    parser.addOption(gameOption);
+
+    QCommandLineOption noIndexOption(QStringList() << "no-index",
+              QCoreApplication::translate("main", "don't read or write the game index (<games.pgn>.pgi)."));
+    parser.addOption(noIndexOption);
+
+    QCommandLineOption whereOption(QStringList() << "w" << "where",
+              QCoreApplication::translate("main", "only convert games whose headers match <filter>, e.g. \"WhiteElo>=2500 and ECO^=B9\"."),
+              QCoreApplication::translate("main", "filter."));
+    parser.addOption(whereOption);
+
+    QCommandLineOption tagsOnlyOption(QStringList() << "tags-only",
+              QCoreApplication::translate("main", "only write the tags of the games, without parsing their moves."));
+    parser.addOption(tagsOnlyOption);
 
     parser.process(app);
 
@@ -73,38 +101,96 @@ int main(int argc, char *argv[])
 
     chess::PgnReader *pgnreader = new chess::PgnReader();
 
-    // first scan offsets
-    quint64 offset = 0;
-
     const char* encoding = pgnreader->detect_encoding(pgnFileName);
+    int jobs = parser.value(jobsOption).toInt();
+    int gameNumber = parser.value(gameOption).toInt();
+    // the movetext of lazy games is never parsed, if only their tags are printed
+    bool tagsOnly = parser.isSet(tagsOnlyOption);
+    chess::HeaderFilter *filter = 0;
+    if(parser.isSet(whereOption)) {
+        try {
+            filter = new chess::HeaderFilter(parser.value(whereOption), encoding);
+        } catch(const std::invalid_argument &e) {
+            std::cout << "Error: invalid filter: " << e.what() << std::endl;
+            exit(0);
+        }
+    }
 
-    QList<quint64> *offsets = new QList<quint64>();
-
-    bool stop = false;
-    while(!stop) {
-        chess::HeaderOffset *header = new chess::HeaderOffset();
-        delete header->headers;
-        int res = pgnreader->readNextHeader(pgnFileName, encoding, &offset, header);
-        if(res < 0) {
-            stop = true;
-            delete header;
-            continue;
+    int compression = chess::PgnDecompressor::detect(pgnFileName);
+    if(!chess::PgnDecompressor::isSupported(compression) && compression != chess::COMPRESSION_NONE) {
+        std::cout << "Error: compression format of PGN file not supported." << std::endl;
+        exit(0);
+    }
+    // compressed files are decompressed while they are parsed. a single
+    // game is decompressed from the closest restart point of the index
+    bool compressed = compression != chess::COMPRESSION_NONE;
+    bool streaming = compressed && gameNumber == 0;
+
+    chess::PgnScanner *scanner = 0;
+    if(!compressed) {
+        scanner = new chess::PgnScanner(pgnFileName);
+    }
+    // (re)use the sidecar game index. it is always needed to
+    // locate a single game
+    chess::PgnIndex *index = 0;
+    if((!parser.isSet(noIndexOption) && !streaming) || gameNumber > 0) {
+        index = new chess::PgnIndex(pgnFileName);
+        try {
+            if(compressed) {
+                index->updateCompressed();
+            } else {
+                index->update(scanner);
+            }
+        } catch(const std::invalid_argument &e) {
+            std::cout << "Error: " << e.what() << std::endl;
+            exit(0);
         }
-        offsets->append(header->offset);
-        header->headers->clear();
-        delete header->headers;
-        delete header;
     }
+    if(gameNumber > 0 && gameNumber > index->count()) {
+        std::cout << "Error: PGN file contains only " << index->count() << " games." << std::endl;
+        exit(0);
+    }
+    chess::ParallelPgnReader *reader = 0;
+    chess::PgnBlockReader *blocks = 0;
+    QByteArray block;
     chess::PgnPrinter *pp = new chess::PgnPrinter();
     QFile fOut(dbFileName);
     bool success = false;
     if(fOut.open(QFile::WriteOnly | QFile::Text)) {
         QTextStream s(&fOut);
-        for(int i=0;i<offsets->count();i++) {
-            quint64 offset_i = offsets->at(i);
-            chess::Game *g = pgnreader->readGameFromFile(pgnFileName, encoding, offset_i);
-            //g->headers = header_i->headers;
-            QStringList *pgn = pp->printGame(g);
+        chess::Game *g = 0;
+        if(gameNumber > 0) {
+            chess::GameSpan span = index->at(gameNumber - 1);
+            if(compressed) {
+                chess::PgnDecompressor decompressor(pgnFileName);
+                block = decompressor.readAt(span.offset, span.length, index->checkpoints());
+                scanner = new chess::PgnScanner(block.constData(), block.size());
+                span.offset = 0;
+                span.length = block.size();
+            }
+            chess::PgnHeaders headers;
+            scanner->readHeaders(span, encoding, &headers);
+            if(filter == 0 || filter->matches(headers)) {
+                if(tagsOnly) {
+                    g = pgnreader->readLazyGameFromBytes(scanner->data() + span.offset, span.length, encoding);
+                } else {
+                    g = pgnreader->readGameFromBytes(scanner->data() + span.offset, span.length, encoding);
+                }
+            }
+        } else if(streaming) {
+            // blocks of a compressed file are parsed while
+            // the ones after them are decompressed
+            blocks = new chess::PgnBlockReader(pgnFileName);
+            blocks->start();
+            reader = new chess::ParallelPgnReader(blocks, encoding, jobs, filter, tagsOnly);
+            g = reader->nextGame();
+        } else {
+            // games are returned in file order
+            reader = new chess::ParallelPgnReader(scanner, encoding, jobs, index, filter, tagsOnly);
+            g = reader->nextGame();
+        }
+        while(g != 0) {
+            QStringList *pgn = tagsOnly ? pp->printTags(g) : pp->printGame(g);
             for (int i = 0; i < pgn->size(); ++i) {
                 s << pgn->at(i) << '\n';
             }
@@ -112,6 +198,7 @@ int main(int argc, char *argv[])
             pgn->clear();
             delete pgn;
             s << '\n' << '\n';
+            g = reader != 0 ? reader->nextGame() : 0;
         }
         success = true;
     } else {
@@ -122,8 +209,11 @@ int main(int argc, char *argv[])
         throw std::invalid_argument("Error writing file");
     }
 
-    offsets->clear();
-    delete offsets;
+    delete reader;
+    delete blocks;
+    delete filter;
+    delete index;
+    delete scanner;
     delete pgnreader;
     delete pp;
     return 0;
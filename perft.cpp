@@ -0,0 +1,192 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <iostream>
+#include <iomanip>
+#include "chess/board.h"
+
+// known node counts of positions that exercise castling, en passent,
+// promotions, pins and checks. nodes[i] is the count for depth i+1
+struct PerftPosition
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    quint64 nodes[7];
+};
+
+static const PerftPosition POSITIONS[] = {
+    { "start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+      { 20, 400, 8902, 197281, 4865609, 119060324, 0 } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+      { 48, 2039, 97862, 4085603, 193690690, 0, 0 } },
+    { "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5,
+      { 14, 191, 2812, 43238, 674624, 11030083, 0 } },
+    { "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+      { 6, 264, 9467, 422333, 15833292, 0, 0 } },
+    { "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+      { 44, 1486, 62379, 2103487, 89941194, 0, 0 } },
+    { "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+      { 46, 2079, 89890, 3894594, 164075551, 0, 0 } },
+    { "pinned en passent", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6,
+      { 18, 92, 1670, 10138, 185429, 1134888, 0 } },
+    { "en passent gives check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6,
+      { 15, 126, 1928, 13931, 206379, 1440467, 0 } },
+    { "promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6,
+      { 11, 133, 1442, 19174, 266199, 3821001, 0 } },
+    { "underpromotion", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6,
+      { 6, 27, 273, 1329, 18135, 92683, 0 } },
+    { "castling gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6,
+      { 15, 66, 1198, 6399, 120330, 661072, 0 } },
+    { "castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4,
+      { 26, 1141, 27826, 1274206, 0, 0, 0 } },
+    { "castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4,
+      { 44, 1494, 50509, 1720476, 0, 0, 0 } },
+    { "double check", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4,
+      { 37, 183, 6559, 23527, 0, 0, 0 } },
+};
+
+// counts the leaf nodes of the legal move tree of the supplied depth
+static quint64 perft(chess::Board *board, int depth) {
+    if(depth == 0) {
+        return 1;
+    }
+    chess::MoveList moves;
+    board->legal_moves(&moves);
+    if(depth == 1) {
+        return quint64(moves.size());
+    }
+    quint64 nodes = 0;
+    for(const chess::Move &m : moves) {
+        board->apply(m);
+        nodes += perft(board, depth - 1);
+        board->undo();
+    }
+    return nodes;
+}
+
+// same as perft(), but prints the node count below each move of the root
+static quint64 divide(chess::Board *board, int depth) {
+    chess::MoveList moves;
+    board->legal_moves(&moves);
+    quint64 nodes = 0;
+    for(const chess::Move &m : moves) {
+        board->apply(m);
+        quint64 n = perft(board, depth - 1);
+        board->undo();
+        std::cout << "  " << m.uci().toStdString() << ": " << n << std::endl;
+        nodes += n;
+    }
+    return nodes;
+}
+
+// runs perft on the position, and compares with the expected
+// node count (if not 0). returns false if the counts differ
+static bool run(const QString &name, const QString &fen, int depth, quint64 expected,
+                bool showDivide, quint64 *total) {
+    chess::Board *board = 0;
+    try {
+        board = new chess::Board(fen);
+    } catch(const std::invalid_argument &e) {
+        std::cout << "Error: invalid FEN " << fen.toStdString() << ": " << e.what() << std::endl;
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    quint64 nodes = showDivide && depth > 0 ? divide(board, depth) : perft(board, depth);
+    qint64 ms = timer.elapsed();
+    delete board;
+    *total += nodes;
+    quint64 nps = ms > 0 ? nodes * 1000 / quint64(ms) : nodes * 1000;
+    std::cout << std::left << std::setw(24) << name.toStdString()
+              << " depth " << depth
+              << "  nodes " << std::setw(11) << nodes
+              << " " << std::setw(7) << ms << " ms"
+              << "  " << std::setw(10) << nps << " nodes/sec";
+    bool ok = expected == 0 || nodes == expected;
+    if(expected != 0) {
+        if(ok) {
+            std::cout << "  ok";
+        } else {
+            std::cout << "  FAILED, expected " << expected;
+        }
+    }
+    std::cout << std::endl;
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("perft");
+    QCoreApplication::setApplicationVersion("v1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("counts the nodes of the move tree of chess positions, to check and "
+                                     "time move generation. Without --fen, runs a suite of positions with "
+                                     "known node counts.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption fenOption(QStringList() << "f" << "fen",
+              QCoreApplication::translate("main", "position <fen> instead of the suite."),
+              QCoreApplication::translate("main", "fen."));
+    parser.addOption(fenOption);
+
+    QCommandLineOption depthOption(QStringList() << "d" << "depth",
+              QCoreApplication::translate("main", "search depth (default: per position of the suite, 4 for --fen)."),
+              QCoreApplication::translate("main", "depth."), "0");
+    parser.addOption(depthOption);
+
+    QCommandLineOption expectOption(QStringList() << "e" << "expect",
+              QCoreApplication::translate("main", "expected node count for --fen."),
+              QCoreApplication::translate("main", "nodes."), "0");
+    parser.addOption(expectOption);
+
+    QCommandLineOption divideOption(QStringList() << "divide",
+              QCoreApplication::translate("main", "print the node count below each move of the root."));
+    parser.addOption(divideOption);
+
+    parser.process(app);
+
+    int depth = parser.value(depthOption).toInt();
+    bool showDivide = parser.isSet(divideOption);
+    if(depth < 0) {
+        std::cout << "Error: depth must not be negative." << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    if(parser.isSet(fenOption)) {
+        quint64 expected = parser.value(expectOption).toULongLong();
+        quint64 total = 0;
+        ok = run(QString("fen"), parser.value(fenOption), depth > 0 ? depth : 4, expected, showDivide, &total);
+    } else {
+        quint64 total = 0;
+        QElapsedTimer timer;
+        timer.start();
+        int count = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+        for(int i=0;i<count;i++) {
+            const PerftPosition &p = POSITIONS[i];
+            int d = depth > 0 ? depth : p.depth;
+            // known counts go up to depth 7 at most
+            quint64 expected = d >= 1 && d <= 7 ? p.nodes[d-1] : 0;
+            if(!run(QString(p.name), QString(p.fen), d, expected, showDivide, &total)) {
+                ok = false;
+            }
+        }
+        qint64 ms = timer.elapsed();
+        std::cout << "total " << ms << " ms";
+        if(ms > 0) {
+            std::cout << ", " << total * 1000 / quint64(ms) << " nodes/sec";
+        }
+        std::cout << std::endl;
+    }
+    if(!ok) {
+        std::cout << "perft FAILED" << std::endl;
+        return 1;
+    }
+    return 0;
+}
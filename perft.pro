@@ -0,0 +1,23 @@
+QT += core
+QT -= gui
+
+CONFIG += c++11
+
+TARGET = perft
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+# move generator benchmark and regression check, see perft.cpp
+
+SOURCES += perft.cpp \
+    chess/bitboard.cpp \
+    chess/board.cpp \
+    chess/move.cpp
+
+HEADERS += \
+    chess/bitboard.h \
+    chess/board.h \
+    chess/move.h \
+    chess/move_list.h
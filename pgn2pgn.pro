@@ -9,7 +9,21 @@ CONFIG -= app_bundle
 
 TEMPLATE = app
 
+# compressed PGN input. gzip is always supported, zstd and
+# bzip2 can be disabled with e.g. qmake "CONFIG-=zstd"
+CONFIG += zstd bzip2
+LIBS += -lz
+zstd {
+    DEFINES += PGN_WITH_ZSTD
+    LIBS += -lzstd
+}
+bzip2 {
+    DEFINES += PGN_WITH_BZIP2
+    LIBS += -lbz2
+}
+
 SOURCES += main.cpp \
+    chess/bitboard.cpp \
     chess/board.cpp \
     chess/byteutil.cpp \
     chess/database.cpp \
@@ -17,17 +31,30 @@ SOURCES += main.cpp \
     chess/dcgencoder.cpp \
     chess/ecocode.cpp \
     chess/game.cpp \
+    chess/game_annotations.cpp \
+    chess/game_arena.cpp \
     chess/game_node.cpp \
     chess/gui_printer.cpp \
+    chess/header_filter.cpp \
     chess/indexentry.cpp \
     chess/move.cpp \
     chess/namebase.cpp \
+    chess/parallel_pgn_reader.cpp \
+    chess/pgn_block_reader.cpp \
+    chess/pgn_decompressor.cpp \
+    chess/pgn_headers.cpp \
+    chess/pgn_index.cpp \
     chess/pgn_printer.cpp \
     chess/pgn_reader.cpp \
+    chess/pgn_scanner.cpp \
+    chess/pgn_tokenizer.cpp \
+    chess/pgn_visitor.cpp \
     chess/polyglot.cpp \
-    chess/sitebase.cpp
+    chess/sitebase.cpp \
+    chess/structural_scan.cpp
 
 HEADERS += \
+    chess/bitboard.h \
     chess/board.h \
     chess/byteutil.h \
     chess/database.h \
@@ -35,12 +62,25 @@ HEADERS += \
     chess/dcgencoder.h \
     chess/ecocode.h \
     chess/game.h \
+    chess/game_annotations.h \
+    chess/game_arena.h \
     chess/game_node.h \
     chess/gui_printer.h \
+    chess/header_filter.h \
     chess/indexentry.h \
     chess/move.h \
+    chess/move_list.h \
     chess/namebase.h \
+    chess/parallel_pgn_reader.h \
+    chess/pgn_block_reader.h \
+    chess/pgn_decompressor.h \
+    chess/pgn_headers.h \
+    chess/pgn_index.h \
     chess/pgn_printer.h \
     chess/pgn_reader.h \
+    chess/pgn_scanner.h \
+    chess/pgn_tokenizer.h \
+    chess/pgn_visitor.h \
     chess/polyglot.h \
-    chess/sitebase.h
+    chess/sitebase.h \
+    chess/structural_scan.h
@@ -0,0 +1,71 @@
+QT += core
+QT += gui
+
+CONFIG += c++11
+
+TARGET = tests
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+# same compression options as pgn2pgn.pro
+CONFIG += zstd bzip2
+LIBS += -lz
+zstd {
+    DEFINES += PGN_WITH_ZSTD
+    LIBS += -lzstd
+}
+bzip2 {
+    DEFINES += PGN_WITH_BZIP2
+    LIBS += -lbz2
+}
+
+# unit tests of the chess library, see tests/main.cpp
+
+SOURCES += tests/main.cpp \
+    tests/test_board.cpp \
+    tests/test_game.cpp \
+    tests/test_game_node.cpp \
+    tests/test_header_filter.cpp \
+    tests/test_move.cpp \
+    tests/test_pgn_decompressor.cpp \
+    tests/test_pgn_scanner.cpp \
+    chess/bitboard.cpp \
+    chess/board.cpp \
+    chess/ecocode.cpp \
+    chess/game.cpp \
+    chess/game_annotations.cpp \
+    chess/game_arena.cpp \
+    chess/game_node.cpp \
+    chess/header_filter.cpp \
+    chess/move.cpp \
+    chess/pgn_decompressor.cpp \
+    chess/pgn_headers.cpp \
+    chess/pgn_reader.cpp \
+    chess/pgn_scanner.cpp \
+    chess/pgn_tokenizer.cpp \
+    chess/pgn_visitor.cpp \
+    chess/polyglot.cpp \
+    chess/structural_scan.cpp
+
+HEADERS += \
+    tests/check.h \
+    chess/bitboard.h \
+    chess/board.h \
+    chess/ecocode.h \
+    chess/game.h \
+    chess/game_annotations.h \
+    chess/game_arena.h \
+    chess/game_node.h \
+    chess/header_filter.h \
+    chess/move.h \
+    chess/move_list.h \
+    chess/pgn_decompressor.h \
+    chess/pgn_headers.h \
+    chess/pgn_reader.h \
+    chess/pgn_scanner.h \
+    chess/pgn_tokenizer.h \
+    chess/pgn_visitor.h \
+    chess/polyglot.h \
+    chess/structural_scan.h
@@ -0,0 +1,29 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// number of failed checks of all tests so far
+extern int checkFailures;
+
+// reports a failed condition with its location, and goes on with the test
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " \
+                      << #condition << std::endl; \
+            checkFailures++; \
+        } \
+    } while(0)
+
+void testHeaderFilter();
+void testGameNode();
+void testGame();
+void testLazyGame();
+void testFen();
+void testSan();
+void testMoveEncoding();
+void testScannerResync();
+void testDecompressor();
+
+#endif // CHECK_H
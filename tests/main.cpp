@@ -0,0 +1,40 @@
+#include <QCoreApplication>
+#include <iostream>
+#include "check.h"
+
+int checkFailures = 0;
+
+// unit tests of the chess library, cf. perft for the move generator.
+// Returns 1 if any check fails
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    struct Test {
+        const char *name;
+        void (*run)();
+    };
+    const Test tests[] = {
+        { "header filter", testHeaderFilter },
+        { "game node", testGameNode },
+        { "game", testGame },
+        { "lazy game", testLazyGame },
+        { "fen", testFen },
+        { "san", testSan },
+        { "move encoding", testMoveEncoding },
+        { "scanner resync", testScannerResync },
+        { "decompressor", testDecompressor },
+    };
+
+    int count = sizeof(tests) / sizeof(tests[0]);
+    for(int i=0;i<count;i++) {
+        int before = checkFailures;
+        tests[i].run();
+        std::cout << tests[i].name << ": " << (checkFailures == before ? "ok" : "FAILED") << std::endl;
+    }
+    if(checkFailures > 0) {
+        std::cout << checkFailures << " checks FAILED" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <QString>
+#include <cstring>
+#include <stdexcept>
+#include "check.h"
+#include "chess/board.h"
+
+using namespace chess;
+
+// the perft positions, i.e. castling rights, en passent
+// squares and move numbers other than the defaults
+static const char *FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+    "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1",
+    "8/P1k5/K7/8/8/8/8/8 w - - 0 1",
+    "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1",
+};
+static const int FEN_COUNT = sizeof(FENS) / sizeof(FENS[0]);
+
+// the FEN written for the board reads back into the same position
+static void checkFenRoundTrip(Board *board) {
+    char fen[FEN_BUFFER_SIZE];
+    int length = board->write_fen(fen);
+    CHECK(length == int(strlen(fen)));
+    CHECK(board->fen() == QString::fromLatin1(fen, length));
+    Board copy(fen, length);
+    char again[FEN_BUFFER_SIZE];
+    CHECK(copy.write_fen(again) == length && strcmp(fen, again) == 0);
+    CHECK(copy.legal_moves().size() == board->legal_moves().size());
+}
+
+// every legal move is written in SAN, and parsed back into the same move
+static void checkSanRoundTrip(Board *board) {
+    MoveList moves;
+    board->legal_moves(&moves);
+    for(const Move &m : moves) {
+        char san[SAN_BUFFER_SIZE];
+        int length = board->write_san(m, san);
+        CHECK(length > 0 && length == int(strlen(san)));
+        QString s = QString::fromLatin1(san, length);
+        CHECK(board->san(m) == s);
+        CHECK(board->parse_san(s) == m);
+        CHECK(board->parse_san(s.constData(), s.length()) == m);
+    }
+}
+
+// calls check for every position up to the supplied depth
+static void walk(Board *board, int depth, void (*check)(Board *)) {
+    check(board);
+    if(depth == 0) {
+        return;
+    }
+    MoveList moves;
+    board->legal_moves(&moves);
+    for(const Move &m : moves) {
+        board->apply(m);
+        walk(board, depth - 1, check);
+        board->undo();
+    }
+}
+
+void testFen() {
+    for(int i=0;i<FEN_COUNT;i++) {
+        Board board(FENS[i], int(strlen(FENS[i])));
+        CHECK(board.fen() == QString(FENS[i]));
+        Board fromString{QString(FENS[i])};
+        CHECK(fromString.fen() == QString(FENS[i]));
+        walk(&board, 2, checkFenRoundTrip);
+    }
+    const char *invalid[] = { "", "8/8/8 w - - 0 1", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+                              "rnbqkbnr/pppppppp/44/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w GAha - 0 1",
+                              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w HAhe - 0 1",
+                              "r3k2r/8/8/8/8/8/8/R3K1R1 w HA - 0 1",
+                              "r3k2r/8/8/8/8/8/8/R3K1RR w GA - 0 1" };
+    for(const char *fen : invalid) {
+        bool threw = false;
+        try {
+            Board board(fen, int(strlen(fen)));
+        } catch(const std::invalid_argument &) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+    // castling rights given as the files of the rooks (Shredder-FEN, X-FEN)
+    const char *files[][2] = {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w HAha - 0 1", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" },
+        { "r3k2r/8/8/8/8/8/8/R3K2R b Hq - 0 1", "r3k2r/8/8/8/8/8/8/R3K2R b Kq - 0 1" },
+        { "r3k2r/8/8/8/8/8/8/R3K2R w Aa - 0 1", "r3k2r/8/8/8/8/8/8/R3K2R w Qq - 0 1" },
+    };
+    for(int i=0;i<int(sizeof(files) / sizeof(files[0]));i++) {
+        try {
+            Board board(files[i][0], int(strlen(files[i][0])));
+            CHECK(board.fen() == QString(files[i][1]));
+        } catch(const std::invalid_argument &) {
+            CHECK(false);
+        }
+    }
+}
+
+void testSan() {
+    for(int i=0;i<FEN_COUNT;i++) {
+        Board board(FENS[i], int(strlen(FENS[i])));
+        walk(&board, 2, checkSanRoundTrip);
+    }
+    // castling, also with zeros, disambiguation and promotion
+    Board board(QString("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"));
+    CHECK(board.parse_san(QString("O-O")) == Move(E1, G1));
+    CHECK(board.parse_san(QString("0-0-0")) == Move(E1, C1));
+    Board rooks(QString("4k3/8/8/8/8/8/4K3/R6R w - - 0 1"));
+    CHECK(rooks.san(Move(A1, D1)) == QString("Rad1"));
+    CHECK(rooks.parse_san(QString("Rhd1")) == Move(H1, D1));
+    Board promotion(QString("8/P1k5/K7/8/8/8/8/8 w - - 0 1"));
+    CHECK(promotion.parse_san(QString("a8=N+")) == Move(A7, A8, KNIGHT));
+    CHECK(promotion.san(Move(A7, A8, QUEEN)) == QString("a8=Q"));
+}
@@ -0,0 +1,52 @@
+#include <QString>
+#include <stdexcept>
+#include "check.h"
+#include "chess/game.h"
+#include "chess/pgn_reader.h"
+
+using namespace chess;
+
+static void play(Game *game, const char *moves[], int count) {
+    for(int i=0;i<count;i++) {
+        game->applyMove(Move(QString(moves[i])));
+    }
+}
+
+void testGame() {
+    // the start position occurs the third time after eight plies
+    const char *shuffle[] = { "g1f3", "g8f6", "f3g1", "f6g8",
+                              "g1f3", "g8f6", "f3g1", "f6g8" };
+    Game repetition;
+    play(&repetition, shuffle, 4);
+    CHECK(repetition.getPositionResult() == RES_UNDEF);
+    play(&repetition, shuffle + 4, 4);
+    CHECK(repetition.getPositionResult() == RES_DRAW);
+    // one move earlier it is only the second time
+    repetition.goToParent();
+    CHECK(repetition.getPositionResult() == RES_UNDEF);
+
+    const char *foolsMate[] = { "f2f3", "e7e5", "g2g4", "d8h4" };
+    Game mate;
+    play(&mate, foolsMate, 4);
+    CHECK(mate.getPositionResult() == RES_BLACK_WINS);
+    CHECK(mate.getResult() == RES_UNDEF);
+}
+
+void testLazyGame() {
+    const char *pgn = "[White \"A\"]\n[Black \"B\"]\n\n1. e4 e5 2. Ke3 *\n";
+    PgnReader reader;
+    Game *game = reader.readLazyGameFromBytes(pgn, qstrlen(pgn), "UTF-8");
+    CHECK(!game->isParsed());
+    CHECK(game->headers->value("White") == "A");
+    CHECK(!game->isParsed());
+    // the illegal move is only found once the tree is accessed
+    bool threw = false;
+    try {
+        game->getRootNode();
+    } catch(const std::invalid_argument &) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(game->getRootNode()->isLeaf());
+    delete game;
+}
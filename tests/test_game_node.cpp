@@ -0,0 +1,93 @@
+#include <QString>
+#include <QThreadPool>
+#include <QRunnable>
+#include "check.h"
+#include "chess/board.h"
+#include "chess/game.h"
+#include "chess/game_node.h"
+
+using namespace chess;
+
+// knights go back and forth, so the line can be arbitrarily long
+static const char *SHUFFLE[] = { "g1f3", "g8f6", "f3g1", "f6g8" };
+
+static const int PLIES = 3 * CHECKPOINT_INTERVAL;
+
+static QString fenOf(Board *board) {
+    char fen[FEN_BUFFER_SIZE];
+    int length = board->write_fen(fen);
+    return QString::fromLatin1(fen, length);
+}
+
+// the position after the first plies of the line, computed w/o any node
+static QString expectedFen(const char *startFen, int plies) {
+    Board board(startFen, qstrlen(startFen));
+    for(int i=0;i<plies;i++) {
+        board.apply(Move(QString(SHUFFLE[i % 4])));
+    }
+    return fenOf(&board);
+}
+
+// computes the board of a node on a thread of the pool, i.e.
+// with the board cache of that thread
+class BoardTask : public QRunnable
+{
+
+public:
+    BoardTask(GameNode *node, QString *fen) {
+        this->node = node;
+        this->fen = fen;
+    }
+
+    void run() {
+        *this->fen = fenOf(this->node->getBoard());
+    }
+
+private:
+    GameNode *node;
+    QString *fen;
+};
+
+void testGameNode() {
+    const char *start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    Game game;
+    for(int i=0;i<PLIES;i++) {
+        game.applyMove(Move(QString(SHUFFLE[i % 4])));
+    }
+    GameNode *leaf = game.getEndNode();
+    CHECK(fenOf(leaf->getBoard()) == expectedFen(start, PLIES));
+
+    // the boards of nodes below a changed root follow from it, including
+    // the checkpoints that were computed above
+    const char *noPawn = "rnbqkbnr/pppppppp/8/8/8/8/1PPPPPPP/RNBQKBNR w KQkq - 0 1";
+    game.getRootNode()->setBoard(new Board(noPawn, qstrlen(noPawn)));
+    CHECK(fenOf(leaf->getBoard()) == expectedFen(noPawn, PLIES));
+    CHECK(fenOf(leaf->getParent()->getBoard()) == expectedFen(noPawn, PLIES - 1));
+
+    // a changed move of a leaf changes its (cached) board
+    leaf->setMove(Move(QString("g8h6")));
+    Board *before = leaf->getParent()->getBoard();
+    Board *expected = before->copy_and_apply(Move(QString("g8h6")));
+    CHECK(fenOf(leaf->getBoard()) == fenOf(expected));
+    delete expected;
+
+    // the board that another thread cached for a leaf
+    // (that is not a checkpoint) is outdated as well
+    game.setCurrent(leaf);
+    game.applyMove(Move(QString("b1c3")));
+    leaf = game.getEndNode();
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    QString fen;
+    pool.start(new BoardTask(leaf, &fen));
+    pool.waitForDone();
+    expected = leaf->getParent()->getBoard()->copy_and_apply(Move(QString("b1c3")));
+    CHECK(fen == fenOf(expected));
+    delete expected;
+    leaf->setMove(Move(QString("b1a3")));
+    pool.start(new BoardTask(leaf, &fen));
+    pool.waitForDone();
+    expected = leaf->getParent()->getBoard()->copy_and_apply(Move(QString("b1a3")));
+    CHECK(fen == fenOf(expected));
+    delete expected;
+}
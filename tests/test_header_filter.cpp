@@ -0,0 +1,91 @@
+#include <QFile>
+#include <QDir>
+#include <QByteArray>
+#include "check.h"
+#include "chess/header_filter.h"
+#include "chess/pgn_headers.h"
+#include "chess/pgn_scanner.h"
+
+using namespace chess;
+
+// the empty line ends the (zero) padding before the game
+static const char *GAME =
+        "\n\n"
+        "[Event \"Far away\"]\n"
+        "[Site \"Here\"]\n"
+        "[Date \"2020.01.01\"]\n"
+        "[Round \"1\"]\n"
+        "[White \"A\"]\n"
+        "[Black \"B\"]\n"
+        "[Result \"1-0\"]\n"
+        "[WhiteElo \"2600\"]\n"
+        "\n"
+        "1. e4 e5 1-0\n";
+
+static void checkFilters(const PgnHeaders &headers) {
+    CHECK(HeaderFilter("Site=Here", "UTF-8").matches(headers));
+    CHECK(!HeaderFilter("Site=There", "UTF-8").matches(headers));
+    CHECK(HeaderFilter("White=A and Black=B", "UTF-8").matches(headers));
+    CHECK(HeaderFilter("WhiteElo>=2500 and Date>=2020", "UTF-8").matches(headers));
+    CHECK(!HeaderFilter("WhiteElo<2500", "UTF-8").matches(headers));
+    CHECK(HeaderFilter("Event~away", "UTF-8").matches(headers));
+}
+
+// headers of a game that starts beyond 2 GiB. The file is sparse,
+// so it takes almost no disk space
+static void testFilterBeyond2GiB() {
+    QString filename = QDir::tempPath() + "/jerry_test_2gib.pgn";
+    QFile file(filename);
+    if(!file.open(QFile::WriteOnly)) {
+        CHECK(false);
+        return;
+    }
+    qint64 start = (qint64(1) << 31) + 4096;
+    bool written = file.seek(start) && file.write(GAME, qstrlen(GAME)) == qint64(qstrlen(GAME));
+    file.close();
+    CHECK(written);
+
+    if(written) {
+        PgnScanner scanner(filename);
+        CHECK(scanner.isOpen());
+        scanner.setRange(scanner.resync(start), scanner.size());
+        CHECK(scanner.hasNext());
+        if(scanner.hasNext()) {
+            GameSpan span = scanner.next();
+            CHECK(span.offset > (qint64(1) << 31));
+            PgnHeaders headers;
+            scanner.readHeaders(span, "UTF-8", &headers);
+            CHECK(headers.value(TAG_SITE) == "Here");
+            CHECK(headers.value(TAG_WHITE) == "A");
+            CHECK(headers.value("WhiteElo") == "2600");
+            checkFilters(headers);
+        }
+    }
+    QFile::remove(filename);
+}
+
+static void testFilterSyntax() {
+    const char *invalid[] = { "White=", "(White=A", "=A", "White", "White=\"A", "White=A and",
+                              "White=A or", "not", "White=A )" };
+    for(const char *expression : invalid) {
+        bool threw = false;
+        try {
+            HeaderFilter filter(expression, "UTF-8");
+        } catch(const std::invalid_argument &) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+}
+
+void testHeaderFilter() {
+    PgnScanner scanner(GAME, qstrlen(GAME));
+    CHECK(scanner.hasNext());
+    if(scanner.hasNext()) {
+        PgnHeaders headers;
+        scanner.readHeaders(scanner.next(), "UTF-8", &headers);
+        checkFilters(headers);
+    }
+    testFilterSyntax();
+    testFilterBeyond2GiB();
+}
@@ -0,0 +1,31 @@
+#include <QString>
+#include "check.h"
+#include "chess/board.h"
+
+using namespace chess;
+
+void testMoveEncoding() {
+    const uint8_t promotions[] = { 0, KNIGHT, BISHOP, ROOK, QUEEN };
+    for(int from=0;from<64;from++) {
+        for(int to=0;to<64;to++) {
+            for(uint8_t promotion : promotions) {
+                Move m = Move::from_squares(from, to, promotion);
+                CHECK(m.from_square() == from && m.to_square() == to);
+                CHECK(m.promotion_piece() == promotion);
+                CHECK(m.from() == SQUARE_120[from] && m.to() == SQUARE_120[to]);
+                CHECK(m.encoding() == ((promotion << 12) | (from << 6) | to));
+                CHECK(Move::from_encoding(m.encoding()) == m);
+                CHECK(Move(m.from(), m.to(), promotion) == m);
+                CHECK(m.is_null() == (from == 0 && to == 0 && promotion == 0));
+            }
+        }
+    }
+    CHECK(Move().is_null() && Move().encoding() == 0);
+    // the top bit is not part of the move
+    CHECK(Move::from_encoding(0x8000 | Move(E2, E4).encoding()) == Move(E2, E4));
+    CHECK(Move(QString("e2e4")) == Move(E2, E4));
+    CHECK(Move(QString("e2e4")).uci() == QString("e2e4"));
+    CHECK(Move(QString("a7a8q")) == Move(A7, A8, QUEEN));
+    CHECK(Move(QString("h2h1n")).promotion_piece() == KNIGHT);
+    CHECK(Move(E2, E4) != Move(E2, E3));
+}
@@ -0,0 +1,118 @@
+#include <QFile>
+#include <QDir>
+#include <QByteArray>
+#include <stdexcept>
+#include <zlib.h>
+#ifdef PGN_WITH_ZSTD
+#include <zstd.h>
+#endif
+#include "check.h"
+#include "chess/pgn_decompressor.h"
+#include "chess/pgn_scanner.h"
+
+using namespace chess;
+
+static const char *PGN = "[Event \"One\"]\n\n1. e4 e5 *\n\n[Event \"Two\"]\n\n1. d4 *\n";
+
+static QByteArray gzip(const QByteArray &data) {
+    z_stream z = z_stream();
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    QByteArray out;
+    out.resize(int(deflateBound(&z, data.size())) + 32);
+    z.next_in = (Bytef*) data.constData();
+    z.avail_in = data.size();
+    z.next_out = (Bytef*) out.data();
+    z.avail_out = out.size();
+    deflate(&z, Z_FINISH);
+    out.resize(int(z.total_out));
+    deflateEnd(&z);
+    return out;
+}
+
+// decompresses the whole file, which consists of two members / frames
+// of the PGN and some trailing bytes that must be ignored
+static void checkFile(const QByteArray &compressed, const QByteArray &trailing) {
+    QString filename = QDir::tempPath() + "/jerry_test_decompressor";
+    QFile file(filename);
+    if(!file.open(QFile::WriteOnly)) {
+        CHECK(false);
+        return;
+    }
+    file.write(compressed);
+    file.write(compressed);
+    file.write(trailing);
+    file.close();
+
+    QByteArray expected = QByteArray(PGN) + QByteArray(PGN);
+    try {
+        PgnDecompressor decompressor(filename);
+        QByteArray out;
+        out.resize(expected.size() + 100);
+        qint64 total = 0;
+        qint64 n = 0;
+        do {
+            // small reads, so that members end within a read
+            n = decompressor.read(out.data() + total, qMin(qint64(7), out.size() - total));
+            total += n;
+        } while(n > 0);
+        out.resize(int(total));
+        CHECK(out == expected);
+        CHECK(decompressor.checkpoints().size() == 2);
+    } catch(const std::invalid_argument &) {
+        CHECK(false);
+    }
+    QFile::remove(filename);
+}
+
+// a compressed file is scanned in chunks, and must be split into
+// the same games as the decompressed data, also if a game or a
+// multi-line comment crosses the end of a chunk
+static void checkScanner() {
+    QByteArray pgn;
+    for(int i=0;i<50000;i++) {
+        pgn.append("[Event \"Game ");
+        pgn.append(QByteArray::number(i));
+        pgn.append("\"]\n[White \"A\"]\n\n1. e4 {a comment\n[Event \"Not a game\"]\n} e5 *\n\n");
+    }
+    QString filename = QDir::tempPath() + "/jerry_test_scanner";
+    QFile file(filename);
+    if(!file.open(QFile::WriteOnly)) {
+        CHECK(false);
+        return;
+    }
+    file.write(gzip(pgn));
+    file.close();
+
+    PgnScanner expected(pgn.constData(), pgn.size());
+    PgnScanner scanner(filename);
+    CHECK(scanner.isOpen());
+    int games = 0;
+    bool same = true;
+    while(expected.hasNext() && scanner.hasNext()) {
+        GameSpan a = expected.next();
+        GameSpan b = scanner.next();
+        same = same && a.offset == b.offset && a.headerLength == b.headerLength && a.length == b.length;
+        games++;
+    }
+    CHECK(same);
+    CHECK(games == 50000);
+    CHECK(!expected.hasNext() && !scanner.hasNext());
+    QFile::remove(filename);
+}
+
+void testDecompressor() {
+    checkScanner();
+    QByteArray pgn(PGN);
+    checkFile(gzip(pgn), QByteArray());
+    checkFile(gzip(pgn), QByteArray("garbage\n"));
+#ifdef PGN_WITH_ZSTD
+    QByteArray zst;
+    zst.resize(int(ZSTD_compressBound(pgn.size())));
+    zst.resize(int(ZSTD_compress(zst.data(), zst.size(), pgn.constData(), pgn.size(), 3)));
+    checkFile(zst, QByteArray());
+    checkFile(zst, QByteArray("garbage\n"));
+    checkFile(zst, QByteArray("ab"));
+    // zero padding
+    checkFile(zst, QByteArray(8, 0));
+#endif
+}
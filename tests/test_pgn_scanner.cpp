@@ -0,0 +1,51 @@
+#include <QList>
+#include "check.h"
+#include "chess/pgn_scanner.h"
+
+using namespace chess;
+
+// the comment of the first game contains an empty line followed
+// by a tag pair, which must not be taken as the start of a game
+static const char *PGN =
+        "[Event \"One\"]\n"
+        "[Result \"*\"]\n"
+        "\n"
+        "1. e4 { a comment\n"
+        "\n"
+        "[Event \"Not a game\"]\n"
+        "\n"
+        "still the comment } e5 *\n"
+        "\n"
+        "% escaped { line\n"
+        "\n"
+        "[Event \"Two\"]\n"
+        "[Result \"*\"]\n"
+        "\n"
+        "1. d4 *\n"
+        "\n"
+        "[Event \"Three\"]\n"
+        "[Result \"*\"]\n"
+        "\n"
+        "1. c4 *\n";
+
+void testScannerResync() {
+    qint64 size = qstrlen(PGN);
+    PgnScanner sequential(PGN, size);
+    QList<qint64> starts;
+    while(sequential.hasNext()) {
+        starts.append(sequential.next().offset);
+    }
+    CHECK(starts.size() == 3);
+    // resync finds the next game that the sequential scan finds,
+    // both with increasing offsets on one scanner and on new ones
+    PgnScanner scanner(PGN, size);
+    for(qint64 offset=1;offset<=size;offset++) {
+        qint64 expected = size;
+        for(int i=starts.size()-1;i>=0 && starts.at(i) >= offset;i--) {
+            expected = starts.at(i);
+        }
+        CHECK(scanner.resync(offset) == expected);
+        PgnScanner fresh(PGN, size);
+        CHECK(fresh.resync(offset) == expected);
+    }
+}